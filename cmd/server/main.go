@@ -8,6 +8,7 @@ import (
 	"os/signal"
 	"path/filepath"
 	"syscall"
+	"time"
 
 	"github.com/aigoflow/inference-service/internal/config"
 	"github.com/aigoflow/inference-service/internal/llama"
@@ -16,6 +17,7 @@ import (
 	"github.com/aigoflow/inference-service/internal/repository"
 	"github.com/aigoflow/inference-service/internal/services"
 	"github.com/aigoflow/inference-service/internal/store"
+	"github.com/aigoflow/inference-service/internal/vectorindex"
 	"github.com/aigoflow/inference-service/pkg/server"
 )
 
@@ -163,14 +165,59 @@ func main() {
 		}
 	}
 
+	// Completion cache for text generation models, with a semantic tier when an
+	// embedding worker is configured
+	cacheEnabled := cfg.DeterministicCache || cfg.CompletionCache
+	if llamaModel, ok := llm.(*llama.Model); ok && cacheEnabled && !llamaModel.IsEmbeddingModel() && !llamaModel.IsRerankModel() {
+		var embed services.PromptEmbedder
+		if cfg.CompletionCache && cfg.CacheEmbedSubject != "" && natsService != nil {
+			embed = services.NewNATSPromptEmbedder(natsService.GetConnection(), cfg.CacheEmbedSubject, 2*time.Second)
+		}
+		completionCache := services.NewCompletionCache(cfg, embed)
+		inferenceService.SetCompletionCache(completionCache)
+		if healthService != nil {
+			healthService.SetCompletionCache(completionCache)
+		}
+		slog.Info("Completion cache enabled",
+			"sampled", cfg.CompletionCache,
+			"ttl", cfg.CacheTTL,
+			"max_bytes", cfg.CacheMaxBytes,
+			"max_temperature", cfg.CacheMaxTemperature,
+			"embed_subject", cfg.CacheEmbedSubject)
+	}
+
 	// Start HTTP server - pass appropriate service and repository
 	httpServer := server.NewServer(cfg.HTTPAddr, inferenceService, grammarService, llm, repo)
 	if audioService != nil {
 		httpServer.SetAudioService(audioService)
 	}
 	
+	// Optional in-process vector index for embedding models. Each worker owns a replica
+	// directory of its own, workers sharing DATA_DIR never write the same files.
+	var indexService *services.IndexService
+	if llamaModel, ok := llm.(*llama.Model); ok && cfg.VectorIndex && llamaModel.IsEmbeddingModel() {
+		indexDir := filepath.Join(cfg.DataDir, "indexes", cfg.ModelName)
+		indexStore, err := vectorindex.OpenReplica(indexDir)
+		if err != nil {
+			slog.Error("Failed to open vector index", "dir", indexDir, "error", err)
+			os.Exit(1)
+		}
+		defer indexStore.Close()
+		
+		indexService = services.NewIndexService(llamaModel, indexStore, repo)
+		httpServer.SetIndexService(indexService)
+		if natsService != nil {
+			natsService.SetIndexService(indexService)
+		}
+		slog.Info("Vector index enabled", "dir", indexStore.Dir(), "subject", cfg.IndexSubject, "applied", indexStore.Applied())
+	}
+	
 	ctx, cancel := context.WithCancel(context.Background())
 	defer cancel()
+	
+	if indexService != nil {
+		go indexService.FlushEvery(ctx, cfg.IndexFlush)
+	}
 
 	// Log server ready
 	db.Event("info", "server.ready", "Server ready to accept requests", map[string]interface{}{
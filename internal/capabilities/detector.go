@@ -39,6 +39,16 @@ func (d *AutoCapabilityDetector) DetectCapabilities(model ModelInterface) []Capa
 		slog.Debug("Detected embeddings capability", "dimension", model.GetEmbeddingSize())
 	}
 
+	// Check reranking capability (cross-encoder served with rank pooling)
+	if model.HasCapability(string(CapabilityRerank)) {
+		capabilities = append(capabilities, Capability{
+			Type:        CapabilityRerank,
+			Version:     "1.0",
+			Description: "Rerank documents by relevance to a query",
+		})
+		slog.Debug("Detected rerank capability")
+	}
+
 	// Check multimodal capabilities
 	modalities := model.GetSupportedModalities()
 	for _, modality := range modalities {
@@ -185,6 +195,8 @@ func (d *AutoCapabilityDetector) GetCapabilitiesSummary(capabilities []Capabilit
 		switch cap.Type {
 		case CapabilityTextGeneration:
 			summary = append(summary, "Text Generation")
+		case CapabilityRerank:
+			summary = append(summary, "Rerank")
 		case CapabilityEmbeddings:
 			if dim, ok := cap.Parameters["dimension"].(int); ok && dim > 0 {
 				summary = append(summary, fmt.Sprintf("Embeddings (%dD)", dim))
@@ -6,6 +6,7 @@ type CapabilityType string
 const (
 	CapabilityTextGeneration     CapabilityType = "text-generation"
 	CapabilityEmbeddings         CapabilityType = "embeddings"
+	CapabilityRerank             CapabilityType = "rerank"
 	CapabilityImageGeneration    CapabilityType = "image-generation"
 	CapabilityImageUnderstanding CapabilityType = "image-understanding"
 	CapabilityAudioGeneration    CapabilityType = "audio-generation"
@@ -33,9 +34,24 @@ type ModelMetadata struct {
 	EmbeddingSize   int                    `json:"embedding_size,omitempty"`
 	Quantization    string                 `json:"quantization,omitempty"`
 	ModelFamily     string                 `json:"model_family,omitempty"`
+	Compute         *ComputeInfo           `json:"compute,omitempty"`
 	Additional      map[string]interface{} `json:"additional,omitempty"`
 }
 
+// ComputeInfo describes the backends and devices the model runs on, found at runtime
+type ComputeInfo struct {
+	Devices     []ComputeDevice `json:"devices"`
+	CPUFeatures []string        `json:"cpu_features,omitempty"` // SIMD kernels of the CPU backend in use, e.g. AVX2
+}
+
+type ComputeDevice struct {
+	Name        string `json:"name"`
+	Description string `json:"description"`
+	Backend     string `json:"backend"`
+	Type        string `json:"type"` // cpu, gpu, igpu or accel
+	MemoryTotal uint64 `json:"memory_total,omitempty"`
+}
+
 // ModelInterface defines the interface for model introspection
 type ModelInterface interface {
 	// Existing embedding methods
@@ -14,6 +14,8 @@ type Config struct {
 	NatsURL         string
 	Stream          string
 	Subject         string
+	ScoreSubject    string
+	CancelSubject   string // Requests to stop a generation by req_id, empty to disable
 	Durable         string
 	QueueGroup      string
 	ResponsePrefix  string
@@ -23,6 +25,8 @@ type Config struct {
 	MaxDeliver      int
 	MaxAckPending   int
 	Concurrency     int
+	ResultBucket    string // Key-value bucket of recent responses replayed on redelivery, empty to disable
+	ResultTTL       time.Duration
 	
 	// HTTP Configuration
 	HTTPAddr string
@@ -31,13 +35,43 @@ type Config struct {
 	ModelName      string
 	ModelURL       string
 	ModelPath      string
-	ModelFormat    string  // "standard", "harmony", "chatml", etc.
+	ModelFormat    string  // "standard", "harmony", "chatml", "embedding", "rerank", etc.
+	PoolingType    string  // Embedding pooling: "mean", "cls", "last", "rank" or "none", empty for the format default
 	Threads        int
 	CtxSize        int
+	Executors      int     // Native threads running generations, 0 to run them on cgo calls
+	
+	// Compute Configuration
+	BackendDir        string // Where dynamically built ggml backends are loaded from, empty for the executable's directory
+	SharedThreadpool  bool   // All contexts compute on one CPU threadpool, one decode at a time
+	ThreadpoolThreads int    // Threads of the shared pool, 0 for the physical cores
+	ThreadpoolPoll    int    // Busy-wait level of idle pool threads, 0-100
 	
 	// Format-Specific Configuration
 	FormatConfig map[string]interface{}
 	
+	// Embedding Configuration
+	EmbedChunkOverlap int    // Token overlap between context windows of over-long inputs
+	VectorIndex       bool   // Serve collections from an in-process vector index under DATA_DIR/indexes
+	IndexSubject      string // Prefix of the index upsert and search subjects
+	IndexStream       string // JetStream stream of the upsert log every replica applies
+	IndexFlush        time.Duration // Interval at which changed collections are snapshotted
+	
+	// Completion Cache Configuration
+	DeterministicCache  bool // Serve repeated greedy completions from memory and share identical ones in flight
+	CompletionCache     bool // Also cache low-temperature sampled completions and enable the semantic tier
+	CacheTTL            time.Duration
+	CacheMaxBytes       int
+	CacheMaxTemperature float64 // Requests sampled hotter than this are never cached
+	CacheEmbedSubject   string  // Embedding worker subject for the semantic tier, empty for exact match only
+	CacheSimilarity     float64 // Minimum cosine similarity of a semantic hit
+	
+	// Admission Control Configuration
+	AdmissionControl    bool          // Delay or reject requests that cannot finish before their deadline
+	AdmissionTokens     int           // KV tokens running requests may reserve, 0 for WORKER_CONCURRENCY * CTX_SIZE
+	AdmissionRetryDelay time.Duration // Redelivery delay of requests held back for KV room
+	RequestDeadline     time.Duration // Time after publishing by which a request must be answered
+	
 	// Data Directory Configuration
 	DataDir string
 	
@@ -62,6 +96,8 @@ func Load(envFile string) (*Config, error) {
 		NatsURL:        getEnv("NATS_URL", "nats://127.0.0.1:5700"),
 		Stream:         getEnv("STREAM_NAME", "INFER"),
 		Subject:        getEnv("SUBJECT", "inference.request.default"),
+		ScoreSubject:   getEnv("SCORE_SUBJECT", "score.request.default"),
+		CancelSubject:  getEnv("CANCEL_SUBJECT", "inference.cancel.default"),
 		Durable:        getEnv("QUEUE_DURABLE", "infer-wq"),
 		QueueGroup:     getEnv("QUEUE_GROUP", "workers"),
 		ResponsePrefix: getEnv("RESPONSE_PREFIX", "inference.reply"),
@@ -71,19 +107,51 @@ func Load(envFile string) (*Config, error) {
 		MaxDeliver:     getEnvInt("MAX_DELIVER", 5),
 		MaxAckPending:  getEnvInt("MAX_ACK_PENDING", 64),
 		Concurrency:    getEnvInt("WORKER_CONCURRENCY", 2),
+		ResultBucket:   getEnv("RESULT_BUCKET", "INFER_RESULTS"),
+		ResultTTL:      getEnvDuration("RESULT_TTL", "5m"),
 		HTTPAddr:       getEnv("HTTP_ADDR", ":8081"),
 		ModelName:      getEnv("MODEL_NAME", "default"),
 		ModelURL:       getEnv("MODEL_URL", ""),
 		ModelPath:      getEnv("MODEL_PATH", "data/models/model.gguf"),
 		ModelFormat:    getEnv("MODEL_FORMAT", "standard"),
+		PoolingType:    getEnv("POOLING_TYPE", ""),
 		Threads:        getEnvInt("MODEL_THREADS", 8),
 		CtxSize:        getEnvInt("CTX_SIZE", 4096),
+		Executors:      getEnvInt("EXECUTOR_THREADS", getEnvInt("WORKER_CONCURRENCY", 2)),
+		
+		// Compute Configuration
+		BackendDir:        getEnv("BACKEND_DIR", ""),
+		SharedThreadpool:  getEnvBool("SHARED_THREADPOOL", false),
+		ThreadpoolThreads: getEnvInt("THREADPOOL_THREADS", 0),
+		ThreadpoolPoll:    getEnvInt("THREADPOOL_POLL", 50),
 		
 		// Format-Specific Configuration
 		FormatConfig:   loadFormatConfig(),
 		DataDir:        getEnv("DATA_DIR", "data"),
 		DBPath:         getEnv("DB_PATH", "data/worker.sqlite"),
 		
+		// Embedding Configuration
+		EmbedChunkOverlap: getEnvInt("EMBED_CHUNK_OVERLAP", 64),
+		VectorIndex:       getEnvBool("VECTOR_INDEX", false),
+		IndexSubject:      getEnv("INDEX_SUBJECT", "index.default"),
+		IndexStream:       getEnv("INDEX_STREAM", "INDEX"),
+		IndexFlush:        getEnvDuration("INDEX_FLUSH_INTERVAL", "1s"),
+		
+		// Completion Cache Configuration
+		DeterministicCache:  getEnvBool("DETERMINISTIC_CACHE", true),
+		CompletionCache:     getEnvBool("COMPLETION_CACHE", false),
+		CacheTTL:            getEnvDuration("CACHE_TTL", "10m"),
+		CacheMaxBytes:       getEnvInt("CACHE_MAX_BYTES", 64<<20),
+		CacheMaxTemperature: getEnvFloat("CACHE_MAX_TEMPERATURE", 0.2),
+		CacheEmbedSubject:   getEnv("CACHE_EMBED_SUBJECT", ""),
+		CacheSimilarity:     getEnvFloat("CACHE_SIMILARITY", 0.95),
+		
+		// Admission Control Configuration
+		AdmissionControl:    getEnvBool("ADMISSION_CONTROL", true),
+		AdmissionTokens:     getEnvInt("ADMISSION_TOKENS", 0),
+		AdmissionRetryDelay: getEnvDuration("ADMISSION_RETRY_DELAY", "2s"),
+		RequestDeadline:     getEnvDuration("REQUEST_DEADLINE", "30s"),
+		
 		// Monitoring Configuration
 		MonitoringTopic:       getEnv("MONITORING_TOPIC", "monitoring.inference"),
 		BackpressureThreshold: getEnvInt("BACKPRESSURE_THRESHOLD", 5),
@@ -130,6 +198,15 @@ func getEnvInt(key string, defaultVal int) int {
 	return defaultVal
 }
 
+func getEnvFloat(key string, defaultVal float64) float64 {
+	if val := os.Getenv(key); val != "" {
+		if f, err := strconv.ParseFloat(val, 64); err == nil {
+			return f
+		}
+	}
+	return defaultVal
+}
+
 func getEnvDuration(key, defaultVal string) time.Duration {
 	val := getEnv(key, defaultVal)
 	if d, err := time.ParseDuration(val); err == nil {
@@ -0,0 +1,229 @@
+package fastjson
+
+import (
+	"bytes"
+	"encoding/base64"
+	"encoding/json"
+	"math"
+	"reflect"
+	"testing"
+)
+
+var testStrings = []string{
+	"",
+	"plain text",
+	"quotes \" and \\ backslashes",
+	"newline\n tab\t return\r",
+	"control \x01 \x1f",
+	"<html> & entities",
+	"unicode: héllo wörld 日本語 🎉",
+	"separators \u2028 \u2029",
+	"invalid utf-8 \xff\xfe end",
+}
+
+func TestStringMatchesEncodingJSON(t *testing.T) {
+	for _, s := range testStrings {
+		want, _ := json.Marshal(s)
+		w := NewWriter(nil)
+		w.String(s)
+		if !bytes.Equal(w.Bytes(), want) {
+			t.Errorf("String(%q) = %s, want %s", s, w.Bytes(), want)
+		}
+	}
+}
+
+func TestFloatMatchesEncodingJSON(t *testing.T) {
+	floats := []float64{0, 1, -1, 0.5, 1.0 / 3, 1e-7, 1e-6, 123456789, 1e20, 1e21, 1e300, -2.5e-9, math.SmallestNonzeroFloat64}
+	for _, f := range floats {
+		want, _ := json.Marshal(f)
+		w := NewWriter(nil)
+		w.Float64(f)
+		if !bytes.Equal(w.Bytes(), want) {
+			t.Errorf("Float64(%v) = %s, want %s", f, w.Bytes(), want)
+		}
+
+		f32 := float32(f)
+		if math.IsInf(float64(f32), 0) {
+			continue
+		}
+		want, _ = json.Marshal(f32)
+		w = NewWriter(nil)
+		w.Float32(f32)
+		if !bytes.Equal(w.Bytes(), want) {
+			t.Errorf("Float32(%v) = %s, want %s", f32, w.Bytes(), want)
+		}
+	}
+
+	w := NewWriter(nil)
+	w.Float64(math.NaN())
+	if w.Err() == nil {
+		t.Error("NaN should be an error")
+	}
+}
+
+func TestWriterMatchesEncodingJSON(t *testing.T) {
+	type item struct {
+		Name   string    `json:"name"`
+		Vector []float32 `json:"vector"`
+		Span   []int     `json:"span"`
+	}
+	type document struct {
+		ID    int64  `json:"id"`
+		OK    bool   `json:"ok"`
+		Items []item `json:"items"`
+		Extra *int   `json:"extra"`
+	}
+	doc := document{
+		ID: 42,
+		OK: true,
+		Items: []item{
+			{Name: "a", Vector: []float32{0.1, -0.25, 3e-7}, Span: []int{0, 5}},
+			{Name: "b<c>", Vector: []float32{}, Span: nil},
+		},
+	}
+	want, _ := json.Marshal(doc)
+
+	w := NewWriter(nil)
+	w.ObjectStart()
+	w.Key("id")
+	w.Int(doc.ID)
+	w.Key("ok")
+	w.Bool(doc.OK)
+	w.Key("items")
+	w.ArrayStart()
+	for _, it := range doc.Items {
+		w.ObjectStart()
+		w.Key("name")
+		w.String(it.Name)
+		w.Key("vector")
+		w.Float32s(it.Vector)
+		w.Key("span")
+		w.Ints(it.Span)
+		w.ObjectEnd()
+	}
+	w.ArrayEnd()
+	w.Key("extra")
+	w.Null()
+	w.ObjectEnd()
+
+	if !bytes.Equal(w.Bytes(), want) {
+		t.Errorf("got  %s\nwant %s", w.Bytes(), want)
+	}
+}
+
+func TestStringRoundTrip(t *testing.T) {
+	inputs := append(testStrings[:len(testStrings)-1:len(testStrings)-1], "\b\f", `\u0041`)
+	for _, s := range inputs {
+		data, _ := json.Marshal(s)
+		got, err := NewReader(data).String()
+		if err != nil || got != s {
+			t.Errorf("String(%s) = %q, %v, want %q", data, got, err, s)
+		}
+	}
+
+	// Surrogate pairs and lone surrogates decode like encoding/json
+	for _, data := range []string{`"\ud83c\udf89"`, `"\ud83c"`, `"\ud83cx"`, `"\udf89\ud83c\udf89"`, `"\u00e9\/"`} {
+		var want string
+		json.Unmarshal([]byte(data), &want)
+		got, err := NewReader([]byte(data)).String()
+		if err != nil || got != want {
+			t.Errorf("String(%s) = %q, %v, want %q", data, got, err, want)
+		}
+	}
+}
+
+// TestStringInvalidUTF8 checks that invalid UTF-8 decodes to U+FFFD per byte like
+// encoding/json, with and without escapes in the same string
+func TestStringInvalidUTF8(t *testing.T) {
+	for _, data := range []string{"\"a\xffb\"", "\"\xfe\xff\"", "\"\xe6\x97\"", "\"\xed\xa0\x80\"", "\"\\n\xff\"", "\"\xff\\u0041\"", "\"日本\xc3\""} {
+		var want string
+		if err := json.Unmarshal([]byte(data), &want); err != nil {
+			t.Fatal(err)
+		}
+		got, err := NewReader([]byte(data)).String()
+		if err != nil || got != want {
+			t.Errorf("String(%q) = %q, %v, want %q", data, got, err, want)
+		}
+	}
+}
+
+func TestField(t *testing.T) {
+	names := []string{"req_id", "input", "Input"}
+	for key, want := range map[string]string{
+		"req_id": "req_id",
+		"REQ_ID": "req_id",
+		"Req_Id": "req_id",
+		"input":  "input",
+		"Input":  "Input", // An exact match wins over an earlier folded one
+		"INPUT":  "input",
+		"reqid":  "",
+		"":       "",
+	} {
+		if got := Field([]byte(key), names); got != want {
+			t.Errorf("Field(%q) = %q, want %q", key, got, want)
+		}
+	}
+}
+
+func TestValueMatchesEncodingJSON(t *testing.T) {
+	data := []byte(` {"a": 1.5, "b": [true, false, null, "x"], "c": {"d": -3e2}, "e": [] , "f": {}} `)
+	var want interface{}
+	if err := json.Unmarshal(data, &want); err != nil {
+		t.Fatal(err)
+	}
+
+	r := NewReader(data)
+	got, err := r.Value()
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := r.End(); err != nil {
+		t.Fatal(err)
+	}
+	if !reflect.DeepEqual(got, want) {
+		t.Errorf("Value() = %#v, want %#v", got, want)
+	}
+}
+
+func TestObjectSkipAndRaw(t *testing.T) {
+	data := []byte(`{"skip": {"x": [1, {"y": "}"}]}, "raw": [[0, 3], [4, 9]], "n": 7, "audio": "` +
+		base64.StdEncoding.EncodeToString([]byte("RIFF data")) + `"}`)
+
+	var raw []byte
+	var n int64
+	var audio []byte
+	r := NewReader(data)
+	err := r.Object(func(key []byte) error {
+		var err error
+		switch string(key) {
+		case "raw":
+			raw, err = r.Raw()
+		case "n":
+			n, err = r.Int()
+		case "audio":
+			audio, err = r.Base64()
+		default:
+			err = r.Skip()
+		}
+		return err
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if string(raw) != "[[0, 3], [4, 9]]" || n != 7 || string(audio) != "RIFF data" {
+		t.Errorf("got raw=%s n=%d audio=%q", raw, n, audio)
+	}
+}
+
+func TestReaderErrors(t *testing.T) {
+	for _, data := range []string{``, `{`, `{"a"}`, `{"a":1,}`, `[1 2]`, `"unterminated`, `"bad \q escape"`, `{"a":1} x`, "\"ctrl \x01\""} {
+		r := NewReader([]byte(data))
+		err := r.Skip()
+		if err == nil {
+			err = r.End()
+		}
+		if err == nil {
+			t.Errorf("%q should not parse", data)
+		}
+	}
+}
@@ -0,0 +1,399 @@
+package fastjson
+
+import (
+	"bytes"
+	"encoding/base64"
+	"errors"
+	"fmt"
+	"strconv"
+	"unicode/utf16"
+	"unicode/utf8"
+)
+
+var errUnexpectedEnd = errors.New("json: unexpected end of input")
+
+// Reader scans a JSON document in place. Values are read in document order with the
+// typed methods, members of objects are visited with Object.
+type Reader struct {
+	data []byte
+	pos  int
+}
+
+func NewReader(data []byte) *Reader {
+	return &Reader{data: data}
+}
+
+func (r *Reader) syntaxError(what string) error {
+	if r.pos >= len(r.data) {
+		return errUnexpectedEnd
+	}
+	return fmt.Errorf("json: invalid character %q at offset %d looking for %s", r.data[r.pos], r.pos, what)
+}
+
+func (r *Reader) skipSpace() {
+	for r.pos < len(r.data) {
+		switch r.data[r.pos] {
+		case ' ', '\t', '\n', '\r':
+			r.pos++
+		default:
+			return
+		}
+	}
+}
+
+// peek returns the first byte of the next value, 0 at the end of input
+func (r *Reader) peek() byte {
+	r.skipSpace()
+	if r.pos >= len(r.data) {
+		return 0
+	}
+	return r.data[r.pos]
+}
+
+func (r *Reader) expect(c byte) error {
+	if r.peek() != c {
+		return r.syntaxError(strconv.QuoteRune(rune(c)))
+	}
+	r.pos++
+	return nil
+}
+
+func (r *Reader) literal(word string) error {
+	if len(r.data)-r.pos < len(word) || string(r.data[r.pos:r.pos+len(word)]) != word {
+		return r.syntaxError(word)
+	}
+	r.pos += len(word)
+	return nil
+}
+
+// End checks that nothing but whitespace follows the document
+func (r *Reader) End() error {
+	if r.peek() != 0 {
+		return r.syntaxError("end of input")
+	}
+	return nil
+}
+
+// Null consumes a null and reports whether there was one
+func (r *Reader) Null() bool {
+	if r.peek() == 'n' && r.literal("null") == nil {
+		return true
+	}
+	return false
+}
+
+// Object calls member for each key of an object. member must read or Skip the value.
+// The key is only valid during the call.
+func (r *Reader) Object(member func(key []byte) error) error {
+	if err := r.expect('{'); err != nil {
+		return err
+	}
+	if r.peek() == '}' {
+		r.pos++
+		return nil
+	}
+	for {
+		key, err := r.rawString()
+		if err != nil {
+			return err
+		}
+		if err := r.expect(':'); err != nil {
+			return err
+		}
+		if err := member(key); err != nil {
+			return err
+		}
+		switch r.peek() {
+		case ',':
+			r.pos++
+		case '}':
+			r.pos++
+			return nil
+		default:
+			return r.syntaxError("',' or '}'")
+		}
+	}
+}
+
+// Array calls element for each element of an array, which must read or Skip it
+func (r *Reader) Array(element func() error) error {
+	if err := r.expect('['); err != nil {
+		return err
+	}
+	if r.peek() == ']' {
+		r.pos++
+		return nil
+	}
+	for {
+		if err := element(); err != nil {
+			return err
+		}
+		switch r.peek() {
+		case ',':
+			r.pos++
+		case ']':
+			r.pos++
+			return nil
+		default:
+			return r.syntaxError("',' or ']'")
+		}
+	}
+}
+
+// rawString returns the unescaped contents of a string. It aliases the input when the
+// string has no escapes and is valid UTF-8.
+func (r *Reader) rawString() ([]byte, error) {
+	if err := r.expect('"'); err != nil {
+		return nil, err
+	}
+	start := r.pos
+	for r.pos < len(r.data) {
+		switch c := r.data[r.pos]; {
+		case c == '"':
+			r.pos++
+			return r.data[start : r.pos-1], nil
+		case c == '\\':
+			return r.unescape(start)
+		case c < 0x20:
+			return nil, r.syntaxError("string character")
+		case c < utf8.RuneSelf:
+			r.pos++
+		default:
+			rr, size := utf8.DecodeRune(r.data[r.pos:])
+			if rr == utf8.RuneError && size == 1 {
+				return r.unescape(start)
+			}
+			r.pos += size
+		}
+	}
+	return nil, errUnexpectedEnd
+}
+
+// unescape decodes a string with escapes or invalid UTF-8 into a new buffer, from start
+// of contents. Like encoding/json it replaces each invalid byte with U+FFFD.
+func (r *Reader) unescape(start int) ([]byte, error) {
+	out := make([]byte, 0, r.pos-start+16)
+	out = append(out, r.data[start:r.pos]...)
+	for r.pos < len(r.data) {
+		c := r.data[r.pos]
+		switch {
+		case c == '"':
+			r.pos++
+			return out, nil
+		case c < 0x20:
+			return nil, r.syntaxError("string character")
+		case c < utf8.RuneSelf && c != '\\':
+			out = append(out, c)
+			r.pos++
+			continue
+		case c >= utf8.RuneSelf:
+			rr, size := utf8.DecodeRune(r.data[r.pos:])
+			out = utf8.AppendRune(out, rr)
+			r.pos += size
+			continue
+		}
+
+		if r.pos+1 >= len(r.data) {
+			return nil, errUnexpectedEnd
+		}
+		r.pos++
+		switch e := r.data[r.pos]; e {
+		case '"', '\\', '/':
+			out = append(out, e)
+		case 'b':
+			out = append(out, '\b')
+		case 'f':
+			out = append(out, '\f')
+		case 'n':
+			out = append(out, '\n')
+		case 'r':
+			out = append(out, '\r')
+		case 't':
+			out = append(out, '\t')
+		case 'u':
+			rr, ok := r.hex4(r.pos + 1)
+			if !ok {
+				return nil, r.syntaxError("unicode escape")
+			}
+			r.pos += 4
+			if utf16.IsSurrogate(rr) {
+				// A surrogate pair is two escapes, a lone surrogate decodes to U+FFFD
+				if low, ok := r.hex4(r.pos + 3); ok && r.data[r.pos+1] == '\\' && r.data[r.pos+2] == 'u' {
+					if dec := utf16.DecodeRune(rr, low); dec != utf8.RuneError {
+						rr = dec
+						r.pos += 6
+					} else {
+						rr = utf8.RuneError
+					}
+				} else {
+					rr = utf8.RuneError
+				}
+			}
+			out = utf8.AppendRune(out, rr)
+		default:
+			return nil, r.syntaxError("escape character")
+		}
+		r.pos++
+	}
+	return nil, errUnexpectedEnd
+}
+
+func (r *Reader) hex4(at int) (rune, bool) {
+	if at+4 > len(r.data) {
+		return 0, false
+	}
+	var v rune
+	for _, c := range r.data[at : at+4] {
+		switch {
+		case c >= '0' && c <= '9':
+			c -= '0'
+		case c >= 'a' && c <= 'f':
+			c = c - 'a' + 10
+		case c >= 'A' && c <= 'F':
+			c = c - 'A' + 10
+		default:
+			return 0, false
+		}
+		v = v<<4 | rune(c)
+	}
+	return v, true
+}
+
+// Field returns the name that key selects the way encoding/json matches object keys to
+// struct fields: exactly, or else ignoring case. It returns "" if no name matches.
+func Field(key []byte, names []string) string {
+	for _, name := range names {
+		if string(key) == name {
+			return name
+		}
+	}
+	for _, name := range names {
+		if bytes.EqualFold(key, []byte(name)) {
+			return name
+		}
+	}
+	return ""
+}
+
+func (r *Reader) String() (string, error) {
+	s, err := r.rawString()
+	return string(s), err
+}
+
+// Base64 decodes a base64 string value straight from the input
+func (r *Reader) Base64() ([]byte, error) {
+	s, err := r.rawString()
+	if err != nil {
+		return nil, err
+	}
+	out := make([]byte, base64.StdEncoding.DecodedLen(len(s)))
+	n, err := base64.StdEncoding.Decode(out, s)
+	return out[:n], err
+}
+
+// number returns the text of a number value
+func (r *Reader) number() ([]byte, error) {
+	r.skipSpace()
+	start := r.pos
+	for r.pos < len(r.data) {
+		switch c := r.data[r.pos]; {
+		case c >= '0' && c <= '9', c == '-', c == '+', c == '.', c == 'e', c == 'E':
+			r.pos++
+			continue
+		}
+		break
+	}
+	if r.pos == start {
+		return nil, r.syntaxError("number")
+	}
+	return r.data[start:r.pos], nil
+}
+
+func (r *Reader) Int() (int64, error) {
+	num, err := r.number()
+	if err != nil {
+		return 0, err
+	}
+	return strconv.ParseInt(string(num), 10, 64)
+}
+
+func (r *Reader) Float() (float64, error) {
+	num, err := r.number()
+	if err != nil {
+		return 0, err
+	}
+	return strconv.ParseFloat(string(num), 64)
+}
+
+func (r *Reader) Bool() (bool, error) {
+	switch r.peek() {
+	case 't':
+		return true, r.literal("true")
+	case 'f':
+		return false, r.literal("false")
+	}
+	return false, r.syntaxError("boolean")
+}
+
+// Value reads any value into the types encoding/json uses for interface{}: maps,
+// slices, strings, float64, bool and nil
+func (r *Reader) Value() (interface{}, error) {
+	switch c := r.peek(); {
+	case c == '{':
+		m := make(map[string]interface{})
+		err := r.Object(func(key []byte) error {
+			v, err := r.Value()
+			m[string(key)] = v
+			return err
+		})
+		return m, err
+	case c == '[':
+		a := make([]interface{}, 0)
+		err := r.Array(func() error {
+			v, err := r.Value()
+			a = append(a, v)
+			return err
+		})
+		return a, err
+	case c == '"':
+		return r.String()
+	case c == 't' || c == 'f':
+		return r.Bool()
+	case c == 'n':
+		return nil, r.literal("null")
+	case c == '-' || c >= '0' && c <= '9':
+		return r.Float()
+	}
+	return nil, r.syntaxError("value")
+}
+
+// Raw returns the encoded text of the next value and skips it
+func (r *Reader) Raw() ([]byte, error) {
+	r.skipSpace()
+	start := r.pos
+	if err := r.Skip(); err != nil {
+		return nil, err
+	}
+	return r.data[start:r.pos], nil
+}
+
+// Skip consumes the next value without decoding it
+func (r *Reader) Skip() error {
+	switch c := r.peek(); {
+	case c == '{':
+		return r.Object(func([]byte) error { return r.Skip() })
+	case c == '[':
+		return r.Array(r.Skip)
+	case c == '"':
+		_, err := r.rawString()
+		return err
+	case c == 't' || c == 'f':
+		_, err := r.Bool()
+		return err
+	case c == 'n':
+		return r.literal("null")
+	default:
+		_, err := r.number()
+		return err
+	}
+}
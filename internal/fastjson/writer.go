@@ -0,0 +1,249 @@
+// Package fastjson reads and writes JSON without reflection for the message types on
+// the hot path. Output matches encoding/json byte for byte, so the codecs can replace
+// json.Marshal without changing what clients receive.
+package fastjson
+
+import (
+	"fmt"
+	"math"
+	"strconv"
+	"sync"
+	"unicode/utf8"
+)
+
+// maxPooledBuffer keeps buffers of unusually large messages out of the pool
+const maxPooledBuffer = 1 << 20
+
+var bufferPool = sync.Pool{
+	New: func() interface{} {
+		buf := make([]byte, 0, 4096)
+		return &buf
+	},
+}
+
+// GetBuffer returns an empty buffer from the pool, to be returned with PutBuffer
+func GetBuffer() *[]byte {
+	buf := bufferPool.Get().(*[]byte)
+	*buf = (*buf)[:0]
+	return buf
+}
+
+// PutBuffer returns a buffer to the pool. The bytes must no longer be in use.
+func PutBuffer(buf *[]byte) {
+	if cap(*buf) > maxPooledBuffer {
+		return
+	}
+	bufferPool.Put(buf)
+}
+
+// Writer appends JSON to a byte slice. Separators are inserted automatically, so
+// callers only write keys and values in order. The first error is kept in Err.
+type Writer struct {
+	buf   []byte
+	start int // Bytes before start were in buf when the writer was created
+	err   error
+}
+
+func NewWriter(buf []byte) *Writer {
+	return &Writer{buf: buf, start: len(buf)}
+}
+
+// Bytes returns the written JSON
+func (w *Writer) Bytes() []byte {
+	return w.buf
+}
+
+// Err returns the first unsupported value written, as json.Marshal would have
+func (w *Writer) Err() error {
+	return w.err
+}
+
+// separate inserts a comma unless the value opens a container or follows a key
+func (w *Writer) separate() {
+	if n := len(w.buf); n > w.start {
+		switch w.buf[n-1] {
+		case '{', '[', ':':
+		default:
+			w.buf = append(w.buf, ',')
+		}
+	}
+}
+
+func (w *Writer) ObjectStart() {
+	w.separate()
+	w.buf = append(w.buf, '{')
+}
+
+func (w *Writer) ObjectEnd() {
+	w.buf = append(w.buf, '}')
+}
+
+func (w *Writer) ArrayStart() {
+	w.separate()
+	w.buf = append(w.buf, '[')
+}
+
+func (w *Writer) ArrayEnd() {
+	w.buf = append(w.buf, ']')
+}
+
+// Key writes an object key, which must be plain ASCII that needs no escaping
+func (w *Writer) Key(key string) {
+	w.separate()
+	w.buf = append(w.buf, '"')
+	w.buf = append(w.buf, key...)
+	w.buf = append(w.buf, '"', ':')
+}
+
+func (w *Writer) String(v string) {
+	w.separate()
+	w.buf = appendString(w.buf, v)
+}
+
+func (w *Writer) Int(v int64) {
+	w.separate()
+	w.buf = strconv.AppendInt(w.buf, v, 10)
+}
+
+func (w *Writer) Bool(v bool) {
+	w.separate()
+	w.buf = strconv.AppendBool(w.buf, v)
+}
+
+func (w *Writer) Null() {
+	w.separate()
+	w.buf = append(w.buf, "null"...)
+}
+
+// Raw writes already encoded JSON
+func (w *Writer) Raw(v []byte) {
+	w.separate()
+	w.buf = append(w.buf, v...)
+}
+
+func (w *Writer) Float64(v float64) {
+	w.separate()
+	w.buf = w.appendFloat(w.buf, v, 64)
+}
+
+func (w *Writer) Float32(v float32) {
+	w.separate()
+	w.buf = w.appendFloat(w.buf, float64(v), 32)
+}
+
+// Float32s writes a float32 array, or null for a nil slice like encoding/json
+func (w *Writer) Float32s(v []float32) {
+	if v == nil {
+		w.Null()
+		return
+	}
+	w.ArrayStart()
+	for i, f := range v {
+		if i > 0 {
+			w.buf = append(w.buf, ',')
+		}
+		w.buf = w.appendFloat(w.buf, float64(f), 32)
+	}
+	w.ArrayEnd()
+}
+
+// Ints writes an int array, or null for a nil slice
+func (w *Writer) Ints(v []int) {
+	if v == nil {
+		w.Null()
+		return
+	}
+	w.ArrayStart()
+	for i, n := range v {
+		if i > 0 {
+			w.buf = append(w.buf, ',')
+		}
+		w.buf = strconv.AppendInt(w.buf, int64(n), 10)
+	}
+	w.ArrayEnd()
+}
+
+// appendFloat formats like encoding/json: shortest representation, exponent form
+// only for very small or large magnitudes
+func (w *Writer) appendFloat(buf []byte, f float64, bits int) []byte {
+	if math.IsInf(f, 0) || math.IsNaN(f) {
+		if w.err == nil {
+			w.err = fmt.Errorf("json: unsupported value: %s", strconv.FormatFloat(f, 'g', -1, bits))
+		}
+		return append(buf, '0')
+	}
+
+	format := byte('f')
+	if abs := math.Abs(f); abs != 0 {
+		if bits == 64 && (abs < 1e-6 || abs >= 1e21) || bits == 32 && (float32(abs) < 1e-6 || float32(abs) >= 1e21) {
+			format = 'e'
+		}
+	}
+	buf = strconv.AppendFloat(buf, f, format, -1, bits)
+	if format == 'e' {
+		// Clean up e-09 to e-9
+		n := len(buf)
+		if n >= 4 && buf[n-4] == 'e' && buf[n-3] == '-' && buf[n-2] == '0' {
+			buf[n-2] = buf[n-1]
+			buf = buf[:n-1]
+		}
+	}
+	return buf
+}
+
+const hex = "0123456789abcdef"
+
+// appendString quotes s with the escaping of encoding/json, including HTML-safe
+// escapes and replacement of invalid UTF-8
+func appendString(buf []byte, s string) []byte {
+	buf = append(buf, '"')
+	start := 0
+	for i := 0; i < len(s); {
+		if b := s[i]; b < utf8.RuneSelf {
+			if b >= 0x20 && b != '"' && b != '\\' && b != '<' && b != '>' && b != '&' {
+				i++
+				continue
+			}
+			buf = append(buf, s[start:i]...)
+			switch b {
+			case '"', '\\':
+				buf = append(buf, '\\', b)
+			case '\b':
+				buf = append(buf, '\\', 'b')
+			case '\f':
+				buf = append(buf, '\\', 'f')
+			case '\n':
+				buf = append(buf, '\\', 'n')
+			case '\r':
+				buf = append(buf, '\\', 'r')
+			case '\t':
+				buf = append(buf, '\\', 't')
+			default:
+				buf = append(buf, '\\', 'u', '0', '0', hex[b>>4], hex[b&0xF])
+			}
+			i++
+			start = i
+			continue
+		}
+
+		r, size := utf8.DecodeRuneInString(s[i:])
+		if r == utf8.RuneError && size == 1 {
+			buf = append(buf, s[start:i]...)
+			buf = append(buf, `\ufffd`...)
+			i += size
+			start = i
+			continue
+		}
+		// Line and paragraph separators break JavaScript string literals
+		if r == '\u2028' || r == '\u2029' {
+			buf = append(buf, s[start:i]...)
+			buf = append(buf, '\\', 'u', '2', '0', '2', hex[r&0xF])
+			i += size
+			start = i
+			continue
+		}
+		i += size
+	}
+	buf = append(buf, s[start:]...)
+	return append(buf, '"')
+}
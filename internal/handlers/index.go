@@ -0,0 +1,89 @@
+package handlers
+
+import (
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"time"
+
+	"github.com/aigoflow/inference-service/internal/services"
+)
+
+type IndexHandler struct {
+	indexService *services.IndexService
+}
+
+func NewIndexHandler(indexService *services.IndexService) *IndexHandler {
+	return &IndexHandler{
+		indexService: indexService,
+	}
+}
+
+func (h *IndexHandler) RegisterRoutes(mux *http.ServeMux) {
+	mux.HandleFunc("/v1/index/upsert", h.handleUpsert)
+	mux.HandleFunc("/v1/index/search", h.handleSearch)
+}
+
+func (h *IndexHandler) handleUpsert(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "POST only", http.StatusMethodNotAllowed)
+		return
+	}
+
+	var httpReq services.IndexUpsertRequest
+	if err := json.NewDecoder(r.Body).Decode(&httpReq); err != nil {
+		http.Error(w, "Invalid JSON", http.StatusBadRequest)
+		return
+	}
+
+	if httpReq.ReqID == "" {
+		httpReq.ReqID = fmt.Sprintf("index-http-%d", time.Now().UnixNano())
+	}
+
+	if traceID := r.Header.Get("X-Trace-ID"); traceID != "" {
+		httpReq.TraceID = traceID
+	}
+
+	response, err := h.indexService.ProcessUpsert(r.Context(), httpReq, "http.index.upsert", "direct", "http-worker")
+	writeIndexResponse(w, response, err)
+}
+
+func (h *IndexHandler) handleSearch(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "POST only", http.StatusMethodNotAllowed)
+		return
+	}
+
+	var httpReq services.IndexSearchRequest
+	if err := json.NewDecoder(r.Body).Decode(&httpReq); err != nil {
+		http.Error(w, "Invalid JSON", http.StatusBadRequest)
+		return
+	}
+
+	if httpReq.ReqID == "" {
+		httpReq.ReqID = fmt.Sprintf("index-http-%d", time.Now().UnixNano())
+	}
+
+	if traceID := r.Header.Get("X-Trace-ID"); traceID != "" {
+		httpReq.TraceID = traceID
+	}
+
+	response, err := h.indexService.ProcessSearch(r.Context(), httpReq, "http.index.search", "direct", "http-worker")
+	writeIndexResponse(w, response, err)
+}
+
+func writeIndexResponse(w http.ResponseWriter, response *services.IndexResponse, err error) {
+	w.Header().Set("Content-Type", "application/json")
+	if err != nil {
+		w.WriteHeader(http.StatusBadRequest)
+		_ = json.NewEncoder(w).Encode(map[string]interface{}{
+			"error": map[string]interface{}{
+				"message": response.Error,
+				"type":    "index_error",
+			},
+		})
+		return
+	}
+
+	_ = json.NewEncoder(w).Encode(response)
+}
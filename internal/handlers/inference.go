@@ -22,8 +22,11 @@ func NewInferenceHandler(inferenceService *services.InferenceService) *Inference
 
 func (h *InferenceHandler) RegisterRoutes(mux *http.ServeMux) {
 	mux.HandleFunc("/v1/completions", h.handleCompletions)
+	mux.HandleFunc("/v1/chat/completions", h.handleChatCompletions)
+	mux.HandleFunc("/v1/score", h.handleScore)
 	mux.HandleFunc("/healthz", h.handleHealth)
 	mux.HandleFunc("/logs", h.handleLogs)
+	mux.HandleFunc("/v1/cache/stats", h.handleCacheStats)
 }
 
 func (h *InferenceHandler) handleHealth(w http.ResponseWriter, r *http.Request) {
@@ -51,8 +54,125 @@ func (h *InferenceHandler) handleCompletions(w http.ResponseWriter, r *http.Requ
 		httpReq.TraceID = traceID
 	}
 	
+	if httpReq.Stream {
+		h.serveStream(w, r, httpReq, "http.inference")
+		return
+	}
+	
 	response, err := h.inferenceService.ProcessInference(r.Context(), httpReq, "http.inference", "direct", "http-worker")
 	
+	w.Header().Set("Content-Type", "application/json")
+	_ = json.NewEncoder(w).Encode(responseBody(response, err))
+}
+
+func (h *InferenceHandler) handleChatCompletions(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "POST only", http.StatusMethodNotAllowed)
+		return
+	}
+	
+	var httpReq services.InferenceRequest
+	if err := json.NewDecoder(r.Body).Decode(&httpReq); err != nil {
+		http.Error(w, "Invalid JSON", http.StatusBadRequest)
+		return
+	}
+	
+	if len(httpReq.Messages) == 0 {
+		http.Error(w, "messages required", http.StatusBadRequest)
+		return
+	}
+	
+	if httpReq.ReqID == "" {
+		httpReq.ReqID = fmt.Sprintf("http-%d", time.Now().UnixNano())
+	}
+	
+	if traceID := r.Header.Get("X-Trace-ID"); traceID != "" {
+		httpReq.TraceID = traceID
+	}
+	
+	if httpReq.Stream {
+		h.serveStream(w, r, httpReq, "http.chat")
+		return
+	}
+	
+	response, err := h.inferenceService.ProcessInference(r.Context(), httpReq, "http.chat", "direct", "http-worker")
+	
+	resp := responseBody(response, err)
+	resp["message"] = map[string]string{
+		"role":    "assistant",
+		"content": response.Text,
+	}
+	
+	w.Header().Set("Content-Type", "application/json")
+	_ = json.NewEncoder(w).Encode(resp)
+}
+
+// handleScore returns the log-likelihood of each candidate continuation of the prompt
+func (h *InferenceHandler) handleScore(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "POST only", http.StatusMethodNotAllowed)
+		return
+	}
+	
+	var httpReq services.ScoreRequest
+	if err := json.NewDecoder(r.Body).Decode(&httpReq); err != nil {
+		http.Error(w, "Invalid JSON", http.StatusBadRequest)
+		return
+	}
+	
+	if len(httpReq.Candidates) == 0 {
+		http.Error(w, "candidates required", http.StatusBadRequest)
+		return
+	}
+	
+	if httpReq.ReqID == "" {
+		httpReq.ReqID = fmt.Sprintf("score-http-%d", time.Now().UnixNano())
+	}
+	
+	if traceID := r.Header.Get("X-Trace-ID"); traceID != "" {
+		httpReq.TraceID = traceID
+	}
+	
+	response, err := h.inferenceService.ProcessScore(r.Context(), httpReq, "http.score", "direct", "http-worker")
+	
+	w.Header().Set("Content-Type", "application/json")
+	if err != nil {
+		w.WriteHeader(http.StatusInternalServerError)
+	}
+	_ = json.NewEncoder(w).Encode(response)
+}
+
+// serveStream writes response text as server-sent events while it is generated,
+// followed by a final event carrying the complete response
+func (h *InferenceHandler) serveStream(w http.ResponseWriter, r *http.Request, httpReq services.InferenceRequest, source string) {
+	flusher, ok := w.(http.Flusher)
+	if !ok {
+		http.Error(w, "Streaming not supported", http.StatusInternalServerError)
+		return
+	}
+	
+	w.Header().Set("Content-Type", "text/event-stream")
+	w.Header().Set("Cache-Control", "no-cache")
+	w.Header().Set("Connection", "keep-alive")
+	
+	writeEvent := func(v interface{}) {
+		data, _ := json.Marshal(v)
+		fmt.Fprintf(w, "data: %s\n\n", data)
+		flusher.Flush()
+	}
+	
+	response, err := h.inferenceService.ProcessInferenceStream(r.Context(), httpReq, source, "direct", "http-worker", func(text string) {
+		writeEvent(services.InferenceChunk{ReqID: httpReq.ReqID, Text: text})
+	})
+	
+	resp := responseBody(response, err)
+	resp["done"] = true
+	writeEvent(resp)
+}
+
+// responseBody is the JSON body of a finished completion, shared by the completion,
+// chat and streaming endpoints
+func responseBody(response *services.InferenceResponse, err error) map[string]interface{} {
 	resp := map[string]interface{}{
 		"req_id":     response.ReqID,
 		"text":       response.Text,
@@ -60,12 +180,26 @@ func (h *InferenceHandler) handleCompletions(w http.ResponseWriter, r *http.Requ
 		"tokens_out": response.TokensOut,
 		"ms":         response.DurationMs,
 	}
+	if response.FinishReason != "" {
+		resp["finish_reason"] = response.FinishReason
+	}
+	if response.ReasoningTokens > 0 {
+		resp["reasoning_tokens"] = response.ReasoningTokens
+		resp["answer_tokens"] = response.AnswerTokens
+	}
+	if len(response.Choices) > 0 {
+		resp["choices"] = response.Choices
+	}
+	if response.Logprobs != nil {
+		resp["logprobs"] = response.Logprobs
+	}
+	if response.Cached != "" {
+		resp["cached"] = response.Cached
+	}
 	if err != nil {
 		resp["error"] = response.Error
 	}
-	
-	w.Header().Set("Content-Type", "application/json")
-	_ = json.NewEncoder(w).Encode(resp)
+	return resp
 }
 
 func (h *InferenceHandler) handleLogs(w http.ResponseWriter, r *http.Request) {
@@ -86,6 +220,17 @@ func (h *InferenceHandler) handleLogs(w http.ResponseWriter, r *http.Request) {
 	_ = json.NewEncoder(w).Encode(logs)
 }
 
+func (h *InferenceHandler) handleCacheStats(w http.ResponseWriter, r *http.Request) {
+	stats := h.inferenceService.CacheStats()
+	if stats == nil {
+		http.Error(w, "Completion cache disabled", http.StatusNotFound)
+		return
+	}
+	
+	w.Header().Set("Content-Type", "application/json")
+	_ = json.NewEncoder(w).Encode(stats)
+}
+
 // GetLogsHandler returns the logs handler function for reuse
 func (h *InferenceHandler) GetLogsHandler() http.HandlerFunc {
 	return h.handleLogs
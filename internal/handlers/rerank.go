@@ -0,0 +1,66 @@
+package handlers
+
+import (
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"time"
+
+	"github.com/aigoflow/inference-service/internal/services"
+)
+
+type RerankHandler struct {
+	embeddingService *services.EmbeddingService
+}
+
+func NewRerankHandler(embeddingService *services.EmbeddingService) *RerankHandler {
+	return &RerankHandler{
+		embeddingService: embeddingService,
+	}
+}
+
+func (h *RerankHandler) RegisterRoutes(mux *http.ServeMux) {
+	mux.HandleFunc("/v1/rerank", h.handleRerank)
+}
+
+func (h *RerankHandler) handleRerank(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "POST only", http.StatusMethodNotAllowed)
+		return
+	}
+	
+	var httpReq services.RerankRequest
+	if err := json.NewDecoder(r.Body).Decode(&httpReq); err != nil {
+		http.Error(w, "Invalid JSON", http.StatusBadRequest)
+		return
+	}
+	
+	if len(httpReq.Documents) == 0 {
+		http.Error(w, "documents required", http.StatusBadRequest)
+		return
+	}
+	
+	if httpReq.ReqID == "" {
+		httpReq.ReqID = fmt.Sprintf("rerank-http-%d", time.Now().UnixNano())
+	}
+	
+	if traceID := r.Header.Get("X-Trace-ID"); traceID != "" {
+		httpReq.TraceID = traceID
+	}
+	
+	response, err := h.embeddingService.ProcessRerank(r.Context(), httpReq, "http.rerank", "direct", "http-worker")
+	
+	w.Header().Set("Content-Type", "application/json")
+	if err != nil {
+		w.WriteHeader(http.StatusInternalServerError)
+		_ = json.NewEncoder(w).Encode(map[string]interface{}{
+			"error": map[string]interface{}{
+				"message": response.Error,
+				"type":    "rerank_error",
+			},
+		})
+		return
+	}
+	
+	_ = json.NewEncoder(w).Encode(response)
+}
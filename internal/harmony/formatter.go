@@ -24,61 +24,109 @@ func NewHarmonyFormatter() *HarmonyFormatter {
 	}
 }
 
+// PromptFragment is one piece of a rendered prompt. Fixed fragments hold template
+// text (special tokens, system header, role markers) that is identical across
+// requests; the rest carry per-request message content.
+type PromptFragment struct {
+	Text  string
+	Fixed bool
+}
+
 // FormatConversationForCompletion formats a conversation for GPT-OSS completion
 func (hf *HarmonyFormatter) FormatConversationForCompletion(conversation *Conversation) string {
 	var prompt strings.Builder
+	for _, fragment := range hf.FormatConversationFragments(conversation) {
+		prompt.WriteString(fragment.Text)
+	}
+	return prompt.String()
+}
+
+// FormatConversationFragments renders a conversation as template fragments interleaved
+// with message content, so callers can tokenize the fixed parts once and reuse them.
+func (hf *HarmonyFormatter) FormatConversationFragments(conversation *Conversation) []PromptFragment {
+	return hf.formatFragments(conversation, true)
+}
+
+// FormatHistoryFragments renders a conversation without the trailing assistant start,
+// which is the form used to render chat history turn by turn
+func (hf *HarmonyFormatter) FormatHistoryFragments(conversation *Conversation) []PromptFragment {
+	return hf.formatFragments(conversation, false)
+}
+
+func (hf *HarmonyFormatter) formatFragments(conversation *Conversation, addAssistant bool) []PromptFragment {
+	var fragments []PromptFragment
+	var fixed strings.Builder
+	
+	// Adjacent template text is merged into a single fixed fragment
+	flushFixed := func() {
+		if fixed.Len() > 0 {
+			fragments = append(fragments, PromptFragment{Text: fixed.String(), Fixed: true})
+			fixed.Reset()
+		}
+	}
 	
 	// System message with configuration
-	prompt.WriteString("<|start|>system<|message|>")
-	prompt.WriteString(conversation.SystemConfig.ModelIdentity)
+	fixed.WriteString("<|start|>system<|message|>")
+	fixed.WriteString(conversation.SystemConfig.ModelIdentity)
 	if !strings.HasSuffix(conversation.SystemConfig.ModelIdentity, ".") {
-		prompt.WriteString(".")
+		fixed.WriteString(".")
 	}
-	prompt.WriteString("\nKnowledge cutoff: ")
-	prompt.WriteString(conversation.SystemConfig.KnowledgeCutoff)
-	prompt.WriteString("\n\nReasoning: ")
-	prompt.WriteString(string(conversation.SystemConfig.ReasoningLevel))
+	fixed.WriteString("\nKnowledge cutoff: ")
+	fixed.WriteString(conversation.SystemConfig.KnowledgeCutoff)
+	fixed.WriteString("\n\nReasoning: ")
+	fixed.WriteString(string(conversation.SystemConfig.ReasoningLevel))
 	
 	// Add valid channels information
 	if len(conversation.SystemConfig.ValidChannels) > 0 {
-		prompt.WriteString("\n\n# Valid channels: ")
+		fixed.WriteString("\n\n# Valid channels: ")
 		channelStrs := make([]string, len(conversation.SystemConfig.ValidChannels))
 		for i, ch := range conversation.SystemConfig.ValidChannels {
 			channelStrs[i] = string(ch)
 		}
-		prompt.WriteString(strings.Join(channelStrs, ", "))
-		prompt.WriteString(". Channel must be included for every message.")
+		fixed.WriteString(strings.Join(channelStrs, ", "))
+		fixed.WriteString(". Channel must be included for every message.")
 	}
 	
 	// Add tools if present
 	if len(conversation.Tools) > 0 {
-		prompt.WriteString("\n\n# Available tools:\n")
+		fixed.WriteString("\n\n# Available tools:\n")
 		for _, tool := range conversation.Tools {
-			prompt.WriteString(fmt.Sprintf("- %s: %s\n", tool.Name, tool.Description))
+			fixed.WriteString(fmt.Sprintf("- %s: %s\n", tool.Name, tool.Description))
 		}
 	}
 	
-	prompt.WriteString("<|end|>")
+	fixed.WriteString("<|end|>")
 	
 	// Add all messages
 	for _, message := range conversation.Messages {
-		prompt.WriteString(fmt.Sprintf("<|start|>%s<|message|>", string(message.Role)))
+		if message.Channel != "" {
+			fixed.WriteString(fmt.Sprintf("<|start|>%s<|channel|>%s<|message|>", string(message.Role), string(message.Channel)))
+		} else {
+			fixed.WriteString(fmt.Sprintf("<|start|>%s<|message|>", string(message.Role)))
+		}
 		
 		// For non-system messages, add content
 		if message.Role != RoleSystem {
 			if message.Role == RoleDeveloper {
-				prompt.WriteString("# Instructions\n\n")
+				// Developer instructions come from configuration and stay stable across requests
+				fixed.WriteString("# Instructions\n\n")
+				fixed.WriteString(message.Content)
+			} else if message.Content != "" {
+				flushFixed()
+				fragments = append(fragments, PromptFragment{Text: message.Content})
 			}
-			prompt.WriteString(message.Content)
 		}
 		
-		prompt.WriteString("<|end|>")
+		fixed.WriteString("<|end|>")
 	}
 	
 	// Start assistant response
-	prompt.WriteString("<|start|>assistant")
+	if addAssistant {
+		fixed.WriteString("<|start|>assistant")
+	}
+	flushFixed()
 	
-	return prompt.String()
+	return fragments
 }
 
 // ParseAssistantResponse parses a GPT-OSS assistant response back into structured format
@@ -0,0 +1,283 @@
+package harmony
+
+import (
+	"encoding/json"
+	"fmt"
+	"strings"
+	"time"
+	"unicode/utf8"
+)
+
+// Harmony special tokens as they appear in detokenized model output
+const (
+	tokenStart     = "<|start|>"
+	tokenChannel   = "<|channel|>"
+	tokenMessage   = "<|message|>"
+	tokenConstrain = "<|constrain|>"
+	tokenEnd       = "<|end|>"
+	tokenReturn    = "<|return|>"
+	tokenCall      = "<|call|>"
+)
+
+// maxSpecialTokenLen bounds how long "<|" text is held back waiting for "|>"
+const maxSpecialTokenLen = 16
+
+// StreamHandler receives message content as soon as it is decoded
+type StreamHandler func(channel Channel, text string)
+
+// StreamParser incrementally parses assistant output as it is generated. Text is
+// pushed piece by piece and routed to its channel without waiting for the full
+// response, so final-channel text can be forwarded while the model is running.
+type StreamParser struct {
+	// StopOnToolCall reports the turn as done once a tool call message completes
+	StopOnToolCall bool
+
+	handler   StreamHandler
+	pending   string          // Undecided text, possibly a partial special token
+	inHeader  bool            // Between <|start|> and <|message|>
+	header    strings.Builder // Role, channel and recipient of the current message
+	channel   Channel
+	recipient string
+	content   strings.Builder // Content of the current message
+	emitted   int             // Bytes of content already passed to the handler
+	messages  int
+	channels  map[Channel][]string
+	toolCalls []ToolCall
+	done      bool
+}
+
+// NewStreamParser creates a parser for output following an <|start|>assistant prompt
+func NewStreamParser(handler StreamHandler) *StreamParser {
+	return &StreamParser{
+		handler:  handler,
+		inHeader: true,
+		channels: make(map[Channel][]string),
+	}
+}
+
+// Push consumes the next piece of generated text. It returns true once the
+// assistant turn is complete and generation can stop.
+func (p *StreamParser) Push(piece string) bool {
+	if p.done {
+		return true
+	}
+	p.pending += piece
+
+	for !p.done {
+		idx := strings.Index(p.pending, "<|")
+		if idx == -1 {
+			// Hold back a trailing "<" that may start a special token
+			keep := 0
+			if strings.HasSuffix(p.pending, "<") {
+				keep = 1
+			}
+			p.write(p.pending[:len(p.pending)-keep])
+			p.pending = p.pending[len(p.pending)-keep:]
+			break
+		}
+
+		end := strings.Index(p.pending[idx:], "|>")
+		if end == -1 {
+			if len(p.pending)-idx > maxSpecialTokenLen {
+				// Too long for a special token, treat "<" as plain text
+				p.write(p.pending[:idx+1])
+				p.pending = p.pending[idx+1:]
+				continue
+			}
+			p.write(p.pending[:idx])
+			p.pending = p.pending[idx:]
+			break
+		}
+
+		token := p.pending[idx : idx+end+2]
+		p.write(p.pending[:idx])
+		p.pending = p.pending[idx+end+2:]
+		p.special(token)
+	}
+
+	return p.done
+}
+
+// Close flushes held back text at the end of generation
+func (p *StreamParser) Close() {
+	if p.done {
+		return
+	}
+
+	if p.inHeader && p.messages == 0 {
+		// No Harmony structure was produced, treat the output as the final answer
+		text := p.header.String() + p.pending
+		p.pending = ""
+		if text != "" && !strings.Contains(text, tokenChannel) {
+			p.inHeader = false
+			p.channel = ChannelFinal
+			p.content.Reset()
+			p.emitted = 0
+			p.write(text)
+		}
+	} else {
+		p.write(p.pending)
+		p.pending = ""
+	}
+
+	p.endMessage()
+	p.done = true
+}
+
+// Response returns the parsed assistant response
+func (p *StreamParser) Response() *AssistantResponse {
+	result := &AssistantResponse{
+		Channels:  make(map[Channel]string),
+		ToolCalls: p.toolCalls,
+	}
+
+	for channel, parts := range p.channels {
+		result.Channels[channel] = strings.TrimSpace(strings.Join(parts, "\n"))
+	}
+
+	result.Reasoning = result.Channels[ChannelAnalysis]
+	result.FinalResponse = result.Channels[ChannelFinal]
+	if result.FinalResponse == "" {
+		// Keep ParseAssistantResponse behaviour of falling back to the analysis
+		result.FinalResponse = result.Channels[ChannelAnalysis]
+	}
+
+	return result
+}
+
+// write appends decoded text to the current header or message
+func (p *StreamParser) write(text string) {
+	if text == "" {
+		return
+	}
+	if p.inHeader {
+		p.header.WriteString(text)
+		return
+	}
+
+	p.content.WriteString(text)
+	p.emit(false)
+}
+
+// emit passes new message content to the handler, holding back split UTF-8 runes
+func (p *StreamParser) emit(flush bool) {
+	if p.handler == nil {
+		return
+	}
+
+	content := p.content.String()
+	end := len(content)
+	if !flush {
+		// Only the last rune of a piece can be incomplete
+		if start := lastRuneStart(content[:end]); start < end && !utf8.FullRuneInString(content[start:end]) {
+			end = start
+		}
+	}
+
+	if end > p.emitted {
+		p.handler(p.channel, content[p.emitted:end])
+		p.emitted = end
+	}
+}
+
+// lastRuneStart returns the offset of the last rune start byte in s
+func lastRuneStart(s string) int {
+	for i := len(s) - 1; i >= 0 && i >= len(s)-utf8.UTFMax; i-- {
+		if utf8.RuneStart(s[i]) {
+			return i
+		}
+	}
+	return len(s)
+}
+
+// special handles a complete special token
+func (p *StreamParser) special(token string) {
+	switch token {
+	case tokenStart:
+		p.endMessage()
+	case tokenChannel, tokenConstrain:
+		if !p.inHeader {
+			// Header without a preceding <|end|><|start|>
+			p.endMessage()
+		}
+		p.header.WriteString(token)
+	case tokenMessage:
+		if p.inHeader {
+			p.beginMessage()
+		} else {
+			p.write(token)
+		}
+	case tokenEnd:
+		p.endMessage()
+	case tokenReturn:
+		p.endMessage()
+		p.done = true
+	case tokenCall:
+		p.endMessage()
+		if p.StopOnToolCall {
+			p.done = true
+		}
+	default:
+		p.write(token)
+	}
+}
+
+// beginMessage parses the header and starts collecting message content
+func (p *StreamParser) beginMessage() {
+	header := p.header.String()
+
+	p.channel = ChannelFinal
+	if idx := strings.Index(header, tokenChannel); idx != -1 {
+		channel := header[idx+len(tokenChannel):]
+		if end := strings.IndexAny(channel, " <"); end != -1 {
+			channel = channel[:end]
+		}
+		if channel != "" {
+			p.channel = Channel(channel)
+		}
+	}
+
+	p.recipient = ""
+	if idx := strings.Index(header, "to="); idx != -1 {
+		recipient := header[idx+len("to="):]
+		if end := strings.IndexAny(recipient, " <"); end != -1 {
+			recipient = recipient[:end]
+		}
+		p.recipient = recipient
+	}
+
+	p.inHeader = false
+	p.content.Reset()
+	p.emitted = 0
+}
+
+// endMessage records the current message and waits for the next header
+func (p *StreamParser) endMessage() {
+	if p.inHeader {
+		p.header.Reset()
+		return
+	}
+
+	p.emit(true)
+	content := p.content.String()
+	p.channels[p.channel] = append(p.channels[p.channel], content)
+	p.messages++
+
+	if p.recipient != "" {
+		arguments := make(map[string]interface{})
+		if err := json.Unmarshal([]byte(strings.TrimSpace(content)), &arguments); err != nil {
+			arguments["raw"] = content
+		}
+		p.toolCalls = append(p.toolCalls, ToolCall{
+			Name:      strings.TrimPrefix(p.recipient, "functions."),
+			Arguments: arguments,
+			CallID:    fmt.Sprintf("call_%d", time.Now().UnixNano()),
+		})
+	}
+
+	p.inHeader = true
+	p.header.Reset()
+	p.content.Reset()
+	p.emitted = 0
+	p.recipient = ""
+}
@@ -0,0 +1,123 @@
+package harmony
+
+import (
+	"strings"
+	"testing"
+)
+
+// pushPieces feeds output to the parser in small pieces like a token stream would
+func pushPieces(parser *StreamParser, output string, size int) bool {
+	for i := 0; i < len(output); i += size {
+		end := i + size
+		if end > len(output) {
+			end = len(output)
+		}
+		if parser.Push(output[i:end]) {
+			return true
+		}
+	}
+	return false
+}
+
+func TestStreamParserRoutesChannels(t *testing.T) {
+	output := "<|channel|>analysis<|message|>User asks for the capital. Easy.<|end|>" +
+		"<|start|>assistant<|channel|>final<|message|>The capital is Moscow.<|return|>"
+
+	for _, size := range []int{1, 3, 7, len(output)} {
+		var final strings.Builder
+		parser := NewStreamParser(func(channel Channel, text string) {
+			if channel == ChannelFinal {
+				final.WriteString(text)
+			}
+		})
+
+		if !pushPieces(parser, output, size) {
+			t.Errorf("size %d: expected <|return|> to complete the turn", size)
+		}
+		parser.Close()
+
+		response := parser.Response()
+		if response.FinalResponse != "The capital is Moscow." {
+			t.Errorf("size %d: unexpected final response %q", size, response.FinalResponse)
+		}
+		if response.Reasoning != "User asks for the capital. Easy." {
+			t.Errorf("size %d: unexpected reasoning %q", size, response.Reasoning)
+		}
+		if final.String() != "The capital is Moscow." {
+			t.Errorf("size %d: unexpected streamed final text %q", size, final.String())
+		}
+	}
+}
+
+func TestStreamParserEmitsFinalBeforeEnd(t *testing.T) {
+	var final strings.Builder
+	parser := NewStreamParser(func(channel Channel, text string) {
+		if channel == ChannelFinal {
+			final.WriteString(text)
+		}
+	})
+
+	parser.Push("<|channel|>final<|message|>")
+	parser.Push("Hello")
+	parser.Push(" wor")
+
+	if final.String() != "Hello wor" {
+		t.Errorf("expected final text to stream before the message ends, got %q", final.String())
+	}
+}
+
+func TestStreamParserToolCall(t *testing.T) {
+	output := "<|channel|>analysis<|message|>Need weather.<|end|>" +
+		"<|start|>assistant<|channel|>commentary to=functions.get_weather <|constrain|>json<|message|>" +
+		"{\"location\":\"Tokyo\"}<|call|>"
+
+	parser := NewStreamParser(nil)
+	parser.StopOnToolCall = true
+
+	if !pushPieces(parser, output, 5) {
+		t.Error("expected tool call to complete the turn")
+	}
+	parser.Close()
+
+	response := parser.Response()
+	if len(response.ToolCalls) != 1 {
+		t.Fatalf("expected 1 tool call, got %d", len(response.ToolCalls))
+	}
+	call := response.ToolCalls[0]
+	if call.Name != "get_weather" {
+		t.Errorf("unexpected tool name %q", call.Name)
+	}
+	if call.Arguments["location"] != "Tokyo" {
+		t.Errorf("unexpected tool arguments %v", call.Arguments)
+	}
+}
+
+func TestStreamParserPlainOutput(t *testing.T) {
+	parser := NewStreamParser(nil)
+	pushPieces(parser, "Just a plain answer <b>with markup</b>", 4)
+	parser.Close()
+
+	if got := parser.Response().FinalResponse; got != "Just a plain answer <b>with markup</b>" {
+		t.Errorf("unexpected final response %q", got)
+	}
+}
+
+func TestStreamParserSplitRune(t *testing.T) {
+	var chunks []string
+	parser := NewStreamParser(func(channel Channel, text string) {
+		chunks = append(chunks, text)
+	})
+
+	output := "<|channel|>final<|message|>caf\xc3\xa9<|end|>"
+	pushPieces(parser, output, 1)
+	parser.Close()
+
+	for _, chunk := range chunks {
+		if strings.HasSuffix(chunk, "\xc3") {
+			t.Errorf("chunk %q ends with a split rune", chunk)
+		}
+	}
+	if strings.Join(chunks, "") != "café" {
+		t.Errorf("unexpected streamed text %q", strings.Join(chunks, ""))
+	}
+}
@@ -112,6 +112,17 @@ func (cb *ConversationBuilder) AddMessage(role Role, content string) *Conversati
 	return cb
 }
 
+// AddChannelMessage adds a message on a specific output channel, e.g. a prior
+// assistant answer on the final channel
+func (cb *ConversationBuilder) AddChannelMessage(role Role, channel Channel, content string) *ConversationBuilder {
+	cb.conversation.Messages = append(cb.conversation.Messages, Message{
+		Role:    role,
+		Content: content,
+		Channel: channel,
+	})
+	return cb
+}
+
 // AddSystemMessage adds a system message
 func (cb *ConversationBuilder) AddSystemMessage(content string) *ConversationBuilder {
 	return cb.AddMessage(RoleSystem, content)
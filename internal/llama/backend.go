@@ -0,0 +1,78 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"log/slog"
+	"strings"
+	"sync"
+	"unsafe"
+
+	"github.com/aigoflow/inference-service/internal/capabilities"
+)
+
+// maxBackendEntries bounds the devices and features read from the registry
+const maxBackendEntries = 64
+
+var (
+	backendsOnce sync.Once
+	compute      capabilities.ComputeInfo
+)
+
+// loadBackends loads dynamic backends from dir once per process and records the
+// devices and CPU features that were found
+func loadBackends(dir string) {
+	backendsOnce.Do(func() {
+		cDir := C.CString(dir)
+		defer C.free(unsafe.Pointer(cDir))
+		C.backends_load(cDir)
+
+		compute = readComputeInfo()
+		for _, dev := range compute.Devices {
+			slog.Info("Compute device",
+				"name", dev.Name,
+				"description", dev.Description,
+				"backend", dev.Backend,
+				"type", dev.Type,
+				"memory_mb", dev.MemoryTotal>>20)
+		}
+		slog.Info("CPU backend features", "features", strings.Join(compute.CPUFeatures, " "))
+	})
+}
+
+func readComputeInfo() capabilities.ComputeInfo {
+	var info capabilities.ComputeInfo
+
+	devices := make([]C.compute_device, maxBackendEntries)
+	n := int(C.compute_devices(&devices[0], C.int(len(devices))))
+	for _, dev := range devices[:min(n, len(devices))] {
+		info.Devices = append(info.Devices, capabilities.ComputeDevice{
+			Name:        C.GoString(&dev.name[0]),
+			Description: C.GoString(&dev.description[0]),
+			Backend:     C.GoString(&dev.backend[0]),
+			Type:        C.GoString(&dev._type[0]),
+			MemoryTotal: uint64(dev.memory_total),
+		})
+	}
+
+	// Flags are name=value pairs, boolean ones are only listed when enabled
+	features := make([]C.backend_feature, maxBackendEntries)
+	n = int(C.backend_features(&features[0], C.int(len(features))))
+	for _, f := range features[:min(n, len(features))] {
+		if C.GoString(&f.backend[0]) != "CPU" {
+			continue
+		}
+		name, value := C.GoString(&f.name[0]), C.GoString(&f.value[0])
+		switch value {
+		case "0":
+		case "1":
+			info.CPUFeatures = append(info.CPUFeatures, name)
+		default:
+			info.CPUFeatures = append(info.CPUFeatures, name+"="+value)
+		}
+	}
+	return info
+}
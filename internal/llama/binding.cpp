@@ -1,11 +1,113 @@
 #include "binding.h"
 #include "llama.h"
+#include "ggml-backend.h"
+#include "ggml-cpu.h"
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
 extern "C" {
 
+// Shared CPU threadpool. Set up once at load before any context exists, NULL when every
+// context keeps its own compute threads.
+static ggml_threadpool* g_threadpool = NULL;
+static int g_threadpool_threads = 0;
+static std::mutex g_threadpool_mu;      // Serializes graph computes on the shared pool
+static std::mutex g_live_mu;
+static std::set<llama_context*> g_pooled_contexts;  // Under g_live_mu, the pool is paused when empty
+
+// ggml-cpu threadpool entry points. With GGML_BACKEND_DL the CPU backend is a module
+// loaded at runtime and only exports ggml_threadpool_new through its registry. Without
+// pause and resume the pool is woken by its next graph compute and idle threads sleep
+// once they stop polling.
+typedef ggml_threadpool* (*threadpool_new_fn)(struct ggml_threadpool_params* params);
+typedef void (*threadpool_fn)(ggml_threadpool* threadpool);
+static threadpool_fn g_threadpool_pause = NULL;
+static threadpool_fn g_threadpool_resume = NULL;
+
+// Physical cores: hyperthread siblings share a core and gain little on matmul work
+static int physical_cores() {
+#if defined(__APPLE__)
+    int n = 0;
+    size_t len = sizeof(n);
+    if (sysctlbyname("hw.physicalcpu", &n, &len, NULL, 0) == 0 && n > 0) return n;
+#elif defined(__linux__)
+    std::set<std::string> cores;
+    for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+        std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings");
+        std::string siblings;
+        if (!std::getline(f, siblings)) break;
+        cores.insert(siblings);
+    }
+    if (!cores.empty()) return (int)cores.size();
+#endif
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? (int)n : 4;
+}
+
+int threadpool_init(int n_threads, int poll) {
+    std::lock_guard<std::mutex> lock(g_threadpool_mu);
+    if (g_threadpool) return g_threadpool_threads;
+    
+#ifdef GGML_BACKEND_DL
+    ggml_backend_reg_t cpu = ggml_backend_reg_by_name("CPU");
+    threadpool_new_fn threadpool_new =
+        cpu ? (threadpool_new_fn)ggml_backend_reg_get_proc_address(cpu, "ggml_threadpool_new") : NULL;
+    if (!threadpool_new) return 0;
+#else
+    threadpool_new_fn threadpool_new = ggml_threadpool_new;
+    g_threadpool_pause = ggml_threadpool_pause;
+    g_threadpool_resume = ggml_threadpool_resume;
+#endif
+    
+    if (n_threads <= 0) n_threads = physical_cores();
+    struct ggml_threadpool_params params = ggml_threadpool_params_default(n_threads);
+    params.poll = (uint32_t)std::max(0, std::min(poll, 100));
+    params.paused = true;  // Woken by the first context
+    
+    g_threadpool = threadpool_new(&params);
+    if (!g_threadpool) return 0;
+    g_threadpool_threads = n_threads;
+    return n_threads;
+}
+
+// Creates a context that computes on the shared threadpool when there is one
+static llama_context* init_context(llama_model* model, llama_context_params ctx_params) {
+    if (g_threadpool) {
+        ctx_params.n_threads = g_threadpool_threads;
+        ctx_params.n_threads_batch = g_threadpool_threads;
+    }
+    
+    llama_context* ctx = llama_init_from_model(model, ctx_params);
+    if (ctx && g_threadpool) {
+        llama_attach_threadpool(ctx, g_threadpool, g_threadpool);
+        std::lock_guard<std::mutex> lock(g_live_mu);
+        g_pooled_contexts.insert(ctx);
+        if (g_pooled_contexts.size() == 1 && g_threadpool_resume) g_threadpool_resume(g_threadpool);
+    }
+    return ctx;
+}
+
+// llama_decode that takes turns on the shared threadpool, which runs one graph at a time
+static int decode(llama_context* ctx, llama_batch batch) {
+    if (!g_threadpool) return llama_decode(ctx, batch);
+    std::lock_guard<std::mutex> lock(g_threadpool_mu);
+    return llama_decode(ctx, batch);
+}
+
 void* load_model(const char *fname, int n_ctx, int n_threads, int n_gpu_layers, bool use_mmap, bool use_mlock) {
     llama_model_params model_params = llama_model_default_params();
     model_params.n_gpu_layers = n_gpu_layers;
@@ -39,30 +141,54 @@ void* new_context(void* model, int n_ctx, int n_threads) {
     ctx_params.n_ctx = n_ctx > 0 ? n_ctx : 4096;
     ctx_params.n_threads = n_threads > 0 ? n_threads : 8;
     
-    llama_context* ctx = llama_init_from_model((llama_model*)model, ctx_params);
+    llama_context* ctx = init_context((llama_model*)model, ctx_params);
+    return (void*)ctx;
+}
+
+void* new_context_seqs(void* model, int n_ctx, int n_threads, int n_seq) {
+    if (!model) return nullptr;
+    
+    llama_context_params ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = n_ctx > 0 ? n_ctx : 4096;
+    ctx_params.n_threads = n_threads > 0 ? n_threads : 8;
+    ctx_params.n_seq_max = n_seq > 0 ? n_seq : 1;
+    ctx_params.kv_unified = true;  // Sequences share the prompt cells copied with seq_cp
+    
+    llama_context* ctx = init_context((llama_model*)model, ctx_params);
     return (void*)ctx;
 }
 
-void* new_embedding_context(void* model, int n_ctx, int n_threads) {
+void* new_embedding_context(void* model, int n_ctx, int n_threads, int pooling_type, int n_seq) {
     if (!model) return nullptr;
     
     llama_context_params ctx_params = llama_context_default_params();
     ctx_params.n_ctx = n_ctx > 0 ? n_ctx : 4096;
     ctx_params.n_threads = n_threads > 0 ? n_threads : 8;
-    ctx_params.pooling_type = LLAMA_POOLING_TYPE_MEAN;  // Enable pooling for embeddings
+    ctx_params.pooling_type = (enum llama_pooling_type)pooling_type;  // Mean, CLS, last or rank
+    ctx_params.n_seq_max = n_seq > 0 ? n_seq : 1;
+    ctx_params.kv_unified = true;  // Batched sequences share the context instead of splitting it
     
     // Critical settings for embedding models (copied from working example)
     ctx_params.n_batch = ctx_params.n_ctx;    // Set batch size to context size
     ctx_params.n_ubatch = ctx_params.n_batch; // For non-causal models
     ctx_params.embeddings = true;             // Enable embeddings
     
-    llama_context* ctx = llama_init_from_model((llama_model*)model, ctx_params);
+    llama_context* ctx = init_context((llama_model*)model, ctx_params);
     return (void*)ctx;
 }
 
 void free_context(void* ctx) {
     if (ctx) {
         llama_free((llama_context*)ctx);
+        
+        // Idle pool threads sleep between requests instead of polling. Contexts created
+        // before the pool never attached to it and do not count.
+        if (g_threadpool) {
+            std::lock_guard<std::mutex> lock(g_live_mu);
+            if (g_pooled_contexts.erase((llama_context*)ctx) && g_pooled_contexts.empty() && g_threadpool_pause) {
+                g_threadpool_pause(g_threadpool);
+            }
+        }
     }
 }
 
@@ -71,21 +197,99 @@ void clear_context(void* ctx) {
     // For now, context reuse is acceptable for testing
 }
 
-int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
-                  int max_tokens, float temperature, float top_p, int top_k,
-                  float repeat_penalty, int repeat_last_n, bool use_penalty) {
-    if (!ctx || !prompt || !result) return -1;
+// Log of the softmax denominator over n logits. Eight independent accumulators keep
+// the reductions free of loop-carried dependencies so the compiler can vectorize them.
+static float logsumexp(const float* logits, int n) {
+    float max_lane[8] = { logits[0], logits[0], logits[0], logits[0], logits[0], logits[0], logits[0], logits[0] };
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            max_lane[k] = logits[i + k] > max_lane[k] ? logits[i + k] : max_lane[k];
+        }
+    }
+    float max_logit = max_lane[0];
+    for (int k = 1; k < 8; k++) max_logit = max_lane[k] > max_logit ? max_lane[k] : max_logit;
+    for (int j = i; j < n; j++) max_logit = logits[j] > max_logit ? logits[j] : max_logit;
+    
+    float sum_lane[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (i = 0; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            sum_lane[k] += expf(logits[i + k] - max_logit);
+        }
+    }
+    double sum = 0.0;
+    for (int k = 0; k < 8; k++) sum += sum_lane[k];
+    for (int j = i; j < n; j++) sum += expf(logits[j] - max_logit);
+    
+    return max_logit + (float)log(sum);
+}
+
+// Log-probability of token under the raw logits
+static float token_logprob(const float* logits, int n_vocab, llama_token token) {
+    return logits[token] - logsumexp(logits, n_vocab);
+}
+
+// Records the sampled token and its top_n alternatives for one generation step
+static void record_logprobs(logprob_output* out, const float* logits, int n_vocab, llama_token token) {
+    if (out->n >= out->capacity) return;
+    
+    const float lse = logsumexp(logits, n_vocab);
+    const int step = out->n;
+    out->tokens[step] = token;
+    out->logprobs[step] = logits[token] - lse;
+    
+    if (out->top_n > 0) {
+        // Insertion into a small sorted window, top_n is tiny compared to the vocabulary
+        int32_t* top_tokens = out->top_tokens + (size_t)step * out->top_n;
+        float* top_logits = out->top_logprobs + (size_t)step * out->top_n;
+        int filled = 0;
+        for (int id = 0; id < n_vocab; id++) {
+            const float logit = logits[id];
+            if (filled == out->top_n && logit <= top_logits[filled - 1]) continue;
+            int pos = filled < out->top_n ? filled++ : filled - 1;
+            while (pos > 0 && top_logits[pos - 1] < logit) {
+                top_logits[pos] = top_logits[pos - 1];
+                top_tokens[pos] = top_tokens[pos - 1];
+                pos--;
+            }
+            top_logits[pos] = logit;
+            top_tokens[pos] = id;
+        }
+        for (int k = 0; k < filled; k++) top_logits[k] -= lse;
+        for (int k = filled; k < out->top_n; k++) {
+            top_tokens[k] = -1;
+            top_logits[k] = -INFINITY;
+        }
+    }
+    
+    out->n++;
+}
+
+// Cancellation flags are raised from another thread, so they are read atomically
+static bool is_cancelled(const int32_t* cancel) {
+    return cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED) != 0;
+}
+
+// Abort callback polled by llama.cpp during graph compute, stops a long prompt decode
+static bool abort_if_cancelled(void* data) {
+    return is_cancelled((const int32_t*)data);
+}
+
+static int predict_tokens(void* ctx, const int32_t* tokens, int n_tokens, char* result, int result_size,
+                          int max_tokens, float temperature, float top_p, int top_k,
+                          float repeat_penalty, int repeat_last_n, bool use_penalty,
+                          token_callback on_token, uintptr_t user_data, reasoning_budget* reasoning,
+                          logprob_output* logprobs, const int32_t* cancel) {
+    if (!ctx || !tokens || n_tokens <= 0 || !result) return -1;
     
     llama_context* context = (llama_context*)ctx;
     const llama_model* model = llama_get_model(context);
     const llama_vocab* vocab = llama_model_get_vocab(model);
+    llama_set_abort_callback(context, cancel ? abort_if_cancelled : NULL, (void*)cancel);
     
-    // Tokenize prompt exactly like simple.cpp
-    const int n_prompt = -llama_tokenize(vocab, prompt, strlen(prompt), NULL, 0, true, true);
-    if (n_prompt <= 0) return -1;
-    
-    std::vector<llama_token> prompt_tokens(n_prompt);
-    llama_tokenize(vocab, prompt, strlen(prompt), prompt_tokens.data(), prompt_tokens.size(), true, true);
+    // Prompt tokens are assembled by the caller (BOS, template fragments, user input)
+    const int n_prompt = n_tokens;
+    std::vector<llama_token> prompt_tokens(tokens, tokens + n_tokens);
     
     // Set up sampling chain (use greedy for now to avoid complexity)
     auto sparams = llama_sampler_chain_default_params();
@@ -95,6 +299,18 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
     
     std::string generated_text;
     int tokens_generated = 0;
+    if (logprobs) logprobs->n = 0;
+    
+    // Reasoning phase: 0 = waiting for start marker, 1 = reasoning, 2 = answer
+    int reasoning_phase = 2;
+    std::string start_marker, end_marker;
+    if (reasoning && reasoning->end_marker && reasoning->end_marker[0]) {
+        start_marker = reasoning->start_marker ? reasoning->start_marker : "";
+        end_marker = reasoning->end_marker;
+        reasoning_phase = start_marker.empty() ? 1 : 0;
+        reasoning->reasoning_tokens = 0;
+        reasoning->forced = false;
+    }
     
     // Main generation loop with chunked prompt processing
     int n_pos = 0;
@@ -111,13 +327,14 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
         printf("[DEBUG] Processing chunk %d-%d (%d tokens)\n", chunk_start, chunk_start + chunk_size - 1, chunk_size);
         fflush(stdout);
         
-        int decode_result = llama_decode(context, chunk_batch);
+        int decode_result = is_cancelled(cancel) ? 2 : decode(context, chunk_batch);
         printf("[DEBUG] Chunk decode result: %d\n", decode_result);
         fflush(stdout);
         
         if (decode_result) {
             printf("[DEBUG] Chunk decode failed, aborting\n");
             fflush(stdout);
+            llama_sampler_free(smpl);
             return -1;
         }
         n_pos += chunk_size;
@@ -128,6 +345,10 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
     
     // Now start generation loop
     for (int i = 0; i < max_tokens; ) {
+        if (is_cancelled(cancel)) {
+            break;
+        }
+        
         // Sample next token
         printf("[DEBUG] About to sample next token at position %d\n", n_pos);
         fflush(stdout);
@@ -142,6 +363,11 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
             break;
         }
         
+        // Log-probabilities only when requested, logits are overwritten by the next decode
+        if (logprobs) {
+            record_logprobs(logprobs, llama_get_logits_ith(context, -1), llama_vocab_n_tokens(vocab), new_token_id);
+        }
+        
         // Convert token to text
         printf("[DEBUG] About to convert token to text\n");
         fflush(stdout);
@@ -149,6 +375,7 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
         int n = llama_token_to_piece(vocab, new_token_id, buf, sizeof(buf), 0, true);
         printf("[DEBUG] Token conversion result: %d bytes\n", n);
         fflush(stdout);
+        size_t prev_len = generated_text.length();
         if (n > 0) {
             generated_text.append(buf, n);
             tokens_generated++;
@@ -156,14 +383,40 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
             fflush(stdout);
         }
         
+        // Track reasoning vs answer tokens on the generated text
+        if (reasoning_phase < 2) {
+            reasoning->reasoning_tokens++;
+            if (reasoning_phase == 0) {
+                size_t n_cmp = std::min(generated_text.length(), start_marker.length());
+                if (generated_text.compare(0, n_cmp, start_marker, 0, n_cmp) != 0) {
+                    // Output did not open with reasoning, everything is answer
+                    reasoning_phase = 2;
+                    reasoning->reasoning_tokens = 0;
+                } else if (generated_text.length() >= start_marker.length()) {
+                    reasoning_phase = 1;
+                }
+            }
+            if (reasoning_phase == 1) {
+                size_t from = prev_len >= end_marker.length() ? prev_len - end_marker.length() + 1 : 0;
+                if (generated_text.find(end_marker, from) != std::string::npos) {
+                    reasoning_phase = 2;
+                }
+            }
+        }
+        
         // Accept token for sampler state management
         llama_sampler_accept(smpl, new_token_id);
         
+        // Stream the piece to the caller, which may end generation early
+        if (on_token && n > 0 && !on_token(user_data, buf, n)) {
+            break;
+        }
+        
         // Prepare next batch with the new token and decode it
         printf("[DEBUG] Preparing batch for next token: %d\n", new_token_id);
         fflush(stdout);
         llama_batch next_batch = llama_batch_get_one(&new_token_id, 1);
-        int decode_result = llama_decode(context, next_batch);
+        int decode_result = decode(context, next_batch);
         printf("[DEBUG] Next token decode result: %d\n", decode_result);
         fflush(stdout);
         
@@ -175,6 +428,34 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
         
         n_pos += 1;
         i++;
+        
+        // Reasoning budget spent: inject the answer switch and continue with the answer
+        if (reasoning_phase == 1 && reasoning->max_tokens >= 0 && reasoning->reasoning_tokens >= reasoning->max_tokens) {
+            const char* force = (reasoning->force_text && reasoning->force_text[0]) ? reasoning->force_text : reasoning->end_marker;
+            int force_len = strlen(force);
+            int n_force = -llama_tokenize(vocab, force, force_len, NULL, 0, false, true);
+            reasoning_phase = 2;
+            reasoning->forced = true;
+            
+            if (n_force > 0) {
+                std::vector<llama_token> force_tokens(n_force);
+                llama_tokenize(vocab, force, force_len, force_tokens.data(), n_force, false, true);
+                
+                llama_batch force_batch = llama_batch_get_one(force_tokens.data(), n_force);
+                if (decode(context, force_batch)) {
+                    break;
+                }
+                for (size_t k = 0; k < force_tokens.size(); k++) {
+                    llama_sampler_accept(smpl, force_tokens[k]);
+                }
+                n_pos += n_force;
+                
+                generated_text.append(force, force_len);
+                if (on_token && !on_token(user_data, force, force_len)) {
+                    break;
+                }
+            }
+        }
     }
     
     llama_sampler_free(smpl);
@@ -187,6 +468,323 @@ int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
     return tokens_generated;
 }
 
+int llama_predict_request(void* ctx, predict_request* req) {
+    if (!req) return -1;
+    
+    req->tokens_out = predict_tokens(ctx, req->tokens, req->n_tokens, req->result, req->result_size,
+                                     req->max_tokens, req->temperature, req->top_p, req->top_k,
+                                     req->repeat_penalty, req->repeat_last_n, req->use_penalty,
+                                     req->on_token, req->user_data,
+                                     req->use_reasoning ? &req->reasoning : NULL,
+                                     req->use_logprobs ? &req->logprobs : NULL,
+                                     req->cancel);
+    req->result_len = req->tokens_out >= 0 ? (int)strlen(req->result) : 0;
+    return req->tokens_out;
+}
+
+// Native executor. Generation jobs are pushed by any number of Go threads onto a
+// mutex-guarded queue and run by a fixed set of worker threads, so core use is
+// bounded by workers * n_threads and no Go thread is held for a decode. A push only
+// holds the lock for a deque append, which is nothing next to the decode it queues.
+// Finished jobs go through a second queue to a few callback threads that notify Go.
+
+struct executor_job {
+    void* ctx;
+    predict_request* req;
+    job_callback on_done;
+    uintptr_t user_data;
+    int result;
+};
+
+struct job_queue {
+    std::deque<executor_job*> jobs;
+    std::mutex mu;
+    std::condition_variable cv;
+    bool stopping;
+    
+    job_queue() : stopping(false) {}
+    
+    void push(executor_job* job) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            jobs.push_back(job);
+        }
+        cv.notify_one();
+    }
+    
+    // Blocks until a job is available, NULL once stopping and drained
+    executor_job* wait_pop() {
+        std::unique_lock<std::mutex> lock(mu);
+        cv.wait(lock, [this] { return !jobs.empty() || stopping; });
+        if (jobs.empty()) return NULL;
+        executor_job* job = jobs.front();
+        jobs.pop_front();
+        return job;
+    }
+};
+
+// Completions only hand a result to Go, a couple of threads keep up with any pool
+static const int EXECUTOR_CALLBACK_THREADS = 2;
+
+struct executor {
+    job_queue jobs;
+    job_queue done;
+    std::vector<std::thread> threads;
+};
+
+static std::atomic<executor*> g_executor(NULL);
+static std::mutex g_executor_mu;
+
+static void executor_worker(executor* ex) {
+    while (executor_job* job = ex->jobs.wait_pop()) {
+        job->result = llama_predict_request(job->ctx, job->req);
+        ex->done.push(job);
+    }
+}
+
+static void executor_callback(executor* ex) {
+    while (executor_job* job = ex->done.wait_pop()) {
+        job->on_done(job->user_data, job->result);
+        delete job;
+    }
+}
+
+bool executor_start(int n_workers) {
+    if (n_workers <= 0) return false;
+    
+    std::lock_guard<std::mutex> lock(g_executor_mu);
+    if (g_executor.load()) return true;
+    
+    executor* ex = new executor();
+    for (int i = 0; i < n_workers; i++) {
+        ex->threads.push_back(std::thread(executor_worker, ex));
+    }
+    for (int i = 0; i < EXECUTOR_CALLBACK_THREADS; i++) {
+        ex->threads.push_back(std::thread(executor_callback, ex));
+    }
+    g_executor.store(ex);
+    return true;
+}
+
+bool llama_predict_request_async(void* ctx, predict_request* req, job_callback on_done, uintptr_t user_data) {
+    executor* ex = g_executor.load(std::memory_order_acquire);
+    if (!ex || !req || !on_done) return false;
+    
+    executor_job* job = new executor_job();
+    job->ctx = ctx;
+    job->req = req;
+    job->on_done = on_done;
+    job->user_data = user_data;
+    job->result = -1;
+    ex->jobs.push(job);
+    return true;
+}
+
+int llama_predict_samples(void* ctx, const int32_t* tokens, int n_tokens, int n_samples,
+                          char* result, int result_size, int* sample_tokens, float* sample_logprobs,
+                          int max_tokens, float temperature, float top_p, int top_k, uint32_t seed,
+                          const int32_t* cancel) {
+    if (!ctx || !tokens || n_tokens <= 0 || n_samples <= 0 || !result || !sample_tokens || !sample_logprobs) return -1;
+    
+    llama_context* context = (llama_context*)ctx;
+    const llama_model* model = llama_get_model(context);
+    const llama_vocab* vocab = llama_model_get_vocab(model);
+    llama_set_abort_callback(context, cancel ? abort_if_cancelled : NULL, (void*)cancel);
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+    
+    if ((uint32_t)n_samples > llama_n_seq_max(context)) return -1;
+    
+    // Prefill the prompt once on sequence 0
+    std::vector<llama_token> prompt_tokens(tokens, tokens + n_tokens);
+    const int BATCH_SIZE = 512;
+    for (int chunk_start = 0; chunk_start < n_tokens; chunk_start += BATCH_SIZE) {
+        int chunk_size = std::min(BATCH_SIZE, n_tokens - chunk_start);
+        llama_batch chunk_batch = llama_batch_get_one(prompt_tokens.data() + chunk_start, chunk_size);
+        if (is_cancelled(cancel) || decode(context, chunk_batch)) {
+            return -1;
+        }
+    }
+    
+    // Fork the prompt KV to every sample sequence
+    llama_memory_t mem = llama_get_memory(context);
+    for (int s = 1; s < n_samples; s++) {
+        llama_memory_seq_cp(mem, 0, s, -1, -1);
+    }
+    
+    // Independent sampler per sequence, seeded per sample for reproducibility
+    std::vector<llama_sampler*> samplers(n_samples);
+    for (int s = 0; s < n_samples; s++) {
+        llama_sampler* smpl = llama_sampler_chain_init(llama_sampler_chain_default_params());
+        if (temperature <= 0.0f) {
+            llama_sampler_chain_add(smpl, llama_sampler_init_greedy());
+        } else {
+            if (top_k > 0) llama_sampler_chain_add(smpl, llama_sampler_init_top_k(top_k));
+            if (top_p < 1.0f) llama_sampler_chain_add(smpl, llama_sampler_init_top_p(top_p, 1));
+            llama_sampler_chain_add(smpl, llama_sampler_init_temp(temperature));
+            llama_sampler_chain_add(smpl, llama_sampler_init_dist(seed == LLAMA_DEFAULT_SEED ? LLAMA_DEFAULT_SEED : seed + s));
+        }
+        samplers[s] = smpl;
+    }
+    
+    std::vector<std::string> texts(n_samples);
+    std::vector<bool> active(n_samples, true);
+    std::vector<int32_t> logits_idx(n_samples, -1);  // All samples start from the last prompt logits
+    for (int s = 0; s < n_samples; s++) {
+        sample_tokens[s] = 0;
+        sample_logprobs[s] = 0.0f;
+    }
+    
+    llama_batch batch = llama_batch_init(n_samples, 0, 1);
+    int total_generated = 0;
+    bool failed = false;
+    
+    for (int step = 0; step < max_tokens && !is_cancelled(cancel); step++) {
+        batch.n_tokens = 0;
+        
+        for (int s = 0; s < n_samples; s++) {
+            if (!active[s]) continue;
+            
+            llama_token token = llama_sampler_sample(samplers[s], context, logits_idx[s]);
+            if (llama_vocab_is_eog(vocab, token)) {
+                active[s] = false;
+                continue;
+            }
+            
+            sample_logprobs[s] += token_logprob(llama_get_logits_ith(context, logits_idx[s]), n_vocab, token);
+            
+            char buf[128];
+            int n = llama_token_to_piece(vocab, token, buf, sizeof(buf), 0, true);
+            if (n > 0) {
+                texts[s].append(buf, n);
+            }
+            sample_tokens[s]++;
+            total_generated++;
+            
+            // Queue the token on its own sequence for the next shared decode
+            int i = batch.n_tokens;
+            batch.token[i] = token;
+            batch.pos[i] = n_tokens + step;
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = s;
+            batch.logits[i] = true;
+            logits_idx[s] = i;
+            batch.n_tokens++;
+        }
+        
+        if (batch.n_tokens == 0) break;
+        
+        // A full KV or failed compute would truncate every sample, report it
+        if (decode(context, batch)) {
+            failed = true;
+            break;
+        }
+    }
+    
+    llama_batch_free(batch);
+    for (int s = 0; s < n_samples; s++) {
+        llama_sampler_free(samplers[s]);
+    }
+    if (failed) {
+        return -1;
+    }
+    
+    for (int s = 0; s < n_samples; s++) {
+        char* out = result + (size_t)s * result_size;
+        size_t len = std::min((size_t)(result_size - 1), texts[s].length());
+        strncpy(out, texts[s].c_str(), len);
+        out[len] = '\0';
+    }
+    
+    return total_generated;
+}
+
+int llama_score_candidates(void* ctx, const int32_t* tokens, int n_tokens,
+                           const int32_t* cand_tokens, const int* cand_lens, int n_candidates,
+                           float* scores) {
+    if (!ctx || !tokens || n_tokens <= 0 || !cand_tokens || !cand_lens || n_candidates <= 0 || !scores) return -1;
+    
+    llama_context* context = (llama_context*)ctx;
+    const llama_model* model = llama_get_model(context);
+    const llama_vocab* vocab = llama_model_get_vocab(model);
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+    const int n_batch = (int)llama_n_batch(context);
+    
+    if ((uint32_t)n_candidates > llama_n_seq_max(context)) return -1;
+    
+    std::vector<int> offsets(n_candidates);
+    int total_tokens = 0;
+    for (int c = 0; c < n_candidates; c++) {
+        if (cand_lens[c] <= 0 || cand_lens[c] > n_batch) return -1;
+        offsets[c] = total_tokens;
+        total_tokens += cand_lens[c];
+    }
+    
+    // Prefill the prompt once on sequence 0
+    std::vector<llama_token> prompt_tokens(tokens, tokens + n_tokens);
+    const int BATCH_SIZE = 512;
+    for (int chunk_start = 0; chunk_start < n_tokens; chunk_start += BATCH_SIZE) {
+        int chunk_size = std::min(BATCH_SIZE, n_tokens - chunk_start);
+        llama_batch chunk_batch = llama_batch_get_one(prompt_tokens.data() + chunk_start, chunk_size);
+        if (decode(context, chunk_batch)) {
+            return -1;
+        }
+    }
+    
+    // The first token of every candidate is scored from the last prompt logits, which
+    // the candidate decode below overwrites
+    const float* prompt_logits = llama_get_logits_ith(context, -1);
+    const float prompt_lse = logsumexp(prompt_logits, n_vocab);
+    for (int c = 0; c < n_candidates; c++) {
+        scores[c] = prompt_logits[cand_tokens[offsets[c]]] - prompt_lse;
+    }
+    
+    // Fork the prompt KV to every candidate sequence
+    llama_memory_t mem = llama_get_memory(context);
+    for (int c = 1; c < n_candidates; c++) {
+        llama_memory_seq_cp(mem, 0, c, -1, -1);
+    }
+    
+    // Token j of a candidate predicts token j + 1, so all but the last token of every
+    // candidate are decoded, packed into as few batches as n_batch allows
+    llama_batch batch = llama_batch_init(n_batch, 0, 1);
+    int next = 0;
+    while (next < n_candidates) {
+        const int first = next;
+        batch.n_tokens = 0;
+        while (next < n_candidates && batch.n_tokens + cand_lens[next] - 1 <= n_batch) {
+            const int32_t* cand = cand_tokens + offsets[next];
+            for (int j = 0; j + 1 < cand_lens[next]; j++) {
+                int i = batch.n_tokens;
+                batch.token[i] = cand[j];
+                batch.pos[i] = n_tokens + j;
+                batch.n_seq_id[i] = 1;
+                batch.seq_id[i][0] = next;
+                batch.logits[i] = true;
+                batch.n_tokens++;
+            }
+            next++;
+        }
+        
+        if (batch.n_tokens == 0) continue;  // Single-token candidates only
+        
+        if (decode(context, batch)) {
+            llama_batch_free(batch);
+            return -1;
+        }
+        
+        int idx = 0;
+        for (int c = first; c < next; c++) {
+            const int32_t* cand = cand_tokens + offsets[c];
+            for (int j = 1; j < cand_lens[c]; j++) {
+                scores[c] += token_logprob(llama_get_logits_ith(context, idx++), n_vocab, cand[j]);
+            }
+        }
+    }
+    
+    llama_batch_free(batch);
+    return total_tokens;
+}
+
 int llama_predict_with_grammar(void* ctx, const char* prompt, char* result, int result_size,
                               int max_tokens, float temperature, float top_p, int top_k,
                               float repeat_penalty, int repeat_last_n, 
@@ -206,7 +804,7 @@ int llama_predict_with_grammar(void* ctx, const char* prompt, char* result, int
     
     // Evaluate prompt
     llama_batch batch = llama_batch_get_one(prompt_tokens.data(), prompt_tokens.size());
-    if (llama_decode(context, batch) != 0) {
+    if (decode(context, batch) != 0) {
         return -1;
     }
     
@@ -243,7 +841,7 @@ int llama_predict_with_grammar(void* ctx, const char* prompt, char* result, int
     const int MAX_GENERATION_ATTEMPTS = max_tokens * 2; // Safety limit
     
     for (int n_pos = 0; n_pos < max_tokens && n_pos + batch.n_tokens < n_prompt + max_tokens && generation_attempts < MAX_GENERATION_ATTEMPTS; ) {
-        if (llama_decode(context, batch)) {
+        if (decode(context, batch)) {
             printf("ERROR: llama_decode failed\n");
             break;
         }
@@ -314,23 +912,113 @@ int count_tokens(void* ctx, const char* text) {
     return n_tokens > 0 ? n_tokens : 0;
 }
 
-int get_context_size(void* model) {
-    if (!model) return 0;
-    return llama_model_n_ctx_train((llama_model*)model);
+int tokenize_text(void* model, const char* text, int text_len, bool add_special, bool parse_special,
+                  int32_t* tokens, int max_tokens) {
+    if (!model || !text) return 0;
+    
+    const llama_vocab* vocab = llama_model_get_vocab((const llama_model*)model);
+    
+    // Returns the number of tokens written, or the negated required size when max_tokens is too small
+    return llama_tokenize(vocab, text, text_len, tokens, max_tokens, add_special, parse_special);
 }
 
-bool has_gpu_support() {
-#ifdef GGML_USE_METAL
-    return true;
-#elif defined(GGML_USE_CUDA)
-    return true;
-#elif defined(GGML_USE_VULKAN)
-    return true;
+int chat_apply_template(void* model, const char** roles, const char** contents, int n_messages,
+                        bool add_assistant, char* buf, int buf_size) {
+    if (!model || !roles || !contents || n_messages <= 0) return -1;
+    
+    // nullptr selects the default template stored in the GGUF metadata
+    const char* tmpl = llama_model_chat_template((const llama_model*)model, nullptr);
+    
+    std::vector<llama_chat_message> chat(n_messages);
+    for (int i = 0; i < n_messages; i++) {
+        chat[i].role = roles[i];
+        chat[i].content = contents[i];
+    }
+    
+    // Returns the full rendered length, which may exceed buf_size (caller retries with a bigger buffer)
+    return llama_chat_apply_template(tmpl, chat.data(), chat.size(), add_assistant, buf, buf_size);
+}
+
+int token_to_piece(void* model, int32_t token, char* buf, int buf_size) {
+    if (!model || !buf || buf_size <= 0) return -1;
+    const llama_vocab* vocab = llama_model_get_vocab((llama_model*)model);
+    return llama_token_to_piece(vocab, token, buf, buf_size, 0, true);
+}
+
+bool token_is_special(void* model, int32_t token) {
+    if (!model) return false;
+    const llama_vocab* vocab = llama_model_get_vocab((llama_model*)model);
+    // The tokens the tokenizer splits text at when parsing special tokens
+    return llama_vocab_get_attr(vocab, token) & (LLAMA_TOKEN_ATTR_CONTROL | LLAMA_TOKEN_ATTR_USER_DEFINED | LLAMA_TOKEN_ATTR_UNKNOWN);
+}
+
+void backends_load(const char* dir) {
+#ifdef GGML_BACKEND_DL
+    // Each backend library scores itself against the host, the best CPU variant wins
+    if (dir && dir[0]) {
+        ggml_backend_load_all_from_path(dir);
+    } else {
+        ggml_backend_load_all();
+    }
 #else
-    return false;
+    (void)dir;  // Backends are linked in and registered statically
 #endif
 }
 
+static const char* device_type_name(enum ggml_backend_dev_type type) {
+    switch (type) {
+        case GGML_BACKEND_DEVICE_TYPE_CPU:   return "cpu";
+        case GGML_BACKEND_DEVICE_TYPE_GPU:   return "gpu";
+        case GGML_BACKEND_DEVICE_TYPE_IGPU:  return "igpu";
+        case GGML_BACKEND_DEVICE_TYPE_ACCEL: return "accel";
+    }
+    return "unknown";
+}
+
+int compute_devices(compute_device* out, int max) {
+    int n = (int)ggml_backend_dev_count();
+    for (int i = 0; i < n && i < max; i++) {
+        ggml_backend_dev_t dev = ggml_backend_dev_get(i);
+        compute_device* d = &out[i];
+        size_t free_mem = 0, total_mem = 0;
+        ggml_backend_dev_memory(dev, &free_mem, &total_mem);
+        
+        snprintf(d->name, sizeof(d->name), "%s", ggml_backend_dev_name(dev));
+        snprintf(d->description, sizeof(d->description), "%s", ggml_backend_dev_description(dev));
+        snprintf(d->backend, sizeof(d->backend), "%s", ggml_backend_reg_name(ggml_backend_dev_backend_reg(dev)));
+        snprintf(d->type, sizeof(d->type), "%s", device_type_name(ggml_backend_dev_type(dev)));
+        d->memory_total = (uint64_t)total_mem;
+    }
+    return n;
+}
+
+int backend_features(backend_feature* out, int max) {
+    int n = 0;
+    for (size_t i = 0; i < ggml_backend_reg_count(); i++) {
+        ggml_backend_reg_t reg = ggml_backend_reg_get(i);
+        ggml_backend_get_features_t get_features =
+            (ggml_backend_get_features_t)ggml_backend_reg_get_proc_address(reg, "ggml_backend_get_features");
+        if (!get_features) continue;
+        
+        // Features of the code the backend was built with, for the CPU its SIMD kernels
+        for (struct ggml_backend_feature* f = get_features(reg); f && f->name; f++, n++) {
+            if (n >= max) continue;
+            snprintf(out[n].backend, sizeof(out[n].backend), "%s", ggml_backend_reg_name(reg));
+            snprintf(out[n].name, sizeof(out[n].name), "%s", f->name);
+            snprintf(out[n].value, sizeof(out[n].value), "%s", f->value);
+        }
+    }
+    return n;
+}
+
+bool has_gpu_support() {
+    for (size_t i = 0; i < ggml_backend_dev_count(); i++) {
+        enum ggml_backend_dev_type type = ggml_backend_dev_type(ggml_backend_dev_get(i));
+        if (type == GGML_BACKEND_DEVICE_TYPE_GPU || type == GGML_BACKEND_DEVICE_TYPE_IGPU) return true;
+    }
+    return false;
+}
+
 int llama_embedding(void* ctx, const char* text, float* embeddings, int max_embeddings) {
     if (!ctx || !text || !embeddings) return -1;
     
@@ -362,7 +1050,7 @@ int llama_embedding(void* ctx, const char* text, float* embeddings, int max_embe
     llama_memory_clear(llama_get_memory(context), true);
     
     // Process tokens for embedding (use decode for embeddings)
-    if (llama_decode(context, batch) < 0) {
+    if (decode(context, batch) < 0) {
         llama_batch_free(batch);
         return -1; // Failed to decode
     }
@@ -393,102 +1081,186 @@ int llama_embedding(void* ctx, const char* text, float* embeddings, int max_embe
     return n_embd;
 }
 
-int get_embedding_size(void* model) {
-    if (!model) return 0;
-    return llama_model_n_embd((llama_model*)model);
-}
-
-// Model introspection functions
-const char* get_model_architecture(void* model) {
-    if (!model) return "unknown";
+int llama_embed_sequences(void* ctx, const int32_t* tokens, const int* seq_lens, int n_seqs,
+                          float* out, int out_size) {
+    if (!ctx || !tokens || !seq_lens || n_seqs <= 0 || !out || out_size <= 0) return -1;
     
-    const llama_model* m = (const llama_model*)model;
+    llama_context* context = (llama_context*)ctx;
+    const int n_batch = (int)llama_n_batch(context);
+    const int n_seq_max = (int)llama_n_seq_max(context);
+    
+    std::vector<int> offsets(n_seqs);
+    int total_tokens = 0;
+    for (int s = 0; s < n_seqs; s++) {
+        if (seq_lens[s] <= 0 || seq_lens[s] > n_batch) return -1;
+        offsets[s] = total_tokens;
+        total_tokens += seq_lens[s];
+    }
     
-    // Try to get architecture from model metadata using buffer
-    static char arch_buf[64];
-    int32_t result = llama_model_meta_val_str(m, "general.architecture", arch_buf, sizeof(arch_buf));
+    // Pack whole sequences into each decode up to n_batch tokens and n_seq_max sequences
+    llama_batch batch = llama_batch_init(n_batch, 0, 1);
+    int next = 0;
+    while (next < n_seqs) {
+        const int first = next;
+        batch.n_tokens = 0;
+        while (next < n_seqs && next - first < n_seq_max && batch.n_tokens + seq_lens[next] <= n_batch) {
+            const int32_t* seq = tokens + offsets[next];
+            for (int j = 0; j < seq_lens[next]; j++) {
+                int i = batch.n_tokens;
+                batch.token[i] = seq[j];
+                batch.pos[i] = j;
+                batch.n_seq_id[i] = 1;
+                batch.seq_id[i][0] = next - first;
+                batch.logits[i] = true;
+                batch.n_tokens++;
+            }
+            next++;
+        }
+        
+        llama_memory_clear(llama_get_memory(context), true);
+        if (decode(context, batch) < 0) {
+            llama_batch_free(batch);
+            return -1;
+        }
+        
+        for (int s = first; s < next; s++) {
+            const float* pooled = llama_get_embeddings_seq(context, s - first);
+            if (!pooled) {
+                llama_batch_free(batch);
+                return -1;
+            }
+            memcpy(out + (size_t)s * out_size, pooled, out_size * sizeof(float));
+        }
+    }
     
-    return (result > 0) ? arch_buf : "llama";  // Default to llama if not found
+    llama_batch_free(batch);
+    return total_tokens;
 }
 
-const char* get_model_name(void* model) {
-    if (!model) return "unknown";
-    
-    const llama_model* m = (const llama_model*)model;
-    
-    static char name_buf[128];
-    int32_t result = llama_model_meta_val_str(m, "general.name", name_buf, sizeof(name_buf));
+int llama_rerank(void* ctx, const int32_t* tokens, const int* seq_lens, int n_seqs, float* scores) {
+    if (!ctx || llama_pooling_type((llama_context*)ctx) != LLAMA_POOLING_TYPE_RANK) return -1;
     
-    return (result > 0) ? name_buf : "unnamed";
+    // Rank pooling yields the classifier output per sequence, the score comes first
+    return llama_embed_sequences(ctx, tokens, seq_lens, n_seqs, scores, 1);
 }
 
-int get_model_parameter_count(void* model) {
-    if (!model) return 0;
+int llama_embedding_spans(void* ctx, const int32_t* tokens, int n_tokens,
+                          const int* span_starts, const int* span_ends, int n_spans, float* embeddings) {
+    if (!ctx || !tokens || n_tokens <= 0 || !span_starts || !span_ends || n_spans <= 0 || !embeddings) return -1;
     
-    const llama_model* m = (const llama_model*)model;
+    llama_context* context = (llama_context*)ctx;
+    const llama_model* model = llama_get_model(context);
+    if (llama_pooling_type(context) != LLAMA_POOLING_TYPE_NONE) return -1;
+    if (n_tokens > (int)llama_n_batch(context)) return -1;
     
-    // Try to get parameter count from metadata
-    // This might not always be available in GGUF
-    return llama_model_n_params(m);
-}
-
-const char* get_model_quantization(void* model) {
-    if (!model) return "unknown";
+    // One forward pass over the whole document with an output for every token
+    llama_batch batch = llama_batch_init(n_tokens, 0, 1);
+    for (int i = 0; i < n_tokens; i++) {
+        batch.token[i] = tokens[i];
+        batch.pos[i] = i;
+        batch.n_seq_id[i] = 1;
+        batch.seq_id[i][0] = 0;
+        batch.logits[i] = true;
+    }
+    batch.n_tokens = n_tokens;
     
-    const llama_model* m = (const llama_model*)model;
+    llama_memory_clear(llama_get_memory(context), true);
+    if (decode(context, batch) < 0) {
+        llama_batch_free(batch);
+        return -1;
+    }
     
-    static char quant_buf[32];
-    int32_t result = llama_model_meta_val_str(m, "general.quantization_version", quant_buf, sizeof(quant_buf));
+    const int n_embd = llama_model_n_embd(model);
+    for (int c = 0; c < n_spans; c++) {
+        const int start = span_starts[c];
+        const int end = span_ends[c];
+        float* out = embeddings + (size_t)c * n_embd;
+        if (start < 0 || end > n_tokens || start >= end) {
+            llama_batch_free(batch);
+            return -1;
+        }
+        
+        // Mean of the contextualized token embeddings inside the span
+        memset(out, 0, n_embd * sizeof(float));
+        for (int i = start; i < end; i++) {
+            const float* token_embd = llama_get_embeddings_ith(context, i);
+            if (!token_embd) {
+                llama_batch_free(batch);
+                return -1;
+            }
+            for (int k = 0; k < n_embd; k++) out[k] += token_embd[k];
+        }
+        const float scale = 1.0f / (end - start);
+        for (int k = 0; k < n_embd; k++) out[k] *= scale;
+    }
     
-    return (result > 0) ? quant_buf : "fp16";  // Default assumption
+    llama_batch_free(batch);
+    return n_embd;
 }
 
-const char* get_model_family(void* model) {
-    if (!model) return "unknown";
-    
-    const llama_model* m = (const llama_model*)model;
-    
-    static char family_buf[64];
-    int32_t result = llama_model_meta_val_str(m, "general.family", family_buf, sizeof(family_buf));
-    
-    if (result > 0) return family_buf;
-    
-    // Fallback to architecture-based family detection
-    const char* arch = get_model_architecture(model);
-    if (strstr(arch, "llama")) return "llama";
-    if (strstr(arch, "gemma")) return "gemma";
-    if (strstr(arch, "qwen")) return "qwen";
-    if (strstr(arch, "phi")) return "phi";
-    
-    return "unknown";
+void get_special_tokens(void* model, int32_t* bos, int32_t* eos, int32_t* sep) {
+    *bos = *eos = *sep = -1;
+    if (!model) return;
+    
+    const llama_vocab* vocab = llama_model_get_vocab((llama_model*)model);
+    if (llama_vocab_get_add_bos(vocab)) *bos = llama_vocab_bos(vocab);
+    if (llama_vocab_get_add_eos(vocab)) *eos = llama_vocab_eos(vocab);
+    if (llama_vocab_get_add_sep(vocab)) *sep = llama_vocab_sep(vocab);
 }
 
-bool model_supports_images(void* model) {
-    if (!model) return false;
-    
-    const llama_model* m = (const llama_model*)model;
-    
-    // Check if model has vision/image processing capabilities
-    // This is determined by checking for vision-specific layers or metadata
-    const char* arch = get_model_architecture(model);
-    
-    // Common vision-enabled architectures
-    return strstr(arch, "llava") != nullptr ||
-           strstr(arch, "clip") != nullptr ||
-           strstr(arch, "vision") != nullptr ||
-           strstr(arch, "multimodal") != nullptr;
+// Reads a string metadata value into buf, falling back to def when it is missing
+static void read_meta_str(const llama_model* model, const char* key, char* buf, size_t size, const char* def) {
+    if (llama_model_meta_val_str(model, key, buf, size) <= 0) {
+        snprintf(buf, size, "%s", def);
+    }
 }
 
-bool model_supports_audio(void* model) {
-    if (!model) return false;
+void get_model_metadata(void* model, model_metadata* meta) {
+    if (!meta) return;
+    memset(meta, 0, sizeof(*meta));
+    meta->bos_token = -1;
+    if (!model) {
+        snprintf(meta->architecture, sizeof(meta->architecture), "unknown");
+        snprintf(meta->name, sizeof(meta->name), "unknown");
+        snprintf(meta->quantization, sizeof(meta->quantization), "unknown");
+        snprintf(meta->family, sizeof(meta->family), "unknown");
+        return;
+    }
     
     const llama_model* m = (const llama_model*)model;
-    const char* arch = get_model_architecture(model);
+    const llama_vocab* vocab = llama_model_get_vocab(m);
+    
+    read_meta_str(m, "general.architecture", meta->architecture, sizeof(meta->architecture), "llama");
+    read_meta_str(m, "general.name", meta->name, sizeof(meta->name), "unnamed");
+    read_meta_str(m, "general.quantization_version", meta->quantization, sizeof(meta->quantization), "fp16");
+    
+    // Family from metadata, otherwise derived from the architecture
+    if (llama_model_meta_val_str(m, "general.family", meta->family, sizeof(meta->family)) <= 0) {
+        const char* arch = meta->architecture;
+        const char* family = "unknown";
+        if (strstr(arch, "llama")) family = "llama";
+        else if (strstr(arch, "gemma")) family = "gemma";
+        else if (strstr(arch, "qwen")) family = "qwen";
+        else if (strstr(arch, "phi")) family = "phi";
+        snprintf(meta->family, sizeof(meta->family), "%s", family);
+    }
     
-    // Common audio-enabled architectures
-    return strstr(arch, "whisper") != nullptr ||
-           strstr(arch, "audio") != nullptr ||
-           strstr(arch, "speech") != nullptr;
+    meta->parameter_count = (int64_t)llama_model_n_params(m);
+    meta->context_size = llama_model_n_ctx_train(m);
+    meta->embedding_size = llama_model_n_embd(m);
+    
+    // Only report BOS when the vocab would add it during tokenization
+    if (llama_vocab_get_add_bos(vocab)) meta->bos_token = llama_vocab_bos(vocab);
+    
+    // Vision and audio capable architectures
+    const char* arch = meta->architecture;
+    meta->supports_images = strstr(arch, "llava") != nullptr ||
+                            strstr(arch, "clip") != nullptr ||
+                            strstr(arch, "vision") != nullptr ||
+                            strstr(arch, "multimodal") != nullptr;
+    meta->supports_audio = strstr(arch, "whisper") != nullptr ||
+                           strstr(arch, "audio") != nullptr ||
+                           strstr(arch, "speech") != nullptr;
 }
 
 } // extern "C"
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define BINDING_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,16 +13,101 @@ void* load_model(const char *fname, int n_ctx, int n_threads, int n_gpu_layers,
 void* load_embedding_model(const char *fname, int n_ctx, int n_threads, int n_gpu_layers, bool use_mmap, bool use_mlock);
 void free_model(void* model);
 
+// Shared CPU threadpool: contexts created afterwards compute on one ggml threadpool of
+// n_threads (physical cores if <= 0) instead of starting their own threads. poll is
+// how hard idle threads spin before sleeping, 0-100. The pool is paused while no
+// context exists and runs one graph at a time. Returns its thread count, 0 on failure.
+int threadpool_init(int n_threads, int poll);
+
 // Context management  
 void* new_context(void* model, int n_ctx, int n_threads);
-void* new_embedding_context(void* model, int n_ctx, int n_threads);
+void* new_context_seqs(void* model, int n_ctx, int n_threads, int n_seq);
+void* new_embedding_context(void* model, int n_ctx, int n_threads, int pooling_type, int n_seq);
 void free_context(void* ctx);
 void clear_context(void* ctx);
 
-// Text generation
-int llama_predict(void* ctx, const char* prompt, char* result, int result_size,
-                  int max_tokens, float temperature, float top_p, int top_k,
-                  float repeat_penalty, int repeat_last_n, bool use_penalty);
+// Text generation. Generation functions take an optional cancel flag (NULL for none)
+// that another thread sets non-zero to stop decoding within a step.
+
+// Called with each generated piece of text; return false to stop generation
+typedef bool (*token_callback)(uintptr_t user_data, const char* piece, int len);
+
+// Reasoning phase tracking and token budget for thinking models
+typedef struct {
+    int max_tokens;             // Reasoning token budget, -1 for unlimited
+    const char* start_marker;   // Output prefix that opens reasoning, empty if output starts reasoning
+    const char* end_marker;     // Text that closes reasoning and starts the answer
+    const char* force_text;     // Injected when the budget is spent to switch to the answer
+    int reasoning_tokens;       // Out: tokens generated before the answer started
+    bool forced;                // Out: whether the budget cut reasoning short
+} reasoning_budget;
+
+// Per-token log-probabilities of generated tokens in flat arrays
+typedef struct {
+    int top_n;              // Alternatives per token, 0 for the sampled token only
+    int capacity;           // Tokens the arrays have room for
+    int32_t* tokens;        // [capacity] sampled tokens
+    float* logprobs;        // [capacity] log-probability of each sampled token
+    int32_t* top_tokens;    // [capacity * top_n] most likely tokens per step, best first
+    float* top_logprobs;    // [capacity * top_n] their log-probabilities
+    int n;                  // Out: tokens written
+} logprob_output;
+
+// Arguments and results of one generation, passed in a single call. The struct and
+// everything it points to must be C memory; reasoning and logprobs are held by value.
+typedef struct {
+    const int32_t* tokens;      // Pre-assembled prompt tokens
+    int n_tokens;
+    char* result;               // Receives the generated text, NUL terminated
+    int result_size;
+    int max_tokens;
+    float temperature;
+    float top_p;
+    int top_k;
+    float repeat_penalty;
+    int repeat_last_n;
+    bool use_penalty;
+    token_callback on_token;    // Optional, streams generated pieces
+    uintptr_t user_data;
+    const int32_t* cancel;      // Optional cancel flag
+    bool use_reasoning;         // Track reasoning and enforce its budget
+    reasoning_budget reasoning;
+    bool use_logprobs;          // Record log-probabilities of generated tokens
+    logprob_output logprobs;
+    int tokens_out;             // Out: tokens generated, -1 on failure
+    int result_len;             // Out: bytes of text written to result
+} predict_request;
+
+// Generation from a pre-assembled prompt token sequence, returns req->tokens_out
+int llama_predict_request(void* ctx, predict_request* req);
+
+// Called on an executor callback thread with the result of an asynchronous job
+typedef void (*job_callback)(uintptr_t user_data, int result);
+
+// Starts the native executor with n_workers generation threads for the life of the
+// process. Further calls are no-ops. Returns false if n_workers is not positive.
+bool executor_start(int n_workers);
+
+// Queues llama_predict_request(ctx, req) on the executor. req must stay valid until
+// on_done is called. Returns false without queueing if the executor is not running.
+bool llama_predict_request_async(void* ctx, predict_request* req, job_callback on_done, uintptr_t user_data);
+
+// Multi-sample generation: the prompt is prefilled once and its KV shared by n_samples
+// sequences decoded in one batch. Sample i is written to result + i * result_size and
+// its token count and summed log-probability to sample_tokens[i] and sample_logprobs[i].
+// Returns the tokens generated over all samples, or -1 if any decode failed.
+int llama_predict_samples(void* ctx, const int32_t* tokens, int n_tokens, int n_samples,
+                          char* result, int result_size, int* sample_tokens, float* sample_logprobs,
+                          int max_tokens, float temperature, float top_p, int top_k, uint32_t seed,
+                          const int32_t* cancel);
+
+// Candidate scoring: the prompt is prefilled once and its KV shared by n_candidates
+// sequences whose tokens are decoded together. Candidate i has cand_lens[i] tokens
+// in cand_tokens and its summed log-probability given the prompt goes to scores[i].
+// Returns the number of candidate tokens scored or -1 on failure.
+int llama_score_candidates(void* ctx, const int32_t* tokens, int n_tokens,
+                           const int32_t* cand_tokens, const int* cand_lens, int n_candidates,
+                           float* scores);
 
 // Grammar-constrained generation
 int llama_predict_with_grammar(void* ctx, const char* prompt, char* result, int result_size,
@@ -31,23 +117,84 @@ int llama_predict_with_grammar(void* ctx, const char* prompt, char* result, int
 
 // Token utilities
 int count_tokens(void* ctx, const char* text);
-int get_context_size(void* model);
+int tokenize_text(void* model, const char* text, int text_len, bool add_special, bool parse_special,
+                  int32_t* tokens, int max_tokens);
+int token_to_piece(void* model, int32_t token, char* buf, int buf_size);
+// Whether text is split at token when special tokens are parsed, so the text on
+// either side of it tokenizes independently
+bool token_is_special(void* model, int32_t token);
 
-// GPU/Metal detection
+// Chat template rendering with the model's embedded tokenizer.chat_template
+int chat_apply_template(void* model, const char** roles, const char** contents, int n_messages,
+                        bool add_assistant, char* buf, int buf_size);
+
+// Compute backends. With GGML_BACKEND_DL, backend libraries are loaded from dir (next to
+// the executable if NULL or empty) and the best CPU variant for the host is chosen.
+// Must run before models are loaded; without dynamic backends it does nothing.
+void backends_load(const char* dir);
+
+// A device of the ggml backend registry
+typedef struct {
+    char name[64];
+    char description[128];
+    char backend[32];           // Backend registry the device belongs to
+    char type[8];               // cpu, gpu, igpu or accel
+    uint64_t memory_total;
+} compute_device;
+
+// A feature flag a backend was built with, e.g. CPU AVX2=1
+typedef struct {
+    char backend[32];
+    char name[32];
+    char value[32];
+} backend_feature;
+
+// Write up to max entries and return the total available
+int compute_devices(compute_device* out, int max);
+int backend_features(backend_feature* out, int max);
+
+// Whether a GPU device is registered
 bool has_gpu_support();
 
 // Embedding generation
 int llama_embedding(void* ctx, const char* text, float* embeddings, int max_embeddings);
-int get_embedding_size(void* model);
-
-// Model introspection
-const char* get_model_architecture(void* model);
-const char* get_model_name(void* model);
-int get_model_parameter_count(void* model);
-const char* get_model_quantization(void* model);
-const char* get_model_family(void* model);
-bool model_supports_images(void* model);
-bool model_supports_audio(void* model);
+
+// Batched pooled embeddings: n_seqs sequences laid out back to back in tokens with
+// lengths seq_lens are decoded in as few batches as n_batch and n_seq_max allow. The
+// first out_size values of the pooled output of sequence i go to out + i * out_size.
+// Returns tokens decoded or -1 on failure.
+int llama_embed_sequences(void* ctx, const int32_t* tokens, const int* seq_lens, int n_seqs,
+                          float* out, int out_size);
+
+// Reranking with a rank-pooled context: query-document sequences as for
+// llama_embed_sequences, the relevance score of sequence i is written to scores[i]
+int llama_rerank(void* ctx, const int32_t* tokens, const int* seq_lens, int n_seqs, float* scores);
+
+// Late chunking: tokens are encoded once with a pooling-free context and chunk i is the
+// mean of the token embeddings in [span_starts[i], span_ends[i]), written to
+// embeddings + i * n_embd. Returns n_embd or -1 on failure.
+int llama_embedding_spans(void* ctx, const int32_t* tokens, int n_tokens,
+                          const int* span_starts, const int* span_ends, int n_spans, float* embeddings);
+
+// Special tokens the vocabulary adds around tokenized text, -1 for those it does not add
+void get_special_tokens(void* model, int32_t* bos, int32_t* eos, int32_t* sep);
+
+// Model introspection, read once at load into caller-owned memory
+typedef struct {
+    char architecture[64];
+    char name[128];
+    char quantization[32];
+    char family[64];
+    int64_t parameter_count;
+    int context_size;           // Training context length
+    int embedding_size;
+    int32_t bos_token;          // -1 if the vocabulary has none
+    bool supports_images;
+    bool supports_audio;
+} model_metadata;
+
+// Fills meta from the model's GGUF metadata. Thread-safe, uses no static buffers.
+void get_model_metadata(void* model, model_metadata* meta);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,77 @@
+package llama
+
+/*
+#include <stdint.h>
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"context"
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+// cancelFlag is a C-allocated flag raised when a request context is done. The decode
+// loops check it every step and llama.cpp polls it during graph compute, so generation
+// for a disconnected client or cancelled request stops within one token.
+type cancelFlag struct {
+	ctx  context.Context
+	mu   sync.Mutex // Guards flag against being raised after it is freed
+	flag *C.int32_t
+	stop func() bool
+}
+
+// newCancelFlag returns a flag raised when ctx is done, nil for contexts that never are
+func newCancelFlag(ctx context.Context) *cancelFlag {
+	if ctx == nil || ctx.Done() == nil {
+		return nil
+	}
+
+	f := &cancelFlag{
+		ctx:  ctx,
+		flag: (*C.int32_t)(C.calloc(1, C.size_t(unsafe.Sizeof(C.int32_t(0))))),
+	}
+	f.stop = context.AfterFunc(ctx, f.raise)
+	return f
+}
+
+func (f *cancelFlag) raise() {
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	if f.flag != nil {
+		atomic.StoreInt32((*int32)(unsafe.Pointer(f.flag)), 1)
+	}
+}
+
+// ptr returns the flag to pass to the binding, NULL when there is none
+func (f *cancelFlag) ptr() *C.int32_t {
+	if f == nil {
+		return nil
+	}
+	return f.flag
+}
+
+// err reports the cancellation of a generation that was stopped by the flag
+func (f *cancelFlag) err() error {
+	if f == nil {
+		return nil
+	}
+	if err := f.ctx.Err(); err != nil {
+		return fmt.Errorf("generation cancelled: %w", err)
+	}
+	return nil
+}
+
+func (f *cancelFlag) free() {
+	if f == nil {
+		return
+	}
+	f.stop()
+
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	C.free(unsafe.Pointer(f.flag))
+	f.flag = nil
+}
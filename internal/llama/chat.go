@@ -0,0 +1,430 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"container/list"
+	"context"
+	"fmt"
+	"hash/fnv"
+	"log/slog"
+	"path/filepath"
+	"strings"
+	"sync"
+	"unsafe"
+
+	"github.com/aigoflow/inference-service/internal/harmony"
+)
+
+// ChatMessage is a single turn of a multi-turn conversation
+type ChatMessage struct {
+	Role    string `json:"role"`
+	Content string `json:"content"`
+}
+
+// chatRenderer renders a conversation into prompt text. Turn-level token caching
+// expects the text through each message's content not to change when turns are
+// appended; cached turns are verified against the rendered text before they are reused.
+type chatRenderer interface {
+	Name() string
+	Render(messages []ChatMessage, addAssistant bool) (string, error)
+}
+
+// ggufChatRenderer renders with the model's embedded tokenizer.chat_template
+type ggufChatRenderer struct {
+	model unsafe.Pointer
+}
+
+func (r *ggufChatRenderer) Name() string {
+	return "gguf"
+}
+
+func (r *ggufChatRenderer) Render(messages []ChatMessage, addAssistant bool) (string, error) {
+	n := len(messages)
+	if n == 0 {
+		return "", nil
+	}
+
+	// Build C arrays of role and content strings
+	ptrSize := C.size_t(unsafe.Sizeof(uintptr(0)))
+	rolesPtr := C.malloc(C.size_t(n) * ptrSize)
+	contentsPtr := C.malloc(C.size_t(n) * ptrSize)
+	defer C.free(rolesPtr)
+	defer C.free(contentsPtr)
+
+	roles := unsafe.Slice((**C.char)(rolesPtr), n)
+	contents := unsafe.Slice((**C.char)(contentsPtr), n)
+	size := 1024
+	for i, message := range messages {
+		roles[i] = C.CString(message.Role)
+		contents[i] = C.CString(message.Content)
+		size += 2 * (len(message.Role) + len(message.Content))
+	}
+	defer func() {
+		for i := 0; i < n; i++ {
+			C.free(unsafe.Pointer(roles[i]))
+			C.free(unsafe.Pointer(contents[i]))
+		}
+	}()
+
+	for attempt := 0; attempt < 2; attempt++ {
+		buf := make([]byte, size)
+		written := int(C.chat_apply_template(r.model, (**C.char)(rolesPtr), (**C.char)(contentsPtr), C.int(n),
+			C.bool(addAssistant), (*C.char)(unsafe.Pointer(&buf[0])), C.int(len(buf))))
+		if written < 0 {
+			return "", fmt.Errorf("model chat template is missing or not supported")
+		}
+		if written <= len(buf) {
+			return string(buf[:written]), nil
+		}
+
+		// Rendered prompt did not fit, retry with the exact size
+		size = written
+	}
+
+	return "", fmt.Errorf("chat template rendering did not converge")
+}
+
+// harmonyChatRenderer renders conversations in GPT-OSS Harmony format
+type harmonyChatRenderer struct {
+	config map[string]interface{}
+}
+
+func (r *harmonyChatRenderer) Name() string {
+	return "harmony"
+}
+
+func (r *harmonyChatRenderer) Render(messages []ChatMessage, addAssistant bool) (string, error) {
+	reasoningLevel := harmony.ReasoningMedium
+	if level, ok := r.config["reasoning_level"].(string); ok {
+		switch level {
+		case "low":
+			reasoningLevel = harmony.ReasoningLow
+		case "high":
+			reasoningLevel = harmony.ReasoningHigh
+		}
+	}
+
+	builder := harmony.NewConversationBuilder().
+		WithReasoningLevel(reasoningLevel)
+	if identity, ok := r.config["model_identity"].(string); ok {
+		builder = builder.WithModelIdentity(identity)
+	}
+
+	for _, message := range messages {
+		switch message.Role {
+		case "system", "developer":
+			// Harmony carries caller instructions in the developer message
+			builder = builder.AddDeveloperMessage(message.Content)
+		case "assistant":
+			// Prior answers are replayed on the final channel
+			builder = builder.AddChannelMessage(harmony.RoleAssistant, harmony.ChannelFinal, message.Content)
+		default:
+			builder = builder.AddMessage(harmony.Role(message.Role), message.Content)
+		}
+	}
+
+	formatter := harmony.NewHarmonyFormatter()
+	conversation := builder.Build()
+
+	var fragments []harmony.PromptFragment
+	if addAssistant {
+		fragments = formatter.FormatConversationFragments(conversation)
+	} else {
+		fragments = formatter.FormatHistoryFragments(conversation)
+	}
+
+	rendered := make([]PromptFragment, len(fragments))
+	for i, fragment := range fragments {
+		rendered[i] = PromptFragment{Text: fragment.Text, Fixed: fragment.Fixed}
+	}
+	return joinFragments(rendered), nil
+}
+
+// chatTurn is the cached rendering of one message given its conversation prefix
+type chatTurn struct {
+	key       uint64  // Hash of all messages up to and including this one
+	renderEnd int     // Offset in the rendered conversation where this turn ends
+	deltaHash uint64  // Hash of the rendered text since the previous turn, verified on reuse
+	tokens    []int32 // Tokens of that text
+}
+
+// chatTurnCache is an LRU of per-turn token deltas keyed by conversation prefix, so
+// appending a turn to a known conversation only tokenizes the new turn
+type chatTurnCache struct {
+	mu       sync.Mutex
+	capacity int
+	order    *list.List
+	entries  map[uint64]*list.Element
+}
+
+func newChatTurnCache(capacity int) *chatTurnCache {
+	return &chatTurnCache{
+		capacity: capacity,
+		order:    list.New(),
+		entries:  make(map[uint64]*list.Element),
+	}
+}
+
+func (c *chatTurnCache) get(key uint64) (*chatTurn, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if elem, ok := c.entries[key]; ok {
+		c.order.MoveToFront(elem)
+		return elem.Value.(*chatTurn), true
+	}
+	return nil, false
+}
+
+func (c *chatTurnCache) put(turn *chatTurn) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if elem, ok := c.entries[turn.key]; ok {
+		elem.Value = turn
+		c.order.MoveToFront(elem)
+		return
+	}
+	c.entries[turn.key] = c.order.PushFront(turn)
+	for c.order.Len() > c.capacity {
+		oldest := c.order.Back()
+		c.order.Remove(oldest)
+		delete(c.entries, oldest.Value.(*chatTurn).key)
+	}
+}
+
+// chatPrefixKeys returns one chained hash per conversation prefix
+func chatPrefixKeys(rendererName string, messages []ChatMessage) []uint64 {
+	h := fnv.New64a()
+	h.Write([]byte(rendererName))
+	keys := make([]uint64, len(messages))
+	for i, message := range messages {
+		h.Write([]byte{0})
+		h.Write([]byte(message.Role))
+		h.Write([]byte{0})
+		h.Write([]byte(message.Content))
+		keys[i] = h.Sum64()
+	}
+	return keys
+}
+
+func hashString(s string) uint64 {
+	h := fnv.New64a()
+	h.Write([]byte(s))
+	return h.Sum64()
+}
+
+// chatRenderer selects the renderer for the configured prompt format
+func (m *Model) chatRenderer() chatRenderer {
+	if m.sysConfig != nil && m.sysConfig.ModelFormat == "harmony" {
+		return &harmonyChatRenderer{config: m.sysConfig.FormatConfig}
+	}
+	return &ggufChatRenderer{model: m.model}
+}
+
+// withDefaultSystem prepends the template system prompt when the conversation has none
+func (m *Model) withDefaultSystem(messages []ChatMessage) []ChatMessage {
+	for _, message := range messages {
+		if message.Role == "system" || message.Role == "developer" {
+			return messages
+		}
+	}
+
+	template, err := loadTemplate(filepath.Dir(m.config.ModelPath))
+	if err != nil || template == nil || template.SystemRole == "" {
+		return messages
+	}
+
+	withSystem := make([]ChatMessage, 0, len(messages)+1)
+	withSystem = append(withSystem, ChatMessage{Role: "system", Content: template.SystemRole})
+	return append(withSystem, messages...)
+}
+
+// chatPromptTokens renders a conversation once and assembles its prompt tokens. The
+// rendered text is split into turns at the end of each message's content, and the
+// token deltas of turns already seen with the same conversation prefix are reused, so
+// a follow-up turn only tokenizes the text it appends.
+func (m *Model) chatPromptTokens(renderer chatRenderer, messages []ChatMessage) ([]int32, string, error) {
+	formatted, err := renderer.Render(messages, true)
+	if err != nil {
+		return nil, "", err
+	}
+	keys := chatPrefixKeys(renderer.Name(), messages)
+	ends := chatTurnEnds(formatted, messages)
+
+	tokens := make([]int32, 0, 256)
+	prevEnd := 0
+
+	// Reuse the longest cached conversation prefix the template still renders the same
+	cached := 0
+	for cached < len(ends) {
+		turn, ok := m.chatTurns.get(keys[cached])
+		if !ok || turn.renderEnd != ends[cached] || hashString(formatted[prevEnd:turn.renderEnd]) != turn.deltaHash {
+			break
+		}
+		tokens = append(tokens, turn.tokens...)
+		prevEnd = turn.renderEnd
+		cached++
+	}
+
+	// Tokenize only the new turns
+	for i := cached; i < len(ends); i++ {
+		delta, err := m.tokenize(formatted[prevEnd:ends[i]], false, true)
+		if err != nil {
+			return nil, "", err
+		}
+		m.chatTurns.put(&chatTurn{
+			key:       keys[i],
+			renderEnd: ends[i],
+			deltaHash: hashString(formatted[prevEnd:ends[i]]),
+			tokens:    delta,
+		})
+		tokens = append(tokens, delta...)
+		prevEnd = ends[i]
+	}
+
+	// The end of the last turn and the generation prompt
+	tail, err := m.tokenize(formatted[prevEnd:], false, true)
+	if err != nil {
+		return nil, "", err
+	}
+	tokens = append(tokens, tail...)
+
+	slog.Debug("Chat prompt assembled",
+		"renderer", renderer.Name(),
+		"messages", len(messages),
+		"cached_turns", cached,
+		"tokens", len(tokens))
+
+	return m.withBOS(tokens), formatted, nil
+}
+
+// chatTurnEnds returns the offset just past each message's content in the rendered
+// conversation. A content only counts where it ends right before special token markup
+// such as <|im_end|> or <end_of_turn>, or at the end of the text, and does not start
+// inside markup, so short contents cannot match inside the markup or role names the
+// template emits and turns never split a special token. Turns after a message without
+// such a match have no offset and are tokenized with the tail.
+func chatTurnEnds(formatted string, messages []ChatMessage) []int {
+	ends := make([]int, 0, len(messages))
+	pos := 0
+	for _, message := range messages {
+		end := contentEnd(formatted, pos, message.Content)
+		if end < 0 {
+			break
+		}
+		pos = end
+		ends = append(ends, pos)
+	}
+	return ends
+}
+
+// contentEnd returns the end of the first match of content at or after pos that ends
+// at markup, -1 if there is none. Blank contents have no position of their own, they
+// would match the whitespace between turns.
+func contentEnd(formatted string, pos int, content string) int {
+	if strings.TrimSpace(content) == "" {
+		return -1
+	}
+	for {
+		i := strings.Index(formatted[pos:], content)
+		if i < 0 {
+			return -1
+		}
+		start := pos + i
+		end := start + len(content)
+		if !insideMarkup(formatted, start) && (end == len(formatted) || markupLen(formatted[end:]) > 0) {
+			return end
+		}
+		pos = start + 1
+	}
+}
+
+// markupLen returns the length of the special token markup at the start of s, such as
+// <|im_end|>, <start_of_turn> or </s>, 0 if s does not start with markup
+func markupLen(s string) int {
+	if len(s) < 3 || s[0] != '<' {
+		return 0
+	}
+	for i := 1; i < len(s); i++ {
+		switch s[i] {
+		case '>':
+			if i == 1 {
+				return 0
+			}
+			return i + 1
+		case '<', ' ', '\t', '\n', '\r':
+			return 0
+		}
+	}
+	return 0
+}
+
+// insideMarkup reports whether offset i falls strictly inside special token markup
+func insideMarkup(s string, i int) bool {
+	open := strings.LastIndexByte(s[:i], '<')
+	if open < 0 {
+		return false
+	}
+	n := markupLen(s[open:])
+	return n > 0 && open+n > i
+}
+
+// withBOS prepends BOS unless the rendered template already starts with it
+func (m *Model) withBOS(tokens []int32) []int32 {
+	if m.info.bosToken < 0 || (len(tokens) > 0 && tokens[0] == m.info.bosToken) {
+		return tokens
+	}
+	return append([]int32{m.info.bosToken}, tokens...)
+}
+
+// GenerateChat renders a multi-turn conversation with the model's chat template and
+// generates the next assistant turn
+func (m *Model) GenerateChat(messages []ChatMessage, params map[string]interface{}) (text string, tokensIn, tokensOut int, formattedInput string, err error) {
+	gen, err := m.GenerateChatStream(context.Background(), messages, params, nil)
+	return gen.Text, gen.TokensIn, gen.TokensOut, gen.FormattedInput, err
+}
+
+// GenerateChatStream generates like GenerateChat and passes response text to onText
+// as it is generated. Decoding stops when ctx is done.
+func (m *Model) GenerateChatStream(ctx context.Context, messages []ChatMessage, params map[string]interface{}, onText TextCallback) (gen Generation, err error) {
+	defer func() {
+		if r := recover(); r != nil {
+			slog.Error("Chat inference panic recovered", "error", r)
+			gen, err = Generation{}, fmt.Errorf("chat inference panic: %v", r)
+		}
+	}()
+
+	if m.model == nil {
+		return gen, fmt.Errorf("model is nil")
+	}
+	if len(messages) == 0 {
+		return gen, fmt.Errorf("no messages provided")
+	}
+
+	promptTokens, formattedInput, err := m.chatPromptTokens(m.chatRenderer(), m.withDefaultSystem(messages))
+	gen.FormattedInput = formattedInput
+	if err != nil {
+		return gen, fmt.Errorf("failed to render chat prompt: %w", err)
+	}
+	gen.TokensIn = len(promptTokens)
+
+	cancel := newCancelFlag(ctx)
+	defer cancel.free()
+
+	// Several completions share one prompt prefill
+	p := parseParams(params)
+	if p.n > 1 {
+		return gen, m.generateSamples(promptTokens, p, cancel, &gen)
+	}
+
+	stream := m.newOutputStream(p, onText)
+	if err := m.generateFromTokens(promptTokens, p, stream, cancel, &gen); err != nil {
+		return gen, err
+	}
+
+	gen.Text = stream.finish(gen.Text)
+	return gen, nil
+}
@@ -0,0 +1,136 @@
+package llama
+
+import (
+	"strings"
+	"testing"
+)
+
+var testConversation = []ChatMessage{
+	{Role: "system", Content: "You are a helpful assistant."},
+	{Role: "user", Content: "What is the capital of France?"},
+	{Role: "assistant", Content: "Paris."},
+	{Role: "user", Content: "And of Italy?"},
+}
+
+// renderChatML renders like a ChatML chat template
+func renderChatML(messages []ChatMessage, addAssistant bool) string {
+	var b strings.Builder
+	for _, message := range messages {
+		b.WriteString("<|im_start|>" + message.Role + "\n" + message.Content + "<|im_end|>\n")
+	}
+	if addAssistant {
+		b.WriteString("<|im_start|>assistant\n")
+	}
+	return b.String()
+}
+
+func TestChatTurnEnds(t *testing.T) {
+	formatted := renderChatML(testConversation, true)
+	ends := chatTurnEnds(formatted, testConversation)
+	if len(ends) != len(testConversation) {
+		t.Fatalf("got %d turn ends, want %d", len(ends), len(testConversation))
+	}
+	for i, end := range ends {
+		content := testConversation[i].Content
+		if !strings.HasSuffix(formatted[:end], content) {
+			t.Errorf("turn %d ends at %d, not after %q", i, end, content)
+		}
+	}
+
+	// A content the template rewrote ends the cacheable turns
+	rewritten := strings.Replace(formatted, "Paris.", "Paris", 1)
+	if ends := chatTurnEnds(rewritten, testConversation); len(ends) != 2 {
+		t.Errorf("got %d turn ends past a rewritten message, want 2", len(ends))
+	}
+}
+
+// TestChatTurnEndsStable checks that a follow-up request splits the turns it shares
+// with an earlier request at the same offsets over the same text, which is what lets
+// their token deltas be reused
+func TestChatTurnEndsStable(t *testing.T) {
+	renderers := map[string]func([]ChatMessage) string{
+		"chatml": func(messages []ChatMessage) string { return renderChatML(messages, true) },
+		"harmony": func(messages []ChatMessage) string {
+			rendered, _ := (&harmonyChatRenderer{}).Render(messages, true)
+			return rendered
+		},
+	}
+
+	for name, render := range renderers {
+		for n := 1; n < len(testConversation); n++ {
+			earlier := render(testConversation[:n])
+			later := render(testConversation)
+			earlierEnds := chatTurnEnds(earlier, testConversation[:n])
+			laterEnds := chatTurnEnds(later, testConversation)
+			if len(earlierEnds) != n {
+				t.Fatalf("%s: got %d turn ends for %d messages", name, len(earlierEnds), n)
+			}
+			for i, end := range earlierEnds {
+				if laterEnds[i] != end || later[:end] != earlier[:end] {
+					t.Errorf("%s: turn %d of %d messages is not reused by the longer conversation", name, i, n)
+				}
+			}
+		}
+	}
+}
+
+// renderGemma renders like a Gemma chat template
+func renderGemma(messages []ChatMessage, addAssistant bool) string {
+	var b strings.Builder
+	b.WriteString("<bos>")
+	for _, message := range messages {
+		b.WriteString("<start_of_turn>" + message.Role + "\n" + message.Content + "<end_of_turn>\n")
+	}
+	if addAssistant {
+		b.WriteString("<start_of_turn>model\n")
+	}
+	return b.String()
+}
+
+// TestChatTurnEndsMarkup checks that contents which also occur in the template's
+// markup or role names are found where the template rendered them
+func TestChatTurnEndsMarkup(t *testing.T) {
+	conversations := [][]ChatMessage{
+		// One-character contents
+		{{Role: "system", Content: "a"}, {Role: "user", Content: "t"}, {Role: "assistant", Content: "s"}, {Role: "user", Content: "|"}},
+		// Contents that are role names or parts of special tokens
+		{{Role: "user", Content: "user"}, {Role: "assistant", Content: "art"}, {Role: "user", Content: "im_end"}, {Role: "assistant", Content: "start_of_turn"}},
+		{{Role: "user", Content: "<|im_start|>"}, {Role: "assistant", Content: "end|>"}, {Role: "user", Content: ">"}},
+	}
+	renderers := map[string]struct {
+		render func([]ChatMessage, bool) string
+		open   func(role string) string
+	}{
+		"chatml": {renderChatML, func(role string) string { return "<|im_start|>" + role + "\n" }},
+		"gemma":  {renderGemma, func(role string) string { return "<start_of_turn>" + role + "\n" }},
+	}
+
+	for name, r := range renderers {
+		for _, messages := range conversations {
+			formatted := r.render(messages, true)
+			ends := chatTurnEnds(formatted, messages)
+			if len(ends) != len(messages) {
+				t.Errorf("%s: got %d turn ends for %q, want %d", name, len(ends), formatted, len(messages))
+				continue
+			}
+			for i, end := range ends {
+				// The content ends where the template rendered it
+				want := len(r.render(messages[:i], false)) + len(r.open(messages[i].Role)) + len(messages[i].Content)
+				if end != want {
+					t.Errorf("%s: turn %d of %q ends at %d, want %d", name, i, formatted, end, want)
+				}
+				if insideMarkup(formatted, end) {
+					t.Errorf("%s: turn %d of %q ends inside markup", name, i, formatted)
+				}
+			}
+		}
+	}
+
+	// A blank content ends the cacheable turns instead of matching between turns
+	for _, blank := range []string{"", "\n"} {
+		messages := []ChatMessage{{Role: "user", Content: "hi"}, {Role: "assistant", Content: blank}, {Role: "user", Content: "hi"}}
+		if ends := chatTurnEnds(renderChatML(messages, true), messages); len(ends) != 1 {
+			t.Errorf("got turn ends %v past the blank content %q", ends, blank)
+		}
+	}
+}
@@ -0,0 +1,504 @@
+package llama
+
+/*
+#include "binding.h"
+*/
+import "C"
+import (
+	"fmt"
+	"log/slog"
+	"sort"
+	"unicode/utf8"
+	"unsafe"
+)
+
+// maxBatchSeqs bounds the sequences decoded together in one embedding or rerank batch
+const maxBatchSeqs = 64
+
+// defaultChunkOverlap is the token overlap between windows of inputs longer than the context
+const defaultChunkOverlap = 64
+
+// EmbeddingOptions adjust how the embeddings of one request are pooled
+type EmbeddingOptions struct {
+	Pooling      string   // Overrides POOLING_TYPE for this request: mean, cls, last or none
+	Spans        [][2]int // Late chunking: character spans [start, end) of the input to embed
+	ChunkOverlap int      // Tokens shared by consecutive windows of over-long inputs, -1 for the default
+	SplitChunks  bool     // Return the windows of over-long inputs instead of their weighted mean
+}
+
+// ChunkEmbedding is the embedding of an input or of one span of it
+type ChunkEmbedding struct {
+	Embedding []float32
+	Span      []int // Character span of a late chunk, nil for whole-input embeddings
+	TokenSpan []int // Token span of a context window when windows are returned individually
+}
+
+// Embeddings is the result of embedding one input
+type Embeddings struct {
+	Chunks   []ChunkEmbedding
+	TokensIn int
+	Windows  int // Context windows the input was encoded in, more than 1 if it was split
+}
+
+// GenerateEmbeddings embeds one input with per-request options, see GenerateEmbeddingsBatch
+func (m *Model) GenerateEmbeddings(input string, opts EmbeddingOptions) (Embeddings, error) {
+	results, err := m.GenerateEmbeddingsBatch([]string{input}, opts)
+	if err != nil {
+		return Embeddings{}, err
+	}
+	return results[0], nil
+}
+
+// GenerateEmbeddingsBatch embeds inputs with per-request options and returns results in
+// input order. Without spans every input gets a single pooled embedding; inputs longer
+// than the context are split into overlapping windows combined by a token-weighted
+// mean. All inputs are tokenized up front and their sequences packed by length into as
+// few decodes of one context as possible. With spans an input is encoded once and every
+// span is mean pooled from its contextualized token embeddings (late chunking); pooling
+// none returns one embedding per token.
+func (m *Model) GenerateEmbeddingsBatch(inputs []string, opts EmbeddingOptions) ([]Embeddings, error) {
+	pooling := m.pooling
+	if opts.Pooling != "" {
+		var err error
+		if pooling, err = parsePoolingType(opts.Pooling, false); err != nil {
+			return nil, err
+		}
+		if pooling == poolingRank || m.pooling == poolingRank {
+			return nil, fmt.Errorf("rank pooling cannot be combined with embeddings")
+		}
+	}
+
+	if len(opts.Spans) == 0 && pooling != poolingNone {
+		return m.windowedEmbeddings(inputs, pooling, opts)
+	}
+
+	results := make([]Embeddings, len(inputs))
+	for i, input := range inputs {
+		chunks, tokensIn, err := m.lateChunkEmbeddings(input, opts.Spans)
+		if err != nil {
+			return nil, fmt.Errorf("input %d: %w", i, err)
+		}
+		results[i] = Embeddings{Chunks: chunks, TokensIn: tokensIn, Windows: 1}
+	}
+	return results, nil
+}
+
+// embeddingWindows holds the token sequences one input is encoded in
+type embeddingWindows struct {
+	seqs       [][]int32
+	spans      [][2]int // Content token span of each window
+	contentLen int
+	tokensIn   int
+}
+
+// packedSeq is one window of one input queued for a batched decode
+type packedSeq struct {
+	input  int
+	window int
+	tokens []int32
+}
+
+// windowedEmbeddings embeds every input as one sequence, or as overlapping windows of
+// at most the context size when it is longer
+func (m *Model) windowedEmbeddings(inputs []string, pooling int, opts EmbeddingOptions) (results []Embeddings, err error) {
+	defer func() {
+		if r := recover(); r != nil {
+			slog.Error("Embedding generation panic recovered", "error", r)
+			results, err = nil, fmt.Errorf("embedding panic: %v", r)
+		}
+	}()
+
+	if m.model == nil {
+		return nil, fmt.Errorf("model is nil")
+	}
+	if m.pooling == poolingRank {
+		return nil, fmt.Errorf("model is configured for reranking")
+	}
+
+	overlap := opts.ChunkOverlap
+	if overlap < 0 {
+		overlap = m.chunkOverlap()
+	}
+
+	plans := make([]embeddingWindows, len(inputs))
+	var seqs []packedSeq
+	for i, input := range inputs {
+		if plans[i], err = m.planWindows(input, overlap); err != nil {
+			return nil, fmt.Errorf("input %d: %w", i, err)
+		}
+		for w, tokens := range plans[i].seqs {
+			seqs = append(seqs, packedSeq{input: i, window: w, tokens: tokens})
+		}
+	}
+
+	// Lay out sequences in packed order, the binding batches them in this order
+	seqs = packSequences(seqs, m.config.CtxSize, maxBatchSeqs)
+	var tokens []int32
+	seqLens := make([]C.int, len(seqs))
+	for k, seq := range seqs {
+		tokens = append(tokens, seq.tokens...)
+		seqLens[k] = C.int(len(seq.tokens))
+	}
+
+	embeddings, err := m.embedSequences(tokens, seqLens, pooling)
+	if err != nil {
+		return nil, err
+	}
+
+	windowEmbeddings := make([][][]float32, len(inputs))
+	for i := range plans {
+		windowEmbeddings[i] = make([][]float32, len(plans[i].seqs))
+	}
+	for k, seq := range seqs {
+		windowEmbeddings[seq.input][seq.window] = embeddings[k]
+	}
+
+	results = make([]Embeddings, len(inputs))
+	for i := range plans {
+		results[i] = plans[i].combine(windowEmbeddings[i], opts.SplitChunks)
+	}
+
+	slog.Debug("Embedded batch", "inputs", len(inputs), "sequences", len(seqs), "tokens", len(tokens))
+	return results, nil
+}
+
+// planWindows tokenizes input and splits it into windows of at most the context size
+// that repeat the special tokens around consecutive, overlapping content slices
+func (m *Model) planWindows(input string, overlap int) (embeddingWindows, error) {
+	tokens, err := m.tokenize(input, true, true)
+	if err != nil {
+		return embeddingWindows{}, fmt.Errorf("failed to tokenize input: %w", err)
+	}
+	if len(tokens) == 0 {
+		return embeddingWindows{}, fmt.Errorf("empty input")
+	}
+
+	first, last := m.contentRange(tokens)
+	return planTokenWindows(tokens, first, last, m.config.CtxSize, overlap)
+}
+
+// planTokenWindows splits tokens into windows of at most ctxSize tokens. Every window
+// repeats the special tokens before first and from last on around its content slice.
+func planTokenWindows(tokens []int32, first, last, ctxSize, overlap int) (embeddingWindows, error) {
+	var plan embeddingWindows
+	plan.tokensIn = len(tokens)
+
+	prefix, content, suffix := tokens[:first], tokens[first:last], tokens[last:]
+	plan.contentLen = len(content)
+	if len(tokens) <= ctxSize {
+		plan.seqs = [][]int32{tokens}
+		plan.spans = [][2]int{{0, len(content)}}
+		return plan, nil
+	}
+
+	window := ctxSize - len(prefix) - len(suffix)
+	if window <= 0 || len(content) == 0 {
+		return plan, fmt.Errorf("context size %d is too small for input", ctxSize)
+	}
+	if overlap >= window {
+		overlap = window / 2
+	}
+
+	for start := 0; ; start += window - overlap {
+		end := start + window
+		if end > len(content) {
+			end = len(content)
+		}
+		seq := make([]int32, 0, len(prefix)+end-start+len(suffix))
+		seq = append(seq, prefix...)
+		seq = append(seq, content[start:end]...)
+		seq = append(seq, suffix...)
+		plan.seqs = append(plan.seqs, seq)
+		plan.spans = append(plan.spans, [2]int{start, end})
+		if end == len(content) {
+			break
+		}
+	}
+	return plan, nil
+}
+
+// combine builds the result of an input from the embeddings of its windows
+func (p *embeddingWindows) combine(embeddings [][]float32, split bool) Embeddings {
+	result := Embeddings{TokensIn: p.tokensIn, Windows: len(p.seqs)}
+	if len(embeddings) == 1 || split {
+		result.Chunks = make([]ChunkEmbedding, len(embeddings))
+		for i, span := range p.spans {
+			result.Chunks[i].Embedding = embeddings[i]
+			if len(embeddings) > 1 {
+				result.Chunks[i].TokenSpan = []int{span[0], span[1]}
+			}
+		}
+		return result
+	}
+
+	// Weighted by window length so a short tail window counts for less
+	combined := make([]float32, len(embeddings[0]))
+	for i, embedding := range embeddings {
+		weight := float32(p.spans[i][1]-p.spans[i][0]) / float32(p.contentLen)
+		for k, v := range embedding {
+			combined[k] += weight * v
+		}
+	}
+	result.Chunks = []ChunkEmbedding{{Embedding: combined}}
+	return result
+}
+
+// packSequences orders sequences so that consecutive packing into batches of batchSize
+// tokens and maxSeqs sequences wastes little room: longest first, each placed in the
+// first batch that still fits it (first-fit decreasing), batches laid out in order.
+// Mixed short and long inputs then share batches instead of leaving them half empty.
+func packSequences(seqs []packedSeq, batchSize, maxSeqs int) []packedSeq {
+	sorted := make([]packedSeq, len(seqs))
+	copy(sorted, seqs)
+	sort.SliceStable(sorted, func(a, b int) bool {
+		return len(sorted[a].tokens) > len(sorted[b].tokens)
+	})
+
+	type batch struct {
+		used int
+		seqs []packedSeq
+	}
+	var batches []*batch
+	for _, seq := range sorted {
+		var target *batch
+		for _, b := range batches {
+			if b.used+len(seq.tokens) <= batchSize && len(b.seqs) < maxSeqs {
+				target = b
+				break
+			}
+		}
+		if target == nil {
+			target = &batch{}
+			batches = append(batches, target)
+		}
+		target.used += len(seq.tokens)
+		target.seqs = append(target.seqs, seq)
+	}
+
+	packed := sorted[:0]
+	for _, b := range batches {
+		packed = append(packed, b.seqs...)
+	}
+	return packed
+}
+
+// embedSequences embeds token sequences laid out back to back with a pooled context,
+// many sequences per decode
+func (m *Model) embedSequences(tokens []int32, seqLens []C.int, pooling int) ([][]float32, error) {
+	embeddingSize := m.info.embeddingSize
+	if embeddingSize <= 0 {
+		return nil, fmt.Errorf("model does not support embeddings or invalid embedding size: %d", embeddingSize)
+	}
+
+	nSeq := len(seqLens)
+	if nSeq > maxBatchSeqs {
+		nSeq = maxBatchSeqs
+	}
+
+	ctx := C.new_embedding_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads), C.int(pooling), C.int(nSeq))
+	if ctx == nil {
+		return nil, fmt.Errorf("failed to create context")
+	}
+	defer C.free_context(ctx)
+
+	out := make([]float32, len(seqLens)*embeddingSize)
+	decoded := int(C.llama_embed_sequences(
+		ctx,
+		(*C.int32_t)(unsafe.Pointer(&tokens[0])),
+		&seqLens[0],
+		C.int(len(seqLens)),
+		(*C.float)(unsafe.Pointer(&out[0])),
+		C.int(embeddingSize),
+	))
+
+	if decoded < 0 {
+		return nil, fmt.Errorf("embedding generation failed")
+	}
+
+	embeddings := make([][]float32, len(seqLens))
+	for i := range embeddings {
+		embeddings[i] = out[i*embeddingSize : (i+1)*embeddingSize : (i+1)*embeddingSize]
+	}
+	return embeddings, nil
+}
+
+// contentRange returns the bounds of the content tokens between the special tokens the
+// tokenizer added
+func (m *Model) contentRange(tokens []int32) (first, last int) {
+	var bos, eos, sep C.int32_t
+	C.get_special_tokens(m.model, &bos, &eos, &sep)
+	return contentBounds(tokens, int32(bos), int32(eos), int32(sep))
+}
+
+// contentBounds strips a leading BOS and the trailing EOS and SEP tokens. BERT-style
+// tokenizers close inputs with [SEP] instead of EOS, the same framing rerank pairs use.
+func contentBounds(tokens []int32, bos, eos, sep int32) (first, last int) {
+	first, last = 0, len(tokens)
+	if bos >= 0 && len(tokens) > 0 && tokens[0] == bos {
+		first = 1
+	}
+	if eos >= 0 && last > first && tokens[last-1] == eos {
+		last--
+	}
+	if sep >= 0 && last > first && tokens[last-1] == sep {
+		last--
+	}
+	return first, last
+}
+
+// chunkOverlap returns the configured window overlap for over-long inputs
+func (m *Model) chunkOverlap() int {
+	if m.sysConfig != nil && m.sysConfig.EmbedChunkOverlap >= 0 {
+		return m.sysConfig.EmbedChunkOverlap
+	}
+	return defaultChunkOverlap
+}
+
+// lateChunkEmbeddings pools token embeddings of one forward pass over the whole input.
+// Without spans every content token becomes its own chunk.
+func (m *Model) lateChunkEmbeddings(input string, spans [][2]int) (chunks []ChunkEmbedding, tokensIn int, err error) {
+	defer func() {
+		if r := recover(); r != nil {
+			slog.Error("Late chunking panic recovered", "error", r)
+			chunks, tokensIn, err = nil, 0, fmt.Errorf("late chunking panic: %v", r)
+		}
+	}()
+
+	if m.model == nil {
+		return nil, 0, fmt.Errorf("model is nil")
+	}
+	if m.pooling == poolingRank {
+		return nil, 0, fmt.Errorf("model is configured for reranking")
+	}
+
+	tokens, err := m.tokenize(input, true, true)
+	if err != nil {
+		return nil, 0, fmt.Errorf("failed to tokenize input: %w", err)
+	}
+	if len(tokens) == 0 {
+		return nil, 0, fmt.Errorf("empty input")
+	}
+	if len(tokens) > m.config.CtxSize {
+		return nil, 0, fmt.Errorf("input of %d tokens exceeds the context size %d", len(tokens), m.config.CtxSize)
+	}
+
+	first, last := m.contentRange(tokens)
+	if first == last {
+		return nil, 0, fmt.Errorf("input has no content tokens")
+	}
+
+	tokenStarts, tokenEnds, err := spanTokenRanges(input, spans, first, last, func(prefix string) (int, error) {
+		tokens, err := m.tokenize(prefix, false, true)
+		return len(tokens), err
+	})
+	if err != nil {
+		return nil, 0, err
+	}
+	starts := make([]C.int, len(tokenStarts))
+	ends := make([]C.int, len(tokenEnds))
+	for i := range tokenStarts {
+		starts[i] = C.int(tokenStarts[i])
+		ends[i] = C.int(tokenEnds[i])
+	}
+
+	embeddingSize := m.info.embeddingSize
+	if embeddingSize <= 0 {
+		return nil, 0, fmt.Errorf("model does not support embeddings or invalid embedding size: %d", embeddingSize)
+	}
+
+	ctx := C.new_embedding_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads), C.int(poolingNone), 1)
+	if ctx == nil {
+		return nil, 0, fmt.Errorf("failed to create context")
+	}
+	defer C.free_context(ctx)
+
+	embeddings := make([]float32, len(starts)*embeddingSize)
+	result := int(C.llama_embedding_spans(
+		ctx,
+		(*C.int32_t)(unsafe.Pointer(&tokens[0])),
+		C.int(len(tokens)),
+		&starts[0],
+		&ends[0],
+		C.int(len(starts)),
+		(*C.float)(unsafe.Pointer(&embeddings[0])),
+	))
+
+	if result != embeddingSize {
+		return nil, 0, fmt.Errorf("late chunking failed")
+	}
+
+	chunks = make([]ChunkEmbedding, len(starts))
+	for i := range chunks {
+		chunks[i].Embedding = embeddings[i*embeddingSize : (i+1)*embeddingSize : (i+1)*embeddingSize]
+		if len(spans) > 0 {
+			chunks[i].Span = []int{spans[i][0], spans[i][1]}
+		}
+	}
+
+	slog.Debug("Late chunked embedding", "tokens", len(tokens), "chunks", len(chunks))
+	return chunks, len(tokens), nil
+}
+
+// spanTokenRanges maps character spans of input to token ranges within the content
+// tokens [first, last). A span boundary is the index of the first token at or after it,
+// found by tokenizing the preceding text with prefixLen, which holds up under
+// normalizing tokenizers. Without spans every content token becomes its own range.
+func spanTokenRanges(input string, spans [][2]int, first, last int, prefixLen func(string) (int, error)) (starts, ends []int, err error) {
+	if len(spans) == 0 {
+		for i := first; i < last; i++ {
+			starts = append(starts, i)
+			ends = append(ends, i+1)
+		}
+		return starts, ends, nil
+	}
+
+	boundary := func(byteOffset int) (int, error) {
+		if byteOffset == 0 {
+			return first, nil
+		}
+		n, err := prefixLen(input[:byteOffset])
+		if err != nil {
+			return 0, fmt.Errorf("failed to tokenize span boundary: %w", err)
+		}
+		return first + n, nil
+	}
+
+	offsets := runeByteOffsets(input)
+	for i, span := range spans {
+		if span[0] < 0 || span[1] > len(offsets)-1 || span[0] >= span[1] {
+			return nil, nil, fmt.Errorf("span %d [%d, %d) is outside the input of %d characters", i, span[0], span[1], len(offsets)-1)
+		}
+
+		start, err := boundary(offsets[span[0]])
+		if err != nil {
+			return nil, nil, err
+		}
+		end, err := boundary(offsets[span[1]])
+		if err != nil {
+			return nil, nil, err
+		}
+
+		// Merged tokens across a boundary can shift it, every span keeps a token
+		if start > last-1 {
+			start = last - 1
+		}
+		if end > last {
+			end = last
+		}
+		if end <= start {
+			end = start + 1
+		}
+		starts = append(starts, start)
+		ends = append(ends, end)
+	}
+	return starts, ends, nil
+}
+
+// runeByteOffsets returns the byte offset of every character of s plus len(s)
+func runeByteOffsets(s string) []int {
+	offsets := make([]int, 0, utf8.RuneCountInString(s)+1)
+	for i := range s {
+		offsets = append(offsets, i)
+	}
+	return append(offsets, len(s))
+}
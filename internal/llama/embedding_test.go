@@ -0,0 +1,249 @@
+package llama
+
+import (
+	"math"
+	"os"
+	"reflect"
+	"strings"
+	"testing"
+
+	"github.com/aigoflow/inference-service/internal/config"
+)
+
+// wordCount tokenizes like a tokenizer with one token per word
+func wordCount(text string) (int, error) {
+	return len(strings.Fields(text)), nil
+}
+
+func TestSpanTokenRanges(t *testing.T) {
+	// Content tokens 1..6 behind a BOS token, one token per word
+	input := "naïve café bar. second part here"
+	first, last := 1, 7
+
+	tests := []struct {
+		name       string
+		spans      [][2]int
+		starts     []int
+		ends       []int
+		shouldFail bool
+	}{
+		{name: "no spans", starts: []int{1, 2, 3, 4, 5, 6}, ends: []int{2, 3, 4, 5, 6, 7}},
+		{name: "sentences", spans: [][2]int{{0, 15}, {16, 32}}, starts: []int{1, 4}, ends: []int{4, 7}},
+		// Character offsets past multi-byte characters map to the right words
+		{name: "after accents", spans: [][2]int{{6, 10}}, starts: []int{2}, ends: []int{3}},
+		// A boundary inside a word keeps the span at least one token long
+		{name: "inside word", spans: [][2]int{{1, 2}}, starts: []int{2}, ends: []int{3}},
+		{name: "whole input", spans: [][2]int{{0, 32}}, starts: []int{1}, ends: []int{7}},
+		{name: "empty span", spans: [][2]int{{3, 3}}, shouldFail: true},
+		{name: "past the end", spans: [][2]int{{0, 33}}, shouldFail: true},
+		{name: "negative start", spans: [][2]int{{-1, 4}}, shouldFail: true},
+	}
+
+	for _, tt := range tests {
+		starts, ends, err := spanTokenRanges(input, tt.spans, first, last, wordCount)
+		if tt.shouldFail {
+			if err == nil {
+				t.Errorf("%s: expected an error, got %v %v", tt.name, starts, ends)
+			}
+			continue
+		}
+		if err != nil {
+			t.Errorf("%s: %v", tt.name, err)
+			continue
+		}
+		if !reflect.DeepEqual(starts, tt.starts) || !reflect.DeepEqual(ends, tt.ends) {
+			t.Errorf("%s: got starts %v ends %v, want %v %v", tt.name, starts, ends, tt.starts, tt.ends)
+		}
+	}
+}
+
+// TestLateChunkSpans embeds spans with a real model, set EMBEDDING_TEST_MODEL to a GGUF
+// embedding model to run it
+func TestLateChunkSpans(t *testing.T) {
+	modelPath := os.Getenv("EMBEDDING_TEST_MODEL")
+	if modelPath == "" {
+		t.Skip("EMBEDDING_TEST_MODEL not set")
+	}
+
+	model, err := LoadWithConfig(Config{ModelPath: modelPath, Threads: 2, CtxSize: 512},
+		&config.Config{ModelFormat: "embedding", PoolingType: "mean"})
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer model.cleanup()
+
+	input := "The cat sat on the mat. Stock prices fell sharply today."
+	spans := [][2]int{{0, 23}, {24, 56}}
+	result, err := model.GenerateEmbeddings(input, EmbeddingOptions{Spans: spans})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(result.Chunks) != len(spans) || result.TokensIn == 0 {
+		t.Fatalf("got %d chunks and %d tokens, want %d chunks", len(result.Chunks), result.TokensIn, len(spans))
+	}
+
+	for i, chunk := range result.Chunks {
+		if !reflect.DeepEqual(chunk.Span, []int{spans[i][0], spans[i][1]}) {
+			t.Errorf("chunk %d: span %v, want %v", i, chunk.Span, spans[i])
+		}
+		if len(chunk.Embedding) != model.info.embeddingSize {
+			t.Errorf("chunk %d: %d dimensions, want %d", i, len(chunk.Embedding), model.info.embeddingSize)
+		}
+		var norm float64
+		for _, v := range chunk.Embedding {
+			if math.IsNaN(float64(v)) || math.IsInf(float64(v), 0) {
+				t.Fatalf("chunk %d: non-finite value %v", i, v)
+			}
+			norm += float64(v) * float64(v)
+		}
+		if norm == 0 {
+			t.Errorf("chunk %d: zero embedding", i)
+		}
+	}
+	if reflect.DeepEqual(result.Chunks[0].Embedding, result.Chunks[1].Embedding) {
+		t.Error("different spans pooled to the same embedding")
+	}
+}
+
+func TestPlanWindowsSEP(t *testing.T) {
+	const cls, sep = 101, 102
+
+	// [CLS] 1..10 [SEP], as a BERT-style embedder without EOS tokenizes
+	tokens := []int32{cls, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, sep}
+	first, last := contentBounds(tokens, cls, -1, sep)
+	if first != 1 || last != 11 {
+		t.Fatalf("content bounds %d, %d, want 1, 11", first, last)
+	}
+
+	plan, err := planTokenWindows(tokens, first, last, 6, 1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	wantSeqs := [][]int32{
+		{cls, 1, 2, 3, 4, sep},
+		{cls, 4, 5, 6, 7, sep},
+		{cls, 7, 8, 9, 10, sep},
+	}
+	wantSpans := [][2]int{{0, 4}, {3, 7}, {6, 10}}
+	if !reflect.DeepEqual(plan.seqs, wantSeqs) || !reflect.DeepEqual(plan.spans, wantSpans) {
+		t.Errorf("got windows %v spans %v, want %v %v", plan.seqs, plan.spans, wantSeqs, wantSpans)
+	}
+	if plan.contentLen != 10 || plan.tokensIn != len(tokens) {
+		t.Errorf("got content %d tokens in %d", plan.contentLen, plan.tokensIn)
+	}
+
+	// Both closing tokens are stripped when the tokenizer adds SEP and EOS
+	if first, last := contentBounds([]int32{0, 5, 6, sep, 2}, 0, 2, sep); first != 1 || last != 3 {
+		t.Errorf("content bounds %d, %d, want 1, 3", first, last)
+	}
+	// A SEP inside the content stays
+	if first, last := contentBounds([]int32{cls, 5, sep, 6}, cls, -1, sep); first != 1 || last != 4 {
+		t.Errorf("content bounds %d, %d, want 1, 4", first, last)
+	}
+}
+
+// decodeBatches splits packed sequences into decodes like llama_embed_sequences: whole
+// sequences in order, up to batchSize tokens and maxSeqs sequences each
+func decodeBatches(packed []packedSeq, batchSize, maxSeqs int) [][]packedSeq {
+	var batches [][]packedSeq
+	used := 0
+	for _, seq := range packed {
+		n := len(batches)
+		if n == 0 || used+len(seq.tokens) > batchSize || len(batches[n-1]) >= maxSeqs {
+			batches = append(batches, nil)
+			n++
+			used = 0
+		}
+		batches[n-1] = append(batches[n-1], seq)
+		used += len(seq.tokens)
+	}
+	return batches
+}
+
+func TestPackSequences(t *testing.T) {
+	// lengths builds one single-window input per length
+	lengths := func(counts ...int) []int {
+		var out []int
+		for i := 0; i < len(counts); i += 2 {
+			for k := 0; k < counts[i+1]; k++ {
+				out = append(out, counts[i])
+			}
+		}
+		return out
+	}
+
+	tests := []struct {
+		name      string
+		lengths   []int
+		batchSize int
+		maxSeqs   int
+		batches   [][2]int // Tokens and sequences of each decode
+	}{
+		{name: "empty", batchSize: 4096, maxSeqs: 64},
+		{
+			name:    "short inputs fill the gaps of long ones",
+			lengths: append(lengths(10, 10), lengths(2000, 3, 10, 10)...), batchSize: 4096, maxSeqs: 64,
+			batches: [][2]int{{4090, 11}, {2110, 12}},
+		},
+		{
+			name:    "short inputs between long ones",
+			lengths: []int{10, 2000, 10, 2000, 10, 2000, 10}, batchSize: 4096, maxSeqs: 64,
+			batches: [][2]int{{4040, 6}, {2000, 1}},
+		},
+		{
+			name:    "sequence limit",
+			lengths: lengths(10, 20), batchSize: 4096, maxSeqs: 8,
+			batches: [][2]int{{80, 8}, {80, 8}, {40, 4}},
+		},
+		{
+			name:    "exact fit",
+			lengths: lengths(2000, 2, 48, 2, 10, 1), batchSize: 4096, maxSeqs: 64,
+			batches: [][2]int{{4096, 4}, {10, 1}},
+		},
+		{
+			name:    "one long input per batch",
+			lengths: lengths(10, 4, 4000, 3), batchSize: 4096, maxSeqs: 64,
+			batches: [][2]int{{4040, 5}, {4000, 1}, {4000, 1}},
+		},
+	}
+
+	for _, tt := range tests {
+		seqs := make([]packedSeq, len(tt.lengths))
+		for i, n := range tt.lengths {
+			seqs[i] = packedSeq{input: i, tokens: make([]int32, n)}
+		}
+		original := append([]packedSeq{}, seqs...)
+
+		packed := packSequences(seqs, tt.batchSize, tt.maxSeqs)
+		if !reflect.DeepEqual(seqs, original) {
+			t.Errorf("%s: input slice was reordered", tt.name)
+		}
+
+		var got [][2]int
+		for _, batch := range decodeBatches(packed, tt.batchSize, tt.maxSeqs) {
+			tokens := 0
+			for _, seq := range batch {
+				tokens += len(seq.tokens)
+			}
+			got = append(got, [2]int{tokens, len(batch)})
+		}
+		if !reflect.DeepEqual(got, tt.batches) {
+			t.Errorf("%s: got batches %v, want %v", tt.name, got, tt.batches)
+		}
+
+		// Results are mapped back to their input by index, every input exactly once
+		results := make([]*packedSeq, len(seqs))
+		for k := range packed {
+			seq := &packed[k]
+			if results[seq.input] != nil {
+				t.Errorf("%s: input %d packed twice", tt.name, seq.input)
+			}
+			results[seq.input] = seq
+		}
+		for i, seq := range results {
+			if seq == nil || len(seq.tokens) != tt.lengths[i] {
+				t.Errorf("%s: input %d did not come back with its %d tokens", tt.name, i, tt.lengths[i])
+			}
+		}
+	}
+}
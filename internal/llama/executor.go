@@ -0,0 +1,24 @@
+package llama
+
+/*
+#include "binding.h"
+*/
+import "C"
+import (
+	"log/slog"
+	"runtime/cgo"
+)
+
+// StartExecutor starts the native executor with workers generation threads. Generations
+// then run on those threads while the calling goroutine waits without holding an OS
+// thread. Without it, or with workers <= 0, generations run inside the cgo call.
+func StartExecutor(workers int) {
+	if bool(C.executor_start(C.int(workers))) {
+		slog.Info("Native executor started", "workers", workers)
+	}
+}
+
+//export goJobDone
+func goJobDone(userData C.uintptr_t, result C.int) {
+	cgo.Handle(userData).Value().(chan int) <- int(result)
+}
@@ -17,6 +17,29 @@ type PromptFormatter interface {
 	Name() string
 }
 
+// PromptFragment is one piece of a formatted prompt. Fixed fragments are template
+// text shared by every request and are tokenized once per model; the rest carry
+// request content and are tokenized per request.
+type PromptFragment struct {
+	Text  string
+	Fixed bool
+}
+
+// FragmentFormatter is implemented by formatters that can describe a prompt as
+// template fragments interleaved with request content
+type FragmentFormatter interface {
+	FormatFragments(input string, systemPrompt string, config map[string]interface{}) []PromptFragment
+}
+
+// joinFragments renders fragments back into the prompt string
+func joinFragments(fragments []PromptFragment) string {
+	var prompt strings.Builder
+	for _, fragment := range fragments {
+		prompt.WriteString(fragment.Text)
+	}
+	return prompt.String()
+}
+
 // StandardFormatter handles basic prompts without templates
 type StandardFormatter struct{}
 
@@ -25,10 +48,18 @@ func (f *StandardFormatter) Name() string {
 }
 
 func (f *StandardFormatter) FormatPrompt(input, systemPrompt string, config map[string]interface{}) string {
+	return joinFragments(f.FormatFragments(input, systemPrompt, config))
+}
+
+func (f *StandardFormatter) FormatFragments(input, systemPrompt string, config map[string]interface{}) []PromptFragment {
 	if systemPrompt != "" {
-		return systemPrompt + "\n\nUser: " + input + "\nAssistant: "
+		return []PromptFragment{
+			{Text: systemPrompt + "\n\nUser: ", Fixed: true},
+			{Text: input},
+			{Text: "\nAssistant: ", Fixed: true},
+		}
 	}
-	return input
+	return []PromptFragment{{Text: input}}
 }
 
 func (f *StandardFormatter) ParseResponse(response string, config map[string]interface{}) string {
@@ -43,10 +74,14 @@ func (f *TemplateFormatter) Name() string {
 }
 
 func (f *TemplateFormatter) FormatPrompt(input, systemPrompt string, config map[string]interface{}) string {
+	return joinFragments(f.FormatFragments(input, systemPrompt, config))
+}
+
+func (f *TemplateFormatter) FormatFragments(input, systemPrompt string, config map[string]interface{}) []PromptFragment {
 	// Load template file from model directory and apply it
 	modelPath, ok := config["model_path"].(string)
 	if !ok {
-		return input
+		return []PromptFragment{{Text: input}}
 	}
 	
 	// Load the actual template file (prompt_template.json) from model directory
@@ -54,28 +89,29 @@ func (f *TemplateFormatter) FormatPrompt(input, systemPrompt string, config map[
 	template, err := loadTemplate(modelDir)
 	if err != nil {
 		slog.Warn("Template load failed, using passthrough", "error", err)
-		return input
+		return []PromptFragment{{Text: input}}
 	}
 	
 	if template == nil {
-		// No template file = passthrough mode
-		return input
+		// No template = passthrough mode
+		return []PromptFragment{{Text: input}}
 	}
 	
 	// Apply template formatting using the loaded template
-	var formatted strings.Builder
+	var prefix strings.Builder
 	
 	if template.SystemRole != "" {
-		formatted.WriteString(template.SystemRole)
-		formatted.WriteString("\n")
+		prefix.WriteString(template.SystemRole)
+		prefix.WriteString("\n")
 	}
 	
-	formatted.WriteString(template.UserPrefix)
-	formatted.WriteString(input)
-	formatted.WriteString(template.UserSuffix)
-	formatted.WriteString(template.ModelPrefix)
+	prefix.WriteString(template.UserPrefix)
 	
-	return formatted.String()
+	return []PromptFragment{
+		{Text: prefix.String(), Fixed: true},
+		{Text: input},
+		{Text: template.UserSuffix + template.ModelPrefix, Fixed: true},
+	}
 }
 
 func (f *TemplateFormatter) ParseResponse(response string, config map[string]interface{}) string {
@@ -90,6 +126,10 @@ func (f *HarmonyFormatter) Name() string {
 }
 
 func (f *HarmonyFormatter) FormatPrompt(input, systemPrompt string, config map[string]interface{}) string {
+	return joinFragments(f.FormatFragments(input, systemPrompt, config))
+}
+
+func (f *HarmonyFormatter) FormatFragments(input, systemPrompt string, config map[string]interface{}) []PromptFragment {
 	// Get reasoning level from config
 	reasoningLevel := harmony.ReasoningMedium
 	if level, ok := config["reasoning_level"].(string); ok {
@@ -124,7 +164,12 @@ func (f *HarmonyFormatter) FormatPrompt(input, systemPrompt string, config map[s
 	conversation := builder.Build()
 	formatter := harmony.NewHarmonyFormatter()
 	
-	return formatter.FormatConversationForCompletion(conversation)
+	harmonyFragments := formatter.FormatConversationFragments(conversation)
+	fragments := make([]PromptFragment, len(harmonyFragments))
+	for i, fragment := range harmonyFragments {
+		fragments[i] = PromptFragment{Text: fragment.Text, Fixed: fragment.Fixed}
+	}
+	return fragments
 }
 
 func (f *HarmonyFormatter) ParseResponse(response string, config map[string]interface{}) string {
@@ -150,20 +195,25 @@ func (f *ChatMLFormatter) Name() string {
 }
 
 func (f *ChatMLFormatter) FormatPrompt(input, systemPrompt string, config map[string]interface{}) string {
-	var prompt strings.Builder
+	return joinFragments(f.FormatFragments(input, systemPrompt, config))
+}
+
+func (f *ChatMLFormatter) FormatFragments(input, systemPrompt string, config map[string]interface{}) []PromptFragment {
+	var prefix strings.Builder
 	
 	if systemPrompt != "" {
-		prompt.WriteString("<|im_start|>system\n")
-		prompt.WriteString(systemPrompt)
-		prompt.WriteString("<|im_end|>\n")
+		prefix.WriteString("<|im_start|>system\n")
+		prefix.WriteString(systemPrompt)
+		prefix.WriteString("<|im_end|>\n")
 	}
 	
-	prompt.WriteString("<|im_start|>user\n")
-	prompt.WriteString(input)
-	prompt.WriteString("<|im_end|>\n")
-	prompt.WriteString("<|im_start|>assistant\n")
+	prefix.WriteString("<|im_start|>user\n")
 	
-	return prompt.String()
+	return []PromptFragment{
+		{Text: prefix.String(), Fixed: true},
+		{Text: input},
+		{Text: "<|im_end|>\n<|im_start|>assistant\n", Fixed: true},
+	}
 }
 
 func (f *ChatMLFormatter) ParseResponse(response string, config map[string]interface{}) string {
@@ -220,6 +270,35 @@ func FormatPromptWithConfig(input, modelPath string, cfg *config.Config) string
 		return input
 	}
 	
+	formatter, systemPrompt, formatConfig := resolveFormatter(modelPath, cfg)
+	
+	slog.Info("Formatting prompt", 
+		"formatter", formatter.Name(), 
+		"model_path", modelPath,
+		"has_system_prompt", systemPrompt != "")
+	
+	return formatter.FormatPrompt(input, systemPrompt, formatConfig)
+}
+
+// FormatFragmentsWithConfig formats prompt as template fragments and request content.
+// Formatters without fragment support yield their whole prompt as request content.
+func FormatFragmentsWithConfig(input, modelPath string, cfg *config.Config) []PromptFragment {
+	if cfg == nil {
+		return []PromptFragment{{Text: input}}
+	}
+	
+	formatter, systemPrompt, formatConfig := resolveFormatter(modelPath, cfg)
+	
+	fragmentFormatter, ok := formatter.(FragmentFormatter)
+	if !ok {
+		return []PromptFragment{{Text: formatter.FormatPrompt(input, systemPrompt, formatConfig)}}
+	}
+	
+	return fragmentFormatter.FormatFragments(input, systemPrompt, formatConfig)
+}
+
+// resolveFormatter selects the configured formatter along with its system prompt and format config
+func resolveFormatter(modelPath string, cfg *config.Config) (PromptFormatter, string, map[string]interface{}) {
 	// Get formatter based on configuration
 	formatter, err := globalFormatterRegistry.GetFormatter(cfg.ModelFormat)
 	if err != nil {
@@ -242,12 +321,7 @@ func FormatPromptWithConfig(input, modelPath string, cfg *config.Config) string
 	}
 	formatConfig["model_path"] = modelPath
 	
-	slog.Info("Formatting prompt", 
-		"formatter", formatter.Name(), 
-		"model_path", modelPath,
-		"has_system_prompt", systemPrompt != "")
-	
-	return formatter.FormatPrompt(input, systemPrompt, formatConfig)
+	return formatter, systemPrompt, formatConfig
 }
 
 // ParseResponseWithConfig parses response using configuration-driven approach  
@@ -1,15 +1,20 @@
 package llama
 
 /*
-#cgo CXXFLAGS: -I${SRCDIR}/include -I${SRCDIR}/src -I${SRCDIR}/ggml_include -std=c++11 -DGGML_USE_METAL
-#cgo LDFLAGS: -L${SRCDIR} -lbinding -lllama -lggml -lggml-base -lggml-cpu -lggml-blas -lggml-metal -lm
+#cgo CXXFLAGS: -I${SRCDIR}/include -I${SRCDIR}/src -I${SRCDIR}/ggml_include -std=c++17
+#cgo ggml_dl CXXFLAGS: -DGGML_BACKEND_DL
+#cgo darwin LDFLAGS: -L${SRCDIR} -lbinding -lllama -lggml -lggml-cpu -lggml-blas -lggml-metal -lggml-base -lm
 #cgo darwin LDFLAGS: -framework Accelerate -framework Foundation -framework Metal -framework MetalKit -framework MetalPerformanceShaders
-#cgo linux LDFLAGS: -lstdc++
+#cgo linux,!ggml_dl LDFLAGS: -L${SRCDIR} -lbinding -lllama -lggml -lggml-cpu -lggml-base -lm -lstdc++
+#cgo linux,ggml_dl LDFLAGS: -L${SRCDIR}/ggml_dl -lbinding -lllama -lggml -lggml-base -ldl -lm -lstdc++
 #include "binding.h"
 #include <stdlib.h>
+
+extern bool goTokenCallback(uintptr_t user_data, char* piece, int len);
 */
 import "C"
 import (
+	"context"
 	"fmt"
 	"io"
 	"log/slog"
@@ -17,6 +22,7 @@ import (
 	"os"
 	"path/filepath"
 	"runtime"
+	"runtime/cgo"
 	"strconv"
 	"strings"
 	"time"
@@ -38,7 +44,12 @@ type Config struct {
 type Model struct {
 	model      unsafe.Pointer
 	config     Config
-	sysConfig  *config.Config  // System configuration with Harmony settings
+	sysConfig  *config.Config    // System configuration with Harmony settings
+	fragments  *fragmentCache    // Pre-tokenized prompt template fragments
+	chatTurns  *chatTurnCache    // Token deltas of recently seen chat turns
+	info       modelInfo         // GGUF metadata read at load
+	reasoning  *reasoningMarkers // How reasoning output opens and closes, nil if not a thinking model
+	pooling    int               // Pooling type of embedding contexts
 	// Remove ctx - we'll create fresh context for each request
 }
 
@@ -46,6 +57,13 @@ func LoadWithConfig(cfg Config, sysConfig *config.Config) (*Model, error) {
 	modelPath := C.CString(cfg.ModelPath)
 	defer C.free(unsafe.Pointer(modelPath))
 	
+	// Backends decide GPU support, so they are loaded before anything else
+	backendDir := ""
+	if sysConfig != nil {
+		backendDir = sysConfig.BackendDir
+	}
+	loadBackends(backendDir)
+	
 	// Load model with GPU layers if supported
 	gpuLayers := 0
 	if hasGPUSupport() {
@@ -59,10 +77,20 @@ func LoadWithConfig(cfg Config, sysConfig *config.Config) (*Model, error) {
 		"gpu_layers", gpuLayers,
 		"gpu_support", hasGPUSupport())
 	
+	// Rerankers are encoder models scored through a rank-pooled embedding context
+	encoder := sysConfig != nil && (sysConfig.ModelFormat == "embedding" || sysConfig.ModelFormat == "rerank")
+	pooling := poolingMean
+	if sysConfig != nil {
+		var err error
+		if pooling, err = parsePoolingType(sysConfig.PoolingType, sysConfig.ModelFormat == "rerank"); err != nil {
+			return nil, err
+		}
+	}
+	
 	// Choose appropriate loader based on model format
 	var model unsafe.Pointer
-	if sysConfig != nil && sysConfig.ModelFormat == "embedding" {
-		slog.Info("Loading as embedding model")
+	if encoder {
+		slog.Info("Loading as embedding model", "format", sysConfig.ModelFormat, "pooling", pooling)
 		model = C.load_embedding_model(modelPath, C.int(cfg.CtxSize), C.int(cfg.Threads), C.int(gpuLayers), C.bool(true), C.bool(false))
 	} else {
 		model = C.load_model(modelPath, C.int(cfg.CtxSize), C.int(cfg.Threads), C.int(gpuLayers), C.bool(true), C.bool(false))
@@ -74,14 +102,35 @@ func LoadWithConfig(cfg Config, sysConfig *config.Config) (*Model, error) {
 	
 	slog.Info("Model loaded successfully", "gpu_support", hasGPUSupport())
 	
+	// Opt-in: CPU contexts share one threadpool, offloaded models barely use it
+	if sysConfig != nil && sysConfig.SharedThreadpool && !hasGPUSupport() {
+		if threads := int(C.threadpool_init(C.int(sysConfig.ThreadpoolThreads), C.int(sysConfig.ThreadpoolPoll))); threads > 0 {
+			slog.Info("Shared threadpool attached, concurrent requests take turns per decode step",
+				"threads", threads, "poll", sysConfig.ThreadpoolPoll, "model_threads_ignored", cfg.Threads)
+		} else {
+			slog.Warn("Shared threadpool unavailable, contexts keep their own threads")
+		}
+	}
+	
 	// Set finalizer to clean up resources  
 	m := &Model{
 		model:     model,
 		config:    cfg,
 		sysConfig: sysConfig,
+		fragments: newFragmentCache(),
+		chatTurns: newChatTurnCache(1024),
+		info:      readModelInfo(model),
+		pooling:   pooling,
 	}
 	runtime.SetFinalizer(m, (*Model).cleanup)
 	
+	// Tokenize prompt template fragments once at load time
+	if sysConfig != nil && !encoder {
+		m.warmFragmentCache()
+		m.reasoning = m.resolveReasoningMarkers()
+		StartExecutor(sysConfig.Executors)
+	}
+	
 	return m, nil
 }
 
@@ -90,78 +139,135 @@ func Load(cfg Config) (*Model, error) {
 	return LoadWithConfig(cfg, nil)
 }
 
+// Generation is the result of a formatted generation request
+type Generation struct {
+	Text            string
+	FormattedInput  string
+	TokensIn        int
+	TokensOut       int
+	ReasoningTokens int            // Part of TokensOut generated before the answer started
+	Samples         []Sample       // All completions when n > 1, Text holds the first
+	Logprobs        *TokenLogprobs // Per-token log-probabilities when requested
+}
+
 func (m *Model) GenerateWithFormatting(input string, params map[string]interface{}) (text string, tokensIn, tokensOut int, formattedInput string, err error) {
+	gen, err := m.GenerateWithFormattingStream(context.Background(), input, params, nil)
+	return gen.Text, gen.TokensIn, gen.TokensOut, gen.FormattedInput, err
+}
+
+// GenerateWithFormattingStream generates like GenerateWithFormatting and passes response
+// text to onText as it is generated. Decoding stops when ctx is done.
+func (m *Model) GenerateWithFormattingStream(ctx context.Context, input string, params map[string]interface{}, onText TextCallback) (gen Generation, err error) {
 	defer func() {
 		if r := recover(); r != nil {
 			slog.Error("Inference panic recovered", "error", r)
-			text, tokensIn, tokensOut, formattedInput, err = "", 0, 0, "", fmt.Errorf("inference panic: %v", r)
+			gen, err = Generation{}, fmt.Errorf("inference panic: %v", r)
 		}
 	}()
 	
 	if m.model == nil {
-		return "", 0, 0, "", fmt.Errorf("model is nil")
+		return gen, fmt.Errorf("model is nil")
+	}
+	
+	// Apply model-specific prompt formatting using clean formatter system
+	fragments := FormatFragmentsWithConfig(input, m.config.ModelPath, m.sysConfig)
+	gen.FormattedInput = joinFragments(fragments)
+	
+	// Assemble prompt tokens from pre-tokenized template fragments and tokenized input
+	promptTokens, err := m.promptTokens(fragments)
+	if err != nil {
+		return gen, fmt.Errorf("failed to tokenize prompt: %w", err)
+	}
+	gen.TokensIn = len(promptTokens)
+	
+	cancel := newCancelFlag(ctx)
+	defer cancel.free()
+	
+	// Several completions share one prompt prefill
+	p := parseParams(params)
+	if p.n > 1 {
+		return gen, m.generateSamples(promptTokens, p, cancel, &gen)
+	}
+	
+	stream := m.newOutputStream(p, onText)
+	if err := m.generateFromTokens(promptTokens, p, stream, cancel, &gen); err != nil {
+		return gen, err
+	}
+	
+	gen.Text = stream.finish(gen.Text)
+	return gen, nil
+}
+
+// generateFromTokens runs prediction over an assembled prompt token sequence and fills
+// the raw generated text and output token counts into gen
+func (m *Model) generateFromTokens(promptTokens []int32, p *generationParams, stream *outputStream, cancel *cancelFlag, gen *Generation) error {
+	if len(promptTokens) == 0 {
+		return fmt.Errorf("empty prompt")
+	}
+	
+	// Natural stopping when max_tokens not specified
+	maxTokens, err := maxTokensParam(p, m.config.CtxSize)
+	if err != nil {
+		return err
 	}
 	
 	// Create fresh context per request for stateless operation
 	ctx := C.new_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads))
 	if ctx == nil {
-		return "", 0, 0, "", fmt.Errorf("failed to create context")
+		return fmt.Errorf("failed to create context")
 	}
 	defer C.free_context(ctx)
 	
-	// Apply model-specific prompt formatting using clean formatter system
-	formattedInput = FormatPromptWithConfig(input, m.config.ModelPath, m.sysConfig)
-	
-	// Extract generation parameters
-	maxTokens := getIntParam(params, "max_tokens", 512)
-	temperature := getFloatParam(params, "temperature", 0.7)
-	topP := getFloatParam(params, "top_p", 1.0)
-	topK := getIntParam(params, "top_k", 40)
-	repeatPenalty := getFloatParam(params, "repeat_penalty", 1.1)
-	repeatLastN := getIntParam(params, "repeat_last_n", 64)
+	// All arguments travel in one packed request
+	call, err := newPredictCall(promptTokens, maxTokens)
+	if err != nil {
+		return err
+	}
+	defer call.free()
+	call.setSampling(p)
 	
-	// Natural stopping when max_tokens not specified
-	if _, exists := params["max_tokens"]; !exists {
-		maxTokens = 2048
+	// Pass generated pieces back only when someone consumes them
+	if stream != nil && stream.active() {
+		handle := cgo.NewHandle(stream)
+		defer handle.Delete()
+		call.req.on_token = C.token_callback(C.goTokenCallback)
+		call.req.user_data = C.uintptr_t(handle)
 	}
 	
-	// Count input tokens using formatted prompt
-	inputCStr := C.CString(formattedInput)
-	defer C.free(unsafe.Pointer(inputCStr))
-	tokensIn = int(C.count_tokens(ctx, inputCStr))
+	// Track reasoning output and enforce reasoning_max_tokens for thinking models
+	budget := m.reasoningBudget(p.reasoningMaxTokens)
+	call.setReasoning(budget)
 	
-	// Generate tokens using proven stable prediction
-	resultSize := maxTokens * 4
-	result := make([]byte, resultSize)
+	// Record log-probabilities only when requested
+	logprobs := newLogprobBuffers(p, maxTokens)
+	defer logprobs.free()
+	call.setLogprobs(logprobs)
 	
-	tokensOut = int(C.llama_predict(
-		ctx,
-		inputCStr,
-		(*C.char)(unsafe.Pointer(&result[0])),
-		C.int(resultSize),
-		C.int(maxTokens),
-		C.float(temperature),
-		C.float(topP),
-		C.int(topK),
-		C.float(repeatPenalty),
-		C.int(repeatLastN),
-		C.bool(true),
-	))
+	tokensOut := call.run(ctx, cancel)
 	
+	if err := cancel.err(); err != nil {
+		return err
+	}
 	if tokensOut < 0 {
-		return "", tokensIn, 0, formattedInput, fmt.Errorf("inference failed")
+		return fmt.Errorf("inference failed")
+	}
+	
+	gen.Text = call.text()
+	gen.TokensOut = tokensOut
+	call.collectLogprobs(logprobs)
+	gen.Logprobs = logprobs.result(m)
+	if budget != nil {
+		var forced bool
+		gen.ReasoningTokens, forced = call.reasoningTokens()
+		if forced {
+			slog.Debug("Reasoning budget enforced", "reasoning_tokens", gen.ReasoningTokens)
+		}
 	}
-	
-	text = C.GoString((*C.char)(unsafe.Pointer(&result[0])))
-	
-	// Post-process response using clean formatter system
-	text = ParseResponseWithConfig(text, m.config.ModelPath, m.sysConfig)
-	
-	return text, tokensIn, tokensOut, formattedInput, nil
+	return nil
 }
 
 // GenerateRaw generates text without any formatting (for reasoning service control)
-func (m *Model) GenerateRaw(input string, params map[string]interface{}) (text string, tokensIn, tokensOut int, formattedInput string, err error) {
+func (m *Model) GenerateRaw(ctx context.Context, input string, params map[string]interface{}) (text string, tokensIn, tokensOut int, formattedInput string, err error) {
 	defer func() {
 		if r := recover(); r != nil {
 			slog.Error("Raw inference panic recovered", "error", r)
@@ -173,64 +279,78 @@ func (m *Model) GenerateRaw(input string, params map[string]interface{}) (text s
 		return "", 0, 0, "", fmt.Errorf("model is nil")
 	}
 	
-	// Create fresh context per request for stateless operation
-	ctx := C.new_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads))
-	if ctx == nil {
-		return "", 0, 0, "", fmt.Errorf("failed to create context")
-	}
-	defer C.free_context(ctx)
-	
 	// Use input directly without any formatting
 	formattedInput = input
 	
-	// Extract generation parameters
-	maxTokens := getIntParam(params, "max_tokens", 512)
-	temperature := getFloatParam(params, "temperature", 0.7)
-	topP := getFloatParam(params, "top_p", 1.0)
-	topK := getIntParam(params, "top_k", 40)
-	repeatPenalty := getFloatParam(params, "repeat_penalty", 1.1)
-	repeatLastN := getIntParam(params, "repeat_last_n", 64)
-	
 	// Natural stopping when max_tokens not specified
-	if _, exists := params["max_tokens"]; !exists {
-		maxTokens = 2048
+	p := parseParams(params)
+	maxTokens, err := maxTokensParam(p, m.config.CtxSize)
+	if err != nil {
+		return "", 0, 0, formattedInput, err
 	}
 	
-	// Count input tokens using raw input
-	inputCStr := C.CString(formattedInput)
-	defer C.free(unsafe.Pointer(inputCStr))
-	tokensIn = int(C.count_tokens(ctx, inputCStr))
+	// Create fresh context per request for stateless operation
+	llamaCtx := C.new_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads))
+	if llamaCtx == nil {
+		return "", 0, 0, "", fmt.Errorf("failed to create context")
+	}
+	defer C.free_context(llamaCtx)
 	
-	// Generate tokens using proven stable prediction
-	resultSize := maxTokens * 4
-	result := make([]byte, resultSize)
+	// Tokenized once, the count is the input token count
+	promptTokens, err := m.tokenize(formattedInput, true, true)
+	if err != nil {
+		return "", 0, 0, formattedInput, err
+	}
+	tokensIn = len(promptTokens)
+	if tokensIn == 0 {
+		return "", 0, 0, formattedInput, fmt.Errorf("empty prompt")
+	}
 	
-	tokensOut = int(C.llama_predict(
-		ctx,
-		inputCStr,
-		(*C.char)(unsafe.Pointer(&result[0])),
-		C.int(resultSize),
-		C.int(maxTokens),
-		C.float(temperature),
-		C.float(topP),
-		C.int(topK),
-		C.float(repeatPenalty),
-		C.int(repeatLastN),
-		C.bool(true),
-	))
+	cancel := newCancelFlag(ctx)
+	defer cancel.free()
+	
+	call, err := newPredictCall(promptTokens, maxTokens)
+	if err != nil {
+		return "", tokensIn, 0, formattedInput, err
+	}
+	defer call.free()
+	call.setSampling(p)
+	
+	tokensOut = call.run(llamaCtx, cancel)
 	
+	if err := cancel.err(); err != nil {
+		return "", tokensIn, 0, formattedInput, err
+	}
 	if tokensOut < 0 {
 		return "", tokensIn, 0, formattedInput, fmt.Errorf("raw inference failed")
 	}
 	
-	text = C.GoString((*C.char)(unsafe.Pointer(&result[0])))
+	text = call.text()
 	
 	// No post-processing in raw mode - return exactly what model generated
 	return text, tokensIn, tokensOut, formattedInput, nil
 }
 
+// FormatPrompt returns the prompt text a request would be generated from without
+// tokenizing or decoding it: the rendered conversation, the formatted input, or the
+// input itself in raw mode
+func (m *Model) FormatPrompt(input string, messages []ChatMessage, raw bool) (string, error) {
+	if len(messages) > 0 {
+		return m.chatRenderer().Render(m.withDefaultSystem(messages), true)
+	}
+	if raw {
+		return input, nil
+	}
+	return joinFragments(FormatFragmentsWithConfig(input, m.config.ModelPath, m.sysConfig)), nil
+}
+
 // GenerateEmbedding generates embedding vectors for input text
 func (m *Model) GenerateEmbedding(input string) ([]float32, int, error) {
+	return m.generateEmbedding(input, m.pooling)
+}
+
+// generateEmbedding embeds input pooled with the given pooling type
+func (m *Model) generateEmbedding(input string, pooling int) ([]float32, int, error) {
 	defer func() {
 		if r := recover(); r != nil {
 			slog.Error("Embedding generation panic recovered", "error", r)
@@ -240,16 +360,19 @@ func (m *Model) GenerateEmbedding(input string) ([]float32, int, error) {
 	if m.model == nil {
 		return nil, 0, fmt.Errorf("model is nil")
 	}
+	if pooling == poolingRank {
+		return nil, 0, fmt.Errorf("model is configured for reranking")
+	}
 	
 	// Create fresh embedding context per request for stateless operation
-	ctx := C.new_embedding_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads))
+	ctx := C.new_embedding_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads), C.int(pooling), 1)
 	if ctx == nil {
 		return nil, 0, fmt.Errorf("failed to create context")
 	}
 	defer C.free_context(ctx)
 	
 	// Get embedding size from model
-	embeddingSize := int(C.get_embedding_size(m.model))
+	embeddingSize := m.info.embeddingSize
 	if embeddingSize <= 0 {
 		return nil, 0, fmt.Errorf("model does not support embeddings or invalid embedding size: %d", embeddingSize)
 	}
@@ -289,15 +412,17 @@ func (m *Model) GenerateEmbedding(input string) ([]float32, int, error) {
 
 // GetEmbeddingSize returns the embedding dimension size for this model
 func (m *Model) GetEmbeddingSize() int {
-	if m.model == nil {
-		return 0
-	}
-	return int(C.get_embedding_size(m.model))
+	return m.info.embeddingSize
 }
 
 // IsEmbeddingModel checks if this model supports embedding generation
 func (m *Model) IsEmbeddingModel() bool {
-	return m.GetEmbeddingSize() > 0
+	return m.GetEmbeddingSize() > 0 && !m.IsRerankModel()
+}
+
+// IsRerankModel checks if this model is served as a cross-encoder reranker
+func (m *Model) IsRerankModel() bool {
+	return m.sysConfig != nil && m.sysConfig.ModelFormat == "rerank"
 }
 
 // GetModelArchitecture returns the model architecture (llama, gemma, qwen, etc.)
@@ -305,7 +430,7 @@ func (m *Model) GetModelArchitecture() string {
 	if m.model == nil {
 		return "unknown"
 	}
-	return C.GoString(C.get_model_architecture(m.model))
+	return m.info.architecture
 }
 
 // GetSupportedModalities returns the modalities this model supports
@@ -318,10 +443,10 @@ func (m *Model) GetSupportedModalities() []string {
 
 	// Check for multimodal capabilities
 	if m.model != nil {
-		if bool(C.model_supports_images(m.model)) {
+		if m.info.supportsImages {
 			modalities = append(modalities, "image")
 		}
-		if bool(C.model_supports_audio(m.model)) {
+		if m.info.supportsAudio {
 			modalities = append(modalities, "audio")
 		}
 	}
@@ -339,13 +464,13 @@ func (m *Model) GetModelMetadata() capabilities.ModelMetadata {
 	}
 
 	// Get parameter count and format it nicely
-	paramCount := int64(C.get_model_parameter_count(m.model))
+	paramCount := m.info.parameterCount
 	paramCountStr := formatParameterCount(paramCount)
 
 	// Get context size
 	contextSize := m.config.CtxSize
 	if contextSize == 0 {
-		contextSize = int(C.get_context_size(m.model))
+		contextSize = m.info.contextSize
 	}
 
 	metadata := capabilities.ModelMetadata{
@@ -354,10 +479,11 @@ func (m *Model) GetModelMetadata() capabilities.ModelMetadata {
 		ParameterCount: paramCountStr,
 		ContextSize:    contextSize,
 		EmbeddingSize:  m.GetEmbeddingSize(),
-		Quantization:   C.GoString(C.get_model_quantization(m.model)),
-		ModelFamily:    C.GoString(C.get_model_family(m.model)),
+		Quantization:   m.info.quantization,
+		ModelFamily:    m.info.family,
+		Compute:        &compute,
 		Additional: map[string]interface{}{
-			"model_name": C.GoString(C.get_model_name(m.model)),
+			"model_name": m.info.name,
 			"config_name": m.config.ModelName,
 			"model_path": m.config.ModelPath,
 		},
@@ -373,10 +499,12 @@ func (m *Model) HasCapability(capability string) bool {
 		return true // All models support text generation
 	case "embeddings":
 		return m.IsEmbeddingModel()
+	case "rerank":
+		return m.IsRerankModel()
 	case "image", "image-understanding":
-		return m.model != nil && bool(C.model_supports_images(m.model))
+		return m.model != nil && m.info.supportsImages
 	case "audio", "audio-transcription":
-		return m.model != nil && bool(C.model_supports_audio(m.model))
+		return m.model != nil && m.info.supportsAudio
 	case "reasoning":
 		return m.supportsReasoning()
 	case "grammar", "grammar-constrained":
@@ -389,7 +517,7 @@ func (m *Model) HasCapability(capability string) bool {
 // supportsReasoning checks if the model is known to support reasoning
 func (m *Model) supportsReasoning() bool {
 	arch := strings.ToLower(m.GetModelArchitecture())
-	family := strings.ToLower(C.GoString(C.get_model_family(m.model)))
+	family := strings.ToLower(m.info.family)
 	
 	reasoningArchs := []string{"gpt", "gemma", "qwen", "llama", "phi", "mistral"}
 	
@@ -427,6 +555,8 @@ func truncateString(s string, maxLen int) string {
 }
 
 func (m *Model) cleanup() {
+	m.reasoning.free()
+	m.reasoning = nil
 	if m.model != nil {
 		C.free_model(m.model)
 		m.model = nil
@@ -605,6 +735,15 @@ func getFloatParam(params map[string]interface{}, key string, defaultVal float64
 	return defaultVal
 }
 
+func getBoolParam(params map[string]interface{}, key string, defaultVal bool) bool {
+	if v, ok := params[key]; ok {
+		if val, ok := v.(bool); ok {
+			return val
+		}
+	}
+	return defaultVal
+}
+
 func getStringParam(params map[string]interface{}, key string, defaultVal string) string {
 	if v, ok := params[key]; ok {
 		if val, ok := v.(string); ok {
@@ -0,0 +1,109 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"unsafe"
+)
+
+// maxTopLogprobs bounds the top_logprobs parameter
+const maxTopLogprobs = 20
+
+// TokenLogprobs holds log-probabilities of generated tokens as flat parallel arrays.
+// Alternatives of token i are TopTokens[i*TopN : (i+1)*TopN], best first.
+type TokenLogprobs struct {
+	TopN        int       `json:"top_n"`
+	Tokens      []int32   `json:"tokens"`
+	Text        []string  `json:"text"`
+	Logprobs    []float32 `json:"logprobs"`
+	TopTokens   []int32   `json:"top_tokens,omitempty"`
+	TopLogprobs []float32 `json:"top_logprobs,omitempty"`
+}
+
+// logprobBuffers holds the C logprob_output of one generation. The arrays live in C
+// memory since the struct handed to the binding may not point into Go memory.
+type logprobBuffers struct {
+	out C.logprob_output
+}
+
+// newLogprobBuffers returns nil unless logprobs were requested, keeping the decode
+// loop free of log-softmax work by default
+func newLogprobBuffers(p *generationParams, maxTokens int) *logprobBuffers {
+	topN := p.topLogprobs
+	if !p.logprobs && topN <= 0 {
+		return nil
+	}
+	if topN < 0 {
+		topN = 0
+	}
+	if topN > maxTopLogprobs {
+		topN = maxTopLogprobs
+	}
+
+	b := &logprobBuffers{}
+	b.out.top_n = C.int(topN)
+	b.out.capacity = C.int(maxTokens)
+	b.out.tokens = (*C.int32_t)(C.malloc(C.size_t(maxTokens) * 4))
+	b.out.logprobs = (*C.float)(C.malloc(C.size_t(maxTokens) * 4))
+	if topN > 0 {
+		b.out.top_tokens = (*C.int32_t)(C.malloc(C.size_t(maxTokens*topN) * 4))
+		b.out.top_logprobs = (*C.float)(C.malloc(C.size_t(maxTokens*topN) * 4))
+	}
+	return b
+}
+
+// result copies the recorded log-probabilities of the generated tokens
+func (b *logprobBuffers) result(m *Model) *TokenLogprobs {
+	if b == nil {
+		return nil
+	}
+
+	n := int(b.out.n)
+	topN := int(b.out.top_n)
+	result := &TokenLogprobs{
+		TopN:     topN,
+		Tokens:   make([]int32, n),
+		Text:     make([]string, n),
+		Logprobs: make([]float32, n),
+	}
+	if n == 0 {
+		return result
+	}
+
+	copy(result.Tokens, unsafe.Slice((*int32)(unsafe.Pointer(b.out.tokens)), n))
+	copy(result.Logprobs, unsafe.Slice((*float32)(unsafe.Pointer(b.out.logprobs)), n))
+	if topN > 0 {
+		result.TopTokens = make([]int32, n*topN)
+		result.TopLogprobs = make([]float32, n*topN)
+		copy(result.TopTokens, unsafe.Slice((*int32)(unsafe.Pointer(b.out.top_tokens)), n*topN))
+		copy(result.TopLogprobs, unsafe.Slice((*float32)(unsafe.Pointer(b.out.top_logprobs)), n*topN))
+	}
+
+	for i, token := range result.Tokens {
+		result.Text[i] = m.tokenPiece(token)
+	}
+	return result
+}
+
+func (b *logprobBuffers) free() {
+	if b == nil {
+		return
+	}
+	C.free(unsafe.Pointer(b.out.tokens))
+	C.free(unsafe.Pointer(b.out.logprobs))
+	C.free(unsafe.Pointer(b.out.top_tokens))
+	C.free(unsafe.Pointer(b.out.top_logprobs))
+}
+
+// tokenPiece returns the text of a single token
+func (m *Model) tokenPiece(token int32) string {
+	var buf [128]C.char
+	n := int(C.token_to_piece(m.model, C.int32_t(token), &buf[0], C.int(len(buf))))
+	if n <= 0 {
+		return ""
+	}
+	return C.GoStringN(&buf[0], C.int(n))
+}
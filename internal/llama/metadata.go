@@ -0,0 +1,42 @@
+package llama
+
+/*
+#include "binding.h"
+*/
+import "C"
+import (
+	"unsafe"
+)
+
+// modelInfo is the model metadata, read from the GGUF once at load so introspection
+// never crosses into C again
+type modelInfo struct {
+	architecture   string
+	name           string
+	quantization   string
+	family         string
+	parameterCount int64
+	contextSize    int // Training context length
+	embeddingSize  int
+	bosToken       int32 // BOS token prepended to assembled prompts, -1 if unused
+	supportsImages bool
+	supportsAudio  bool
+}
+
+func readModelInfo(model unsafe.Pointer) modelInfo {
+	var meta C.model_metadata
+	C.get_model_metadata(model, &meta)
+
+	return modelInfo{
+		architecture:   C.GoString(&meta.architecture[0]),
+		name:           C.GoString(&meta.name[0]),
+		quantization:   C.GoString(&meta.quantization[0]),
+		family:         C.GoString(&meta.family[0]),
+		parameterCount: int64(meta.parameter_count),
+		contextSize:    int(meta.context_size),
+		embeddingSize:  int(meta.embedding_size),
+		bosToken:       int32(meta.bos_token),
+		supportsImages: bool(meta.supports_images),
+		supportsAudio:  bool(meta.supports_audio),
+	}
+}
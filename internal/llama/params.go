@@ -0,0 +1,40 @@
+package llama
+
+// generationParams are the request parameters a generation reads. The params map of a
+// request is converted once when its generation starts, so setting up the decode reads
+// typed fields instead of type-switching on map values for every lookup.
+type generationParams struct {
+	maxTokens          int  // defaultMaxTokens when unset
+	maxTokensSet       bool // Whether the request set max_tokens
+	temperature        float64
+	topP               float64
+	topK               int
+	repeatPenalty      float64
+	repeatLastN        int
+	seed               int // Negative for a random seed
+	n                  int // Completions sampled from one prompt prefill
+	logprobs           bool
+	topLogprobs        int
+	reasoningMaxTokens int // Negative for the model's default budget
+	stopOnToolCall     bool
+}
+
+// parseParams converts the params of a request, applying the defaults of unset keys
+func parseParams(params map[string]interface{}) *generationParams {
+	_, maxTokensSet := params["max_tokens"]
+	return &generationParams{
+		maxTokens:          getIntParam(params, "max_tokens", defaultMaxTokens),
+		maxTokensSet:       maxTokensSet,
+		temperature:        getFloatParam(params, "temperature", 0.7),
+		topP:               getFloatParam(params, "top_p", 1.0),
+		topK:               getIntParam(params, "top_k", 40),
+		repeatPenalty:      getFloatParam(params, "repeat_penalty", 1.1),
+		repeatLastN:        getIntParam(params, "repeat_last_n", 64),
+		seed:               getIntParam(params, "seed", -1),
+		n:                  getIntParam(params, "n", 1),
+		logprobs:           getBoolParam(params, "logprobs", false),
+		topLogprobs:        getIntParam(params, "top_logprobs", 0),
+		reasoningMaxTokens: getIntParam(params, "reasoning_max_tokens", -1),
+		stopOnToolCall:     getBoolParam(params, "stop_on_tool_call", false),
+	}
+}
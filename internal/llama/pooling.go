@@ -0,0 +1,43 @@
+package llama
+
+import (
+	"fmt"
+	"strings"
+)
+
+// Pooling types of embedding contexts, values of llama.cpp's enum llama_pooling_type
+const (
+	poolingNone = 0
+	poolingMean = 1
+	poolingCLS  = 2
+	poolingLast = 3
+	poolingRank = 4
+)
+
+var poolingTypes = map[string]int{
+	"none": poolingNone,
+	"mean": poolingMean,
+	"cls":  poolingCLS,
+	"last": poolingLast,
+	"rank": poolingRank,
+}
+
+// parsePoolingType maps a POOLING_TYPE name to its llama.cpp value, empty selects the
+// default: rank for rerankers and mean for embedding models
+func parsePoolingType(name string, rerank bool) (int, error) {
+	if name == "" {
+		if rerank {
+			return poolingRank, nil
+		}
+		return poolingMean, nil
+	}
+
+	pooling, ok := poolingTypes[strings.ToLower(name)]
+	if !ok {
+		return 0, fmt.Errorf("unknown pooling type %q (expected none, mean, cls, last or rank)", name)
+	}
+	if rerank && pooling != poolingRank {
+		return 0, fmt.Errorf("rerank models require rank pooling, got %q", name)
+	}
+	return pooling, nil
+}
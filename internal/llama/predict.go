@@ -0,0 +1,135 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+#include <string.h>
+
+extern void goJobDone(uintptr_t user_data, int result);
+*/
+import "C"
+import (
+	"fmt"
+	"math"
+	"runtime/cgo"
+	"unsafe"
+)
+
+// defaultMaxTokens lets generation stop naturally when max_tokens is not given
+const defaultMaxTokens = 2048
+
+// maxResultTokens keeps the result buffer size, 4 bytes per token, within a C int
+const maxResultTokens = math.MaxInt32 / 4
+
+// predictCall is the packed argument of one llama_predict_request call. The request,
+// prompt tokens and result buffer share one C allocation, so a generation enters the
+// binding once and hands it no Go pointers.
+type predictCall struct {
+	req *C.predict_request
+}
+
+// maxTokensParam returns the max_tokens of p. Values below 1 are rejected, they would
+// size the native result buffers below what the decode loop writes. Values above limit
+// are clamped to it, generation cannot run past the context anyway.
+func maxTokensParam(p *generationParams, limit int) (int, error) {
+	maxTokens := p.maxTokens
+	if maxTokens < 1 {
+		return 0, fmt.Errorf("max_tokens must be at least 1, got %d", maxTokens)
+	}
+	if limit > 0 && maxTokens > limit {
+		maxTokens = limit
+	}
+	return maxTokens, nil
+}
+
+// newPredictCall copies promptTokens into a request with room for maxTokens of text
+func newPredictCall(promptTokens []int32, maxTokens int) (*predictCall, error) {
+	if len(promptTokens) == 0 {
+		return nil, fmt.Errorf("empty prompt")
+	}
+	if maxTokens < 1 || maxTokens > maxResultTokens {
+		return nil, fmt.Errorf("max_tokens must be between 1 and %d, got %d", maxResultTokens, maxTokens)
+	}
+
+	reqSize := C.size_t(unsafe.Sizeof(C.predict_request{}))
+	tokensSize := C.size_t(len(promptTokens)) * 4
+	resultSize := maxTokens * 4
+
+	mem := C.calloc(1, reqSize+tokensSize+C.size_t(resultSize))
+	req := (*C.predict_request)(mem)
+	tokens := unsafe.Add(mem, reqSize)
+	C.memcpy(tokens, unsafe.Pointer(&promptTokens[0]), tokensSize)
+
+	req.tokens = (*C.int32_t)(tokens)
+	req.n_tokens = C.int(len(promptTokens))
+	req.result = (*C.char)(unsafe.Add(tokens, tokensSize))
+	req.result_size = C.int(resultSize)
+	req.max_tokens = C.int(maxTokens)
+	return &predictCall{req: req}, nil
+}
+
+// setSampling sets the sampling parameters of params
+func (p *predictCall) setSampling(params *generationParams) {
+	p.req.temperature = C.float(params.temperature)
+	p.req.top_p = C.float(params.topP)
+	p.req.top_k = C.int(params.topK)
+	p.req.repeat_penalty = C.float(params.repeatPenalty)
+	p.req.repeat_last_n = C.int(params.repeatLastN)
+	p.req.use_penalty = C.bool(true)
+}
+
+// setReasoning copies a reasoning budget into the request, nil leaves tracking off
+func (p *predictCall) setReasoning(budget *C.reasoning_budget) {
+	if budget == nil {
+		return
+	}
+	p.req.reasoning = *budget
+	p.req.use_reasoning = C.bool(true)
+}
+
+// setLogprobs records log-probabilities into b, nil leaves recording off
+func (p *predictCall) setLogprobs(b *logprobBuffers) {
+	if b == nil {
+		return
+	}
+	p.req.logprobs = b.out
+	p.req.use_logprobs = C.bool(true)
+}
+
+// run generates in ctx and returns the tokens generated, -1 on failure. The request
+// runs on the native executor when it is started, otherwise inside this call.
+func (p *predictCall) run(ctx unsafe.Pointer, cancel *cancelFlag) int {
+	p.req.cancel = cancel.ptr()
+
+	done := make(chan int, 1)
+	handle := cgo.NewHandle(done)
+	defer handle.Delete()
+	if bool(C.llama_predict_request_async(ctx, p.req, C.job_callback(C.goJobDone), C.uintptr_t(handle))) {
+		// Cancellation reaches the job through the flag, the request must outlive it
+		return <-done
+	}
+	return int(C.llama_predict_request(ctx, p.req))
+}
+
+// text returns the generated text
+func (p *predictCall) text() string {
+	return C.GoStringN(p.req.result, p.req.result_len)
+}
+
+// reasoningTokens returns the tokens generated before the answer and whether the
+// reasoning budget cut them short
+func (p *predictCall) reasoningTokens() (int, bool) {
+	return int(p.req.reasoning.reasoning_tokens), bool(p.req.reasoning.forced)
+}
+
+// collectLogprobs updates b with the tokens recorded in the request
+func (p *predictCall) collectLogprobs(b *logprobBuffers) {
+	if b == nil {
+		return
+	}
+	b.out.n = p.req.logprobs.n
+}
+
+func (p *predictCall) free() {
+	C.free(unsafe.Pointer(p.req))
+}
@@ -0,0 +1,88 @@
+package llama
+
+import "testing"
+
+func TestMaxTokensParam(t *testing.T) {
+	tests := []struct {
+		name       string
+		params     map[string]interface{}
+		want       int
+		shouldFail bool
+	}{
+		{name: "unset", params: map[string]interface{}{}, want: defaultMaxTokens},
+		{name: "json number", params: map[string]interface{}{"max_tokens": 64.0}, want: 64},
+		{name: "int", params: map[string]interface{}{"max_tokens": 1}, want: 1},
+		{name: "clamped to context", params: map[string]interface{}{"max_tokens": 1e9}, want: 4096},
+		{name: "zero", params: map[string]interface{}{"max_tokens": 0.0}, shouldFail: true},
+		{name: "negative", params: map[string]interface{}{"max_tokens": -1.0}, shouldFail: true},
+		{name: "very negative", params: map[string]interface{}{"max_tokens": -1e12}, shouldFail: true},
+	}
+
+	for _, tt := range tests {
+		got, err := maxTokensParam(parseParams(tt.params), 4096)
+		if tt.shouldFail {
+			if err == nil {
+				t.Errorf("%s: expected an error, got %d", tt.name, got)
+			}
+			continue
+		}
+		if err != nil || got != tt.want {
+			t.Errorf("%s: got %d, %v, want %d", tt.name, got, err, tt.want)
+		}
+	}
+}
+
+func TestNewPredictCallBounds(t *testing.T) {
+	prompt := []int32{1, 2, 3}
+	for _, maxTokens := range []int{0, -1, -1 << 40, maxResultTokens + 1} {
+		if call, err := newPredictCall(prompt, maxTokens); err == nil {
+			call.free()
+			t.Errorf("max_tokens %d should be rejected", maxTokens)
+		}
+	}
+	if _, err := newPredictCall(nil, 16); err == nil {
+		t.Error("an empty prompt should be rejected")
+	}
+
+	call, err := newPredictCall(prompt, 16)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer call.free()
+	if call.req.result_size != 64 || call.req.max_tokens != 16 || call.req.n_tokens != 3 {
+		t.Errorf("got result_size %d max_tokens %d n_tokens %d", call.req.result_size, call.req.max_tokens, call.req.n_tokens)
+	}
+}
+
+func TestPlanSamples(t *testing.T) {
+	tests := []struct {
+		name       string
+		prompt, n  int
+		params     map[string]interface{}
+		trainCtx   int
+		ctxSize    int
+		maxTokens  int
+		shouldFail bool
+	}{
+		{name: "fits CTX_SIZE", prompt: 100, n: 4, params: map[string]interface{}{"max_tokens": 64.0}, trainCtx: 8192, ctxSize: 4096, maxTokens: 64},
+		{name: "grows past CTX_SIZE", prompt: 100, n: 4, params: map[string]interface{}{"max_tokens": 1024.0}, trainCtx: 8192, ctxSize: 100 + 4*1024, maxTokens: 1024},
+		{name: "unset shrinks to fit", prompt: 192, n: 16, params: map[string]interface{}{}, trainCtx: 8192, ctxSize: 8192, maxTokens: 500},
+		{name: "unknown train context", prompt: 96, n: 2, params: map[string]interface{}{}, ctxSize: 4096, maxTokens: 2000},
+		{name: "exceeds train context", prompt: 100, n: 16, params: map[string]interface{}{"max_tokens": 1e6}, trainCtx: 8192, shouldFail: true},
+		{name: "no room for output", prompt: 8190, n: 4, params: map[string]interface{}{}, trainCtx: 8192, shouldFail: true},
+		{name: "zero max_tokens", prompt: 100, n: 2, params: map[string]interface{}{"max_tokens": 0.0}, trainCtx: 8192, shouldFail: true},
+	}
+
+	for _, tt := range tests {
+		ctxSize, maxTokens, err := planSamples(tt.prompt, tt.n, parseParams(tt.params), 4096, tt.trainCtx)
+		if tt.shouldFail {
+			if err == nil {
+				t.Errorf("%s: expected an error, got context %d", tt.name, ctxSize)
+			}
+			continue
+		}
+		if err != nil || ctxSize != tt.ctxSize || maxTokens != tt.maxTokens {
+			t.Errorf("%s: got context %d max_tokens %d, %v, want %d and %d", tt.name, ctxSize, maxTokens, err, tt.ctxSize, tt.maxTokens)
+		}
+	}
+}
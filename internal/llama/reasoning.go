@@ -0,0 +1,76 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"log/slog"
+	"path/filepath"
+	"unsafe"
+)
+
+// Harmony switches from the analysis to the final channel to answer
+const (
+	harmonyReasoningStart = "<|channel|>analysis<|message|>"
+	harmonyAnswerStart    = "<|channel|>final<|message|>"
+	harmonyForceAnswer    = "<|end|><|start|>assistant<|channel|>final<|message|>"
+)
+
+// reasoningMarkers describes how a thinking model opens and closes its reasoning.
+// Strings are kept in C memory for the lifetime of the model.
+type reasoningMarkers struct {
+	start *C.char // Output prefix that opens reasoning
+	end   *C.char // Text that closes reasoning and starts the answer
+	force *C.char // Injected when the reasoning budget is spent
+}
+
+// resolveReasoningMarkers returns the reasoning markers for the configured format:
+// Harmony channels for gpt-oss, think_start/think_end from prompt_template.json otherwise
+func (m *Model) resolveReasoningMarkers() *reasoningMarkers {
+	var start, end, force string
+	if m.sysConfig != nil && m.sysConfig.ModelFormat == "harmony" {
+		start, end, force = harmonyReasoningStart, harmonyAnswerStart, harmonyForceAnswer
+	} else {
+		template, err := loadTemplate(filepath.Dir(m.config.ModelPath))
+		if err != nil || template == nil || template.ThinkEnd == "" {
+			return nil
+		}
+		start, end, force = template.ThinkStart, template.ThinkEnd, "\n"+template.ThinkEnd+"\n\n"
+	}
+
+	slog.Info("Reasoning output markers configured", "start", start, "end", end)
+	return &reasoningMarkers{
+		start: C.CString(start),
+		end:   C.CString(end),
+		force: C.CString(force),
+	}
+}
+
+// reasoningBudget prepares reasoning tracking for one generation, maxTokens < 0 means
+// reasoning is counted but not limited
+func (m *Model) reasoningBudget(maxTokens int) *C.reasoning_budget {
+	if m.reasoning == nil {
+		return nil
+	}
+	if maxTokens < 0 {
+		maxTokens = -1
+	}
+
+	return &C.reasoning_budget{
+		max_tokens:   C.int(maxTokens),
+		start_marker: m.reasoning.start,
+		end_marker:   m.reasoning.end,
+		force_text:   m.reasoning.force,
+	}
+}
+
+func (r *reasoningMarkers) free() {
+	if r == nil {
+		return
+	}
+	C.free(unsafe.Pointer(r.start))
+	C.free(unsafe.Pointer(r.end))
+	C.free(unsafe.Pointer(r.force))
+}
@@ -0,0 +1,119 @@
+package llama
+
+/*
+#include "binding.h"
+*/
+import "C"
+import (
+	"fmt"
+	"log/slog"
+	"sort"
+	"unsafe"
+)
+
+// RerankResult is the relevance of one document to the query
+type RerankResult struct {
+	Index    int     `json:"index"` // Position of the document in the request
+	Score    float64 `json:"relevance_score"`
+	Document string  `json:"document,omitempty"`
+}
+
+// Rerank scores every document against the query with a cross-encoder and returns the
+// results sorted by relevance, best first, along with the number of tokens decoded.
+// Pairs are framed as [BOS] query [EOS] [SEP] document [EOS] and decoded many at a time.
+func (m *Model) Rerank(query string, documents []string) (results []RerankResult, tokens int, err error) {
+	defer func() {
+		if r := recover(); r != nil {
+			slog.Error("Rerank panic recovered", "error", r)
+			results, tokens, err = nil, 0, fmt.Errorf("rerank panic: %v", r)
+		}
+	}()
+
+	if m.model == nil {
+		return nil, 0, fmt.Errorf("model is nil")
+	}
+	if m.pooling != poolingRank {
+		return nil, 0, fmt.Errorf("model is not configured for reranking")
+	}
+	if len(documents) == 0 {
+		return nil, 0, fmt.Errorf("no documents provided")
+	}
+
+	queryTokens, err := m.tokenize(query, false, false)
+	if err != nil {
+		return nil, 0, fmt.Errorf("failed to tokenize query: %w", err)
+	}
+
+	var bos, eos, sep C.int32_t
+	C.get_special_tokens(m.model, &bos, &eos, &sep)
+	var prefix, suffix []int32
+	if bos >= 0 {
+		prefix = append(prefix, int32(bos))
+	}
+	prefix = append(prefix, queryTokens...)
+	if eos >= 0 {
+		prefix = append(prefix, int32(eos))
+		suffix = append(suffix, int32(eos))
+	}
+	if sep >= 0 {
+		prefix = append(prefix, int32(sep))
+	}
+
+	// Documents are truncated so every pair fits the context
+	maxDocTokens := m.config.CtxSize - len(prefix) - len(suffix)
+	if maxDocTokens <= 0 {
+		return nil, 0, fmt.Errorf("query of %d tokens does not fit the context", len(queryTokens))
+	}
+
+	pairTokens := make([]int32, 0, len(documents)*(len(prefix)+64))
+	pairLens := make([]C.int, len(documents))
+	for i, document := range documents {
+		docTokens, err := m.tokenize(document, false, false)
+		if err != nil {
+			return nil, 0, fmt.Errorf("failed to tokenize document %d: %w", i, err)
+		}
+		if len(docTokens) > maxDocTokens {
+			docTokens = docTokens[:maxDocTokens]
+		}
+
+		pairTokens = append(pairTokens, prefix...)
+		pairTokens = append(pairTokens, docTokens...)
+		pairTokens = append(pairTokens, suffix...)
+		pairLens[i] = C.int(len(prefix) + len(docTokens) + len(suffix))
+	}
+
+	nSeq := len(documents)
+	if nSeq > maxBatchSeqs {
+		nSeq = maxBatchSeqs
+	}
+
+	ctx := C.new_embedding_context(m.model, C.int(m.config.CtxSize), C.int(m.config.Threads), C.int(poolingRank), C.int(nSeq))
+	if ctx == nil {
+		return nil, 0, fmt.Errorf("failed to create context")
+	}
+	defer C.free_context(ctx)
+
+	scores := make([]C.float, len(documents))
+	tokens = int(C.llama_rerank(
+		ctx,
+		(*C.int32_t)(unsafe.Pointer(&pairTokens[0])),
+		&pairLens[0],
+		C.int(len(documents)),
+		&scores[0],
+	))
+
+	if tokens < 0 {
+		return nil, 0, fmt.Errorf("rerank failed")
+	}
+
+	results = make([]RerankResult, len(documents))
+	for i := range documents {
+		results[i] = RerankResult{Index: i, Score: float64(scores[i])}
+	}
+	sort.SliceStable(results, func(a, b int) bool {
+		return results[a].Score > results[b].Score
+	})
+
+	slog.Debug("Reranked documents", "documents", len(documents), "tokens", tokens)
+	return results, tokens, nil
+}
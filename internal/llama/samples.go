@@ -0,0 +1,148 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"fmt"
+	"log/slog"
+	"unsafe"
+)
+
+// maxSamples bounds the n parameter, each sample is a KV sequence in one context
+const maxSamples = 16
+
+// defaultSeed lets llama.cpp pick a random seed per sample
+const defaultSeed = 0xFFFFFFFF
+
+// Sample is one of several completions generated from a shared prompt
+type Sample struct {
+	Text      string  `json:"text"`
+	TokensOut int     `json:"tokens_out"`
+	Logprob   float64 `json:"logprob"` // Sum of token log-probabilities under the model
+}
+
+// planSamples sizes the context of n samples of a prompt and their per-sample
+// max_tokens. The prompt cells are shared but every sample needs room for its own
+// output, so the context may outgrow CTX_SIZE up to the model's training context.
+// An unset max_tokens shrinks to fit, an explicit one that does not fit is an error.
+func planSamples(promptTokens, n int, p *generationParams, ctxSize, trainCtx int) (int, int, error) {
+	limit := ctxSize
+	if trainCtx > limit {
+		limit = trainCtx
+	}
+	room := (limit - promptTokens) / n
+	if room < 1 {
+		return 0, 0, fmt.Errorf("prompt of %d tokens leaves no room for %d samples in a context of %d", promptTokens, n, limit)
+	}
+
+	maxTokens, err := maxTokensParam(p, 0)
+	if err != nil {
+		return 0, 0, err
+	}
+	if !p.maxTokensSet {
+		maxTokens = min(maxTokens, room)
+	} else if maxTokens > room {
+		return 0, 0, fmt.Errorf("%d samples of max_tokens %d after a prompt of %d tokens exceed the context limit of %d", n, maxTokens, promptTokens, limit)
+	}
+
+	size := promptTokens + n*maxTokens
+	if size < ctxSize {
+		size = ctxSize
+	}
+	return size, maxTokens, nil
+}
+
+// KVTokens returns the most KV cells a generation of promptTokens with params may
+// hold: its context share for one completion, the shared prompt plus every sample's
+// output for n of them
+func (m *Model) KVTokens(promptTokens int, params map[string]interface{}) int {
+	p := parseParams(params)
+	if p.n > 1 && p.n <= maxSamples {
+		if ctxSize, _, err := planSamples(promptTokens, p.n, p, m.config.CtxSize, m.info.contextSize); err == nil {
+			return ctxSize
+		}
+		return promptTokens // Rejected before decoding
+	}
+
+	maxTokens, err := maxTokensParam(p, m.config.CtxSize)
+	if err != nil {
+		return promptTokens
+	}
+	return min(promptTokens+maxTokens, m.config.CtxSize)
+}
+
+// generateSamples decodes n completions of one prompt. The prompt is prefilled once
+// and its KV forked to n sequences that are sampled with independently seeded samplers.
+func (m *Model) generateSamples(promptTokens []int32, p *generationParams, cancel *cancelFlag, gen *Generation) error {
+	n := p.n
+	if len(promptTokens) == 0 {
+		return fmt.Errorf("empty prompt")
+	}
+	if n > maxSamples {
+		return fmt.Errorf("n must be at most %d, got %d", maxSamples, n)
+	}
+
+	ctxSize, maxTokens, err := planSamples(len(promptTokens), n, p, m.config.CtxSize, m.info.contextSize)
+	if err != nil {
+		return err
+	}
+
+	seed := uint32(defaultSeed)
+	if p.seed >= 0 {
+		seed = uint32(p.seed)
+	}
+
+	ctx := C.new_context_seqs(m.model, C.int(ctxSize), C.int(m.config.Threads), C.int(n))
+	if ctx == nil {
+		return fmt.Errorf("failed to create context")
+	}
+	defer C.free_context(ctx)
+
+	resultSize := maxTokens * 4
+	result := make([]byte, n*resultSize)
+	sampleTokens := make([]C.int, n)
+	sampleLogprobs := make([]C.float, n)
+
+	tokensOut := int(C.llama_predict_samples(
+		ctx,
+		(*C.int32_t)(unsafe.Pointer(&promptTokens[0])),
+		C.int(len(promptTokens)),
+		C.int(n),
+		(*C.char)(unsafe.Pointer(&result[0])),
+		C.int(resultSize),
+		&sampleTokens[0],
+		&sampleLogprobs[0],
+		C.int(maxTokens),
+		C.float(p.temperature),
+		C.float(p.topP),
+		C.int(p.topK),
+		C.uint32_t(seed),
+		cancel.ptr(),
+	))
+
+	if err := cancel.err(); err != nil {
+		return err
+	}
+	if tokensOut < 0 {
+		return fmt.Errorf("sample inference failed: decode of %d samples in a context of %d failed", n, ctxSize)
+	}
+
+	gen.Samples = make([]Sample, n)
+	for i := 0; i < n; i++ {
+		text := C.GoString((*C.char)(unsafe.Pointer(&result[i*resultSize])))
+		gen.Samples[i] = Sample{
+			Text:      m.parseResponse(p, text),
+			TokensOut: int(sampleTokens[i]),
+			Logprob:   float64(sampleLogprobs[i]),
+		}
+	}
+
+	gen.Text = gen.Samples[0].Text
+	gen.TokensOut = tokensOut
+
+	slog.Debug("Generated samples", "n", n, "prompt_tokens", len(promptTokens), "tokens_out", tokensOut)
+	return nil
+}
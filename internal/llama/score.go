@@ -0,0 +1,146 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"fmt"
+	"log/slog"
+	"unsafe"
+)
+
+// maxScoreCandidates bounds candidates per request, each is a KV sequence in one context
+const maxScoreCandidates = 64
+
+// CandidateScore is the log-likelihood of one continuation given the prompt
+type CandidateScore struct {
+	Text        string  `json:"text"`
+	Tokens      int     `json:"tokens"`
+	Logprob     float64 `json:"logprob"`      // Sum of token log-probabilities
+	MeanLogprob float64 `json:"mean_logprob"` // Per-token average, comparable across lengths
+}
+
+// Scoring is the result of scoring candidate continuations of one prompt
+type Scoring struct {
+	Candidates     []CandidateScore
+	Best           int // Index of the candidate with the highest logprob
+	FormattedInput string
+	TokensIn       int
+	TokensScored   int
+}
+
+// ScoreCandidates returns the log-likelihood of each candidate as a continuation of
+// the formatted prompt. This is one forward pass over the prompt and one batched pass
+// over all candidate tokens instead of generating under a grammar.
+func (m *Model) ScoreCandidates(input string, candidates []string, raw bool) (scoring Scoring, err error) {
+	return m.scoreCandidates(candidates, func() ([]int32, string, error) {
+		if raw {
+			tokens, err := m.tokenize(input, false, true)
+			return m.withBOS(tokens), input, err
+		}
+		fragments := FormatFragmentsWithConfig(input, m.config.ModelPath, m.sysConfig)
+		tokens, err := m.promptTokens(fragments)
+		return tokens, joinFragments(fragments), err
+	})
+}
+
+// ScoreChatCandidates scores candidates as the next assistant turn of a conversation
+func (m *Model) ScoreChatCandidates(messages []ChatMessage, candidates []string) (scoring Scoring, err error) {
+	if len(messages) == 0 {
+		return scoring, fmt.Errorf("no messages provided")
+	}
+	return m.scoreCandidates(candidates, func() ([]int32, string, error) {
+		return m.chatPromptTokens(m.chatRenderer(), m.withDefaultSystem(messages))
+	})
+}
+
+func (m *Model) scoreCandidates(candidates []string, prompt func() ([]int32, string, error)) (scoring Scoring, err error) {
+	defer func() {
+		if r := recover(); r != nil {
+			slog.Error("Scoring panic recovered", "error", r)
+			scoring, err = Scoring{}, fmt.Errorf("scoring panic: %v", r)
+		}
+	}()
+
+	if m.model == nil {
+		return scoring, fmt.Errorf("model is nil")
+	}
+	if len(candidates) == 0 {
+		return scoring, fmt.Errorf("no candidates provided")
+	}
+	if len(candidates) > maxScoreCandidates {
+		return scoring, fmt.Errorf("at most %d candidates are supported, got %d", maxScoreCandidates, len(candidates))
+	}
+
+	promptTokens, formattedInput, err := prompt()
+	scoring.FormattedInput = formattedInput
+	if err != nil {
+		return scoring, fmt.Errorf("failed to tokenize prompt: %w", err)
+	}
+	if len(promptTokens) == 0 {
+		return scoring, fmt.Errorf("empty prompt")
+	}
+	scoring.TokensIn = len(promptTokens)
+
+	// Candidates are plain text continuing the prompt, no BOS and no special tokens
+	candTokens := make([]int32, 0, len(candidates)*4)
+	candLens := make([]C.int, len(candidates))
+	for i, candidate := range candidates {
+		tokens, err := m.tokenize(candidate, false, false)
+		if err != nil {
+			return scoring, fmt.Errorf("failed to tokenize candidate %d: %w", i, err)
+		}
+		if len(tokens) == 0 {
+			return scoring, fmt.Errorf("candidate %d is empty", i)
+		}
+		candTokens = append(candTokens, tokens...)
+		candLens[i] = C.int(len(tokens))
+	}
+
+	// Prompt cells are shared, every candidate needs room for its own tokens
+	ctxSize := len(promptTokens) + len(candTokens)
+	if ctxSize < m.config.CtxSize {
+		ctxSize = m.config.CtxSize
+	}
+
+	ctx := C.new_context_seqs(m.model, C.int(ctxSize), C.int(m.config.Threads), C.int(len(candidates)))
+	if ctx == nil {
+		return scoring, fmt.Errorf("failed to create context")
+	}
+	defer C.free_context(ctx)
+
+	scores := make([]C.float, len(candidates))
+	scored := int(C.llama_score_candidates(
+		ctx,
+		(*C.int32_t)(unsafe.Pointer(&promptTokens[0])),
+		C.int(len(promptTokens)),
+		(*C.int32_t)(unsafe.Pointer(&candTokens[0])),
+		&candLens[0],
+		C.int(len(candidates)),
+		&scores[0],
+	))
+
+	if scored < 0 {
+		return scoring, fmt.Errorf("scoring failed")
+	}
+
+	scoring.TokensScored = scored
+	scoring.Candidates = make([]CandidateScore, len(candidates))
+	for i, candidate := range candidates {
+		logprob := float64(scores[i])
+		scoring.Candidates[i] = CandidateScore{
+			Text:        candidate,
+			Tokens:      int(candLens[i]),
+			Logprob:     logprob,
+			MeanLogprob: logprob / float64(candLens[i]),
+		}
+		if logprob > scoring.Candidates[scoring.Best].Logprob {
+			scoring.Best = i
+		}
+	}
+
+	slog.Debug("Scored candidates", "candidates", len(candidates), "prompt_tokens", len(promptTokens), "candidate_tokens", scored)
+	return scoring, nil
+}
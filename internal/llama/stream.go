@@ -0,0 +1,92 @@
+package llama
+
+/*
+#include <stdint.h>
+#include <stdbool.h>
+*/
+import "C"
+import (
+	"runtime/cgo"
+
+	"github.com/aigoflow/inference-service/internal/harmony"
+)
+
+// TextCallback receives generated response text as soon as it is decoded
+type TextCallback func(text string)
+
+// outputStream routes generated pieces to the caller while the model runs. Harmony
+// output is parsed incrementally so only final-channel text reaches the caller and
+// generation stops as soon as the assistant turn is complete.
+type outputStream struct {
+	model        *Model
+	parser       *harmony.StreamParser
+	extractFinal bool
+	onText       TextCallback
+}
+
+func (m *Model) newOutputStream(p *generationParams, onText TextCallback) *outputStream {
+	stream := &outputStream{model: m, onText: onText}
+	if m.sysConfig == nil || m.sysConfig.ModelFormat != "harmony" {
+		return stream
+	}
+
+	stream.extractFinal = true
+	if extract, ok := m.sysConfig.FormatConfig["extract_final"].(bool); ok {
+		stream.extractFinal = extract
+	}
+
+	stream.parser = harmony.NewStreamParser(func(channel harmony.Channel, text string) {
+		if stream.extractFinal && channel == harmony.ChannelFinal && stream.onText != nil {
+			stream.onText(text)
+		}
+	})
+	stream.parser.StopOnToolCall = p.stopOnToolCall
+
+	return stream
+}
+
+// active reports whether generated pieces need to be passed back from the binding
+func (s *outputStream) active() bool {
+	return s.parser != nil || s.onText != nil
+}
+
+// push handles one generated piece and reports whether generation should continue
+func (s *outputStream) push(piece string) bool {
+	if s.onText != nil && !s.extractFinal {
+		s.onText(piece)
+	}
+	if s.parser != nil {
+		return !s.parser.Push(piece)
+	}
+	return true
+}
+
+// finish returns the user-facing response for the complete generated text
+func (s *outputStream) finish(text string) string {
+	if s.parser == nil {
+		// Post-process response using clean formatter system
+		return ParseResponseWithConfig(text, s.model.config.ModelPath, s.model.sysConfig)
+	}
+
+	s.parser.Close()
+	if !s.extractFinal {
+		return text
+	}
+	if final := s.parser.Response().FinalResponse; final != "" {
+		return final
+	}
+	return text
+}
+
+// parseResponse returns the user-facing response for text generated without streaming
+func (m *Model) parseResponse(p *generationParams, text string) string {
+	stream := m.newOutputStream(p, nil)
+	stream.push(text)
+	return stream.finish(text)
+}
+
+//export goTokenCallback
+func goTokenCallback(userData C.uintptr_t, piece *C.char, length C.int) C.bool {
+	stream := cgo.Handle(userData).Value().(*outputStream)
+	return C.bool(stream.push(C.GoStringN(piece, length)))
+}
@@ -18,6 +18,8 @@ type PromptTemplate struct {
 	UserSuffix  string `json:"user_suffix"`
 	ModelPrefix string `json:"model_prefix"`
 	ModelSuffix string `json:"model_suffix,omitempty"`
+	ThinkStart  string `json:"think_start,omitempty"` // Opens reasoning output of thinking models
+	ThinkEnd    string `json:"think_end,omitempty"`   // Closes reasoning output before the answer
 }
 
 func loadTemplate(modelDir string) (*PromptTemplate, error) {
@@ -0,0 +1,225 @@
+package llama
+
+/*
+#include "binding.h"
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"fmt"
+	"log/slog"
+	"strings"
+	"sync"
+	"unsafe"
+)
+
+// templateTokens are the cached tokens of a fixed template fragment. The tokenizer
+// only splits text at special tokens, so the tokens from the first to the last
+// special token of a fragment are the same wherever it is used. The text before and
+// after them may merge with neighbouring request content and is tokenized with it.
+type templateTokens struct {
+	lead   string  // Text before the first special token, all of it if there is none
+	tokens []int32 // First to last special token
+	trail  string  // Text after the last special token
+}
+
+// fragmentCache holds the tokens of fixed prompt template fragments. Template text
+// is tokenized once per model and reused for every request, which also keeps the
+// token prefix of a prompt identical across requests.
+type fragmentCache struct {
+	mu     sync.RWMutex
+	tokens map[string]templateTokens
+}
+
+func newFragmentCache() *fragmentCache {
+	return &fragmentCache{
+		tokens: make(map[string]templateTokens),
+	}
+}
+
+func (c *fragmentCache) get(text string) (templateTokens, bool) {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	tokens, ok := c.tokens[text]
+	return tokens, ok
+}
+
+func (c *fragmentCache) put(text string, tokens templateTokens) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.tokens[text] = tokens
+}
+
+func (c *fragmentCache) size() int {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	return len(c.tokens)
+}
+
+// tokenize converts text to model tokens without requiring a context
+func (m *Model) tokenize(text string, addSpecial, parseSpecial bool) ([]int32, error) {
+	if text == "" {
+		return nil, nil
+	}
+
+	cText := C.CString(text)
+	defer C.free(unsafe.Pointer(cText))
+
+	// A token never spans less than one byte, so this is enough room in practice
+	tokens := make([]int32, len(text)+2)
+	n := int(C.tokenize_text(m.model, cText, C.int(len(text)), C.bool(addSpecial), C.bool(parseSpecial),
+		(*C.int32_t)(unsafe.Pointer(&tokens[0])), C.int(len(tokens))))
+
+	if n < 0 {
+		// Buffer was too small, retry with the exact size reported by the tokenizer
+		tokens = make([]int32, -n)
+		n = int(C.tokenize_text(m.model, cText, C.int(len(text)), C.bool(addSpecial), C.bool(parseSpecial),
+			(*C.int32_t)(unsafe.Pointer(&tokens[0])), C.int(len(tokens))))
+		if n < 0 {
+			return nil, fmt.Errorf("tokenization failed")
+		}
+	}
+
+	return tokens[:n], nil
+}
+
+// CountTokens returns the number of tokens a formatted prompt is encoded to
+func (m *Model) CountTokens(text string) (int, error) {
+	tokens, err := m.tokenize(text, true, true)
+	return len(tokens), err
+}
+
+// specialPiece returns the text of token if the tokenizer splits text at it
+func (m *Model) specialPiece(token int32) (string, bool) {
+	if !bool(C.token_is_special(m.model, C.int32_t(token))) {
+		return "", false
+	}
+	return m.tokenPiece(token), true
+}
+
+// splitTemplate separates the special-token run of a fixed fragment from the text
+// around it. A fragment whose special tokens cannot be located in its text is kept
+// as text.
+func splitTemplate(text string, tokens []int32, special func(int32) (string, bool)) templateTokens {
+	first, last := -1, -1
+	for i, token := range tokens {
+		if _, ok := special(token); ok {
+			if first < 0 {
+				first = i
+			}
+			last = i
+		}
+	}
+	if first < 0 {
+		return templateTokens{lead: text}
+	}
+
+	firstPiece, _ := special(tokens[first])
+	lastPiece, _ := special(tokens[last])
+	start := strings.Index(text, firstPiece)
+	end := strings.LastIndex(text, lastPiece)
+	if firstPiece == "" || lastPiece == "" || start < 0 || end < start {
+		return templateTokens{lead: text}
+	}
+	return templateTokens{
+		lead:   text[:start],
+		tokens: tokens[first : last+1],
+		trail:  text[end+len(lastPiece):],
+	}
+}
+
+// fragmentTokens returns the cached tokens for a fixed template fragment
+func (m *Model) fragmentTokens(text string) (templateTokens, error) {
+	if tokens, ok := m.fragments.get(text); ok {
+		return tokens, nil
+	}
+
+	// Template fragments carry special tokens like <|im_start|> that must be parsed
+	tokens, err := m.tokenize(text, false, true)
+	if err != nil {
+		return templateTokens{}, err
+	}
+
+	template := splitTemplate(text, tokens, m.specialPiece)
+	m.fragments.put(text, template)
+	return template, nil
+}
+
+// assembleTokens appends the tokens of fragments to tokens as if their joined text
+// was tokenized at once. Request content is tokenized together with the template
+// text around it up to the nearest special tokens, only the special-token runs of
+// fixed fragments come from the cache.
+func assembleTokens(tokens []int32, fragments []PromptFragment, template func(string) (templateTokens, error), tokenize func(string) ([]int32, error)) ([]int32, error) {
+	var pending strings.Builder
+	flush := func() error {
+		if pending.Len() == 0 {
+			return nil
+		}
+		textTokens, err := tokenize(pending.String())
+		if err != nil {
+			return err
+		}
+		tokens = append(tokens, textTokens...)
+		pending.Reset()
+		return nil
+	}
+
+	for _, fragment := range fragments {
+		if fragment.Text == "" {
+			continue
+		}
+		if !fragment.Fixed {
+			pending.WriteString(fragment.Text)
+			continue
+		}
+
+		t, err := template(fragment.Text)
+		if err != nil {
+			return nil, err
+		}
+		pending.WriteString(t.lead)
+		if len(t.tokens) == 0 {
+			continue
+		}
+		if err := flush(); err != nil {
+			return nil, err
+		}
+		tokens = append(tokens, t.tokens...)
+		pending.WriteString(t.trail)
+	}
+
+	if err := flush(); err != nil {
+		return nil, err
+	}
+	return tokens, nil
+}
+
+// promptTokens assembles the prompt token sequence from cached fragment tokens and
+// the tokenized request content
+func (m *Model) promptTokens(fragments []PromptFragment) ([]int32, error) {
+	tokens := make([]int32, 0, 256)
+	if m.info.bosToken >= 0 {
+		tokens = append(tokens, m.info.bosToken)
+	}
+
+	return assembleTokens(tokens, fragments, m.fragmentTokens, func(text string) ([]int32, error) {
+		return m.tokenize(text, false, true)
+	})
+}
+
+// warmFragmentCache pre-tokenizes the fixed fragments of the configured prompt format
+// so the first request does not pay for template tokenization
+func (m *Model) warmFragmentCache() {
+	fragments := FormatFragmentsWithConfig("", m.config.ModelPath, m.sysConfig)
+
+	for _, fragment := range fragments {
+		if !fragment.Fixed || fragment.Text == "" {
+			continue
+		}
+		if _, err := m.fragmentTokens(fragment.Text); err != nil {
+			slog.Warn("Failed to pre-tokenize template fragment", "error", err)
+		}
+	}
+
+	slog.Info("Template fragments pre-tokenized", "fragments", m.fragments.size())
+}
@@ -0,0 +1,160 @@
+package llama
+
+import (
+	"reflect"
+	"strings"
+	"testing"
+)
+
+var testSpecialTokens = []string{"<|im_start|>", "<|im_end|>", "<start_of_turn>", "<end_of_turn>"}
+
+// testTokenizer splits text at special tokens like llama.cpp does and encodes the
+// text between them as words that carry their leading space. Like a SentencePiece
+// vocabulary it prefixes a space to text that starts the input or follows a special
+// token, so where text is split changes its tokens.
+type testTokenizer struct {
+	ids    map[string]int32
+	pieces []string
+}
+
+func newTestTokenizer() *testTokenizer {
+	return &testTokenizer{ids: make(map[string]int32)}
+}
+
+func (t *testTokenizer) id(piece string) int32 {
+	if id, ok := t.ids[piece]; ok {
+		return id
+	}
+	id := int32(len(t.pieces))
+	t.ids[piece] = id
+	t.pieces = append(t.pieces, piece)
+	return id
+}
+
+func (t *testTokenizer) special(token int32) (string, bool) {
+	for _, s := range testSpecialTokens {
+		if t.pieces[token] == s {
+			return s, true
+		}
+	}
+	return "", false
+}
+
+func (t *testTokenizer) tokenize(text string) ([]int32, error) {
+	var tokens []int32
+	afterSpecial := true
+	for text != "" {
+		next, length := len(text), 0
+		for _, s := range testSpecialTokens {
+			if i := strings.Index(text, s); i >= 0 && i < next {
+				next, length = i, len(s)
+			}
+		}
+		if next > 0 {
+			tokens = append(tokens, t.words(text[:next], afterSpecial)...)
+			afterSpecial = false
+		}
+		if length > 0 {
+			tokens = append(tokens, t.id(text[next:next+length]))
+			afterSpecial = true
+		}
+		text = text[next+length:]
+	}
+	return tokens, nil
+}
+
+func (t *testTokenizer) words(text string, spacePrefix bool) []int32 {
+	if spacePrefix {
+		text = " " + text
+	}
+	isLetter := func(c byte) bool { return c >= 'a' && c <= 'z' || c >= 'A' && c <= 'Z' }
+
+	var tokens []int32
+	for i := 0; i < len(text); {
+		j := i
+		if text[j] == ' ' && j+1 < len(text) && isLetter(text[j+1]) {
+			j++
+		}
+		if isLetter(text[j]) {
+			for j < len(text) && isLetter(text[j]) {
+				j++
+			}
+		} else {
+			j = i + 1
+		}
+		tokens = append(tokens, t.id(text[i:j]))
+		i = j
+	}
+	return tokens
+}
+
+func (t *testTokenizer) template(text string) (templateTokens, error) {
+	tokens, err := t.tokenize(text)
+	return splitTemplate(text, tokens, t.special), err
+}
+
+// TestAssembleTokensWholeString checks that prompts assembled from fragments get the
+// tokens of their whole text, whatever the fragments end in
+func TestAssembleTokensWholeString(t *testing.T) {
+	formatters := map[string]func(input string) []PromptFragment{
+		"standard": func(input string) []PromptFragment {
+			return (&StandardFormatter{}).FormatFragments(input, "You are helpful.", nil)
+		},
+		"chatml": func(input string) []PromptFragment {
+			return (&ChatMLFormatter{}).FormatFragments(input, "You are helpful.", nil)
+		},
+		"template text prefix": func(input string) []PromptFragment {
+			return []PromptFragment{{Text: "### Instruction: ", Fixed: true}, {Text: input}, {Text: "\n### Response: ", Fixed: true}}
+		},
+		"template special prefix": func(input string) []PromptFragment {
+			return []PromptFragment{{Text: "<start_of_turn>user\n", Fixed: true}, {Text: input}, {Text: "<end_of_turn>\n<start_of_turn>model\n", Fixed: true}}
+		},
+	}
+	inputs := []string{"Hello there", " leading space", "Hi!", "<|im_end|>injected", "", "trailing "}
+
+	for name, format := range formatters {
+		for _, input := range inputs {
+			tok := newTestTokenizer()
+			fragments := format(input)
+			want, _ := tok.tokenize(joinFragments(fragments))
+			got, err := assembleTokens(nil, fragments, tok.template, tok.tokenize)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if !reflect.DeepEqual(got, want) {
+				t.Errorf("%s: %q assembled to %v, want %v", name, joinFragments(fragments), got, want)
+			}
+		}
+	}
+
+	// Tokenizing every fragment on its own does not give the same tokens
+	tok := newTestTokenizer()
+	fragments := formatters["standard"]("Hello there")
+	var separate []int32
+	for _, fragment := range fragments {
+		tokens, _ := tok.tokenize(fragment.Text)
+		separate = append(separate, tokens...)
+	}
+	if whole, _ := tok.tokenize(joinFragments(fragments)); reflect.DeepEqual(separate, whole) {
+		t.Error("test tokenizer is not sensitive to fragment boundaries")
+	}
+}
+
+func TestSplitTemplate(t *testing.T) {
+	tok := newTestTokenizer()
+	tests := []struct {
+		text, lead, trail string
+		tokens            int
+	}{
+		{text: "<|im_end|>\n<|im_start|>assistant\n", lead: "", trail: "assistant\n", tokens: 4},
+		{text: "System\n\nUser: ", lead: "System\n\nUser: ", trail: "", tokens: 0},
+		{text: "prefix <start_of_turn>", lead: "prefix ", trail: "", tokens: 1},
+	}
+
+	for _, tt := range tests {
+		template, _ := tok.template(tt.text)
+		if template.lead != tt.lead || template.trail != tt.trail || len(template.tokens) != tt.tokens {
+			t.Errorf("%q split into %q, %d tokens, %q", tt.text, template.lead, len(template.tokens), template.trail)
+		}
+	}
+}
@@ -0,0 +1,164 @@
+package services
+
+import (
+	"fmt"
+	"sync"
+	"time"
+)
+
+// promptTokenCost is the cost of a prompt token relative to a generated token. Prompts
+// are decoded in large batches, so a prompt token is far cheaper than a decode step.
+const promptTokenCost = 0.1
+
+// admissionAlpha weights the latest finished request in the throughput averages
+const admissionAlpha = 0.2
+
+// defaultOutputTokens is the expected output of a request before any has finished
+const defaultOutputTokens = 256
+
+type admissionDecision int
+
+const (
+	admissionAccept admissionDecision = iota
+	admissionDelay
+	admissionReject
+)
+
+// AdmissionStats reports admission control state and counters
+type AdmissionStats struct {
+	InflightTokens int64   `json:"inflight_tokens"` // KV tokens reserved by running requests
+	TokenBudget    int64   `json:"token_budget"`
+	TokensPerSec   float64 `json:"tokens_per_sec"` // Measured generation throughput, 0 until a request finished
+	Admitted       int64   `json:"admitted"`
+	Delayed        int64   `json:"delayed"`
+	Rejected       int64   `json:"rejected"`
+}
+
+// admissionTicket is the KV reservation of an admitted request
+type admissionTicket struct {
+	tokens int64
+}
+
+// AdmissionController estimates the cost of each request from its prompt tokens and
+// max_tokens and admits it only if the worker has KV room for it and, at the measured
+// throughput, it can finish before its deadline. Requests that could fit later are
+// delayed, the rest are rejected up front instead of timing out after using the model.
+type AdmissionController struct {
+	mu           sync.Mutex
+	budget       int64
+	ctxSize      int
+	inflight     int64
+	secPerToken  float64 // Seconds per cost token, 0 until measured
+	outputTokens float64 // Average generated tokens per request
+
+	admitted int64
+	delayed  int64
+	rejected int64
+}
+
+// NewAdmissionController limits running requests to tokenBudget reserved KV tokens
+func NewAdmissionController(tokenBudget, ctxSize int) *AdmissionController {
+	return &AdmissionController{
+		budget:       int64(tokenBudget),
+		ctxSize:      ctxSize,
+		outputTokens: defaultOutputTokens,
+	}
+}
+
+// Admit decides on a request of promptTokens that may generate up to maxOutput tokens
+// and must finish within remaining. Admitted requests get a ticket to Release, others
+// the reason they were delayed or rejected. Requests are only delayed if canDelay and
+// a retry after retryDelay could still finish in time.
+func (a *AdmissionController) Admit(promptTokens, maxOutput int, remaining, retryDelay time.Duration, canDelay bool) (*admissionTicket, admissionDecision, string) {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+
+	if promptTokens >= a.ctxSize {
+		return a.reject(fmt.Sprintf("prompt of %d tokens does not fit the context of %d", promptTokens, a.ctxSize))
+	}
+	if remaining <= 0 {
+		return a.reject(fmt.Sprintf("deadline passed %s before the request started", (-remaining).Round(time.Millisecond)))
+	}
+
+	// Time is estimated on the expected output, KV is reserved for the worst case
+	expected := float64(maxOutput)
+	if expected > a.outputTokens {
+		expected = a.outputTokens
+	}
+	cost := float64(promptTokens)*promptTokenCost + expected
+	estimate := time.Duration(cost * a.secPerToken * float64(time.Second))
+	if estimate > remaining {
+		return a.reject(fmt.Sprintf("estimated %s exceeds the remaining %s", estimate.Round(time.Millisecond), remaining.Round(time.Millisecond)))
+	}
+
+	// maxOutput is already bounded by the context the request will get, which for
+	// shared-prefill samples is larger than CTX_SIZE
+	tokens := int64(promptTokens + maxOutput)
+	if a.inflight > 0 && a.inflight+tokens > a.budget {
+		reason := fmt.Sprintf("%d KV tokens in use of %d, request needs %d", a.inflight, a.budget, tokens)
+		if canDelay && estimate+retryDelay < remaining {
+			a.delayed++
+			return nil, admissionDelay, reason
+		}
+		return a.reject(reason)
+	}
+
+	a.inflight += tokens
+	a.admitted++
+	return &admissionTicket{tokens: tokens}, admissionAccept, ""
+}
+
+func (a *AdmissionController) reject(reason string) (*admissionTicket, admissionDecision, string) {
+	a.rejected++
+	return nil, admissionReject, reason
+}
+
+// Release returns the reservation of a finished request and learns throughput from
+// its response
+func (a *AdmissionController) Release(ticket *admissionTicket, promptTokens int, response *InferenceResponse) {
+	if a == nil || ticket == nil {
+		return
+	}
+
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	a.inflight -= ticket.tokens
+
+	// Cached and failed requests say nothing about generation speed
+	if response == nil || response.Error != "" || response.Cached != "" || response.TokensOut == 0 {
+		return
+	}
+	cost := float64(promptTokens)*promptTokenCost + float64(response.TokensOut)
+	secPerToken := float64(response.DurationMs) / 1000 / cost
+	if a.secPerToken == 0 {
+		a.secPerToken = secPerToken
+	} else {
+		a.secPerToken += admissionAlpha * (secPerToken - a.secPerToken)
+	}
+	a.outputTokens += admissionAlpha * (float64(response.TokensOut) - a.outputTokens)
+}
+
+// Overloaded reports whether running requests hold the whole token budget
+func (a *AdmissionController) Overloaded() bool {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	return a.inflight >= a.budget
+}
+
+// Stats returns a snapshot of the admission state
+func (a *AdmissionController) Stats() AdmissionStats {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+
+	stats := AdmissionStats{
+		InflightTokens: a.inflight,
+		TokenBudget:    a.budget,
+		Admitted:       a.admitted,
+		Delayed:        a.delayed,
+		Rejected:       a.rejected,
+	}
+	if a.secPerToken > 0 {
+		stats.TokensPerSec = 1 / a.secPerToken
+	}
+	return stats
+}
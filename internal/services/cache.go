@@ -0,0 +1,450 @@
+package services
+
+import (
+	"container/list"
+	"context"
+	"crypto/sha256"
+	"encoding/hex"
+	"encoding/json"
+	"fmt"
+	"log/slog"
+	"math"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/nats-io/nats.go"
+	"github.com/aigoflow/inference-service/internal/config"
+)
+
+// cacheEntryOverhead approximates the bookkeeping bytes of one entry beyond its payload
+const cacheEntryOverhead = 256
+
+// PromptEmbedder returns an embedding of text for the semantic cache tier
+type PromptEmbedder func(ctx context.Context, text string) ([]float32, error)
+
+// CacheStats reports completion cache effectiveness
+type CacheStats struct {
+	ExactHits    int64   `json:"exact_hits"`
+	SemanticHits int64   `json:"semantic_hits"`
+	SharedHits   int64   `json:"shared_hits"` // Requests that joined an identical request in flight
+	Misses       int64   `json:"misses"`
+	Bypassed     int64   `json:"bypassed"` // Requests not eligible for caching
+	Evictions    int64   `json:"evictions"`
+	Entries      int     `json:"entries"`
+	Bytes        int64   `json:"bytes"`
+	HitRate      float64 `json:"hit_rate"` // Hits over eligible lookups
+}
+
+type cacheEntry struct {
+	key       string
+	partition string
+	vector    []float32
+	response  InferenceResponse
+	size      int64
+	expires   time.Time
+	element   *list.Element
+}
+
+// cacheLookup carries what a miss computed so the response can be stored without
+// hashing or embedding the prompt again
+type cacheLookup struct {
+	key       string
+	partition string
+	vector    []float32
+	call      *inflightCall // Set when this request generates for identical requests waiting on it
+}
+
+// inflightCall is a generation that identical requests wait on instead of repeating
+type inflightCall struct {
+	done     chan struct{}
+	response *InferenceResponse // nil if the generation failed
+}
+
+// CompletionCache serves completions of repeated prompts from memory. The exact tier
+// matches on model file, formatted prompt, params and grammar, and identical requests
+// arriving while one is generating wait for it instead of generating again. The
+// optional semantic tier embeds the user text and matches earlier prompts that share
+// everything else and are similar enough. Entries expire after a TTL and the least
+// recently used go first once the byte budget is reached.
+type CompletionCache struct {
+	mu         sync.Mutex
+	entries    map[string]*cacheEntry
+	partitions map[string]map[*cacheEntry]struct{}
+	inflight   map[string]*inflightCall
+	lru        *list.List
+	bytes      int64
+
+	model          string // Identity of the model file, see modelIdentity
+	ttl            time.Duration
+	maxBytes       int64
+	sampled        bool // Also cache sampled requests up to maxTemperature
+	maxTemperature float64
+	similarity     float32
+	embed          PromptEmbedder
+
+	exactHits    int64
+	semanticHits int64
+	sharedHits   int64
+	misses       int64
+	bypassed     int64
+	evictions    int64
+}
+
+// NewCompletionCache creates a cache configured from cfg. Deterministic requests are
+// always cached; sampled requests and the semantic tier need COMPLETION_CACHE. embed
+// may be nil to use exact matching only.
+func NewCompletionCache(cfg *config.Config, embed PromptEmbedder) *CompletionCache {
+	return &CompletionCache{
+		entries:        make(map[string]*cacheEntry),
+		partitions:     make(map[string]map[*cacheEntry]struct{}),
+		inflight:       make(map[string]*inflightCall),
+		lru:            list.New(),
+		model:          modelIdentity(cfg.ModelPath),
+		ttl:            cfg.CacheTTL,
+		maxBytes:       int64(cfg.CacheMaxBytes),
+		sampled:        cfg.CompletionCache,
+		maxTemperature: cfg.CacheMaxTemperature,
+		similarity:     float32(cfg.CacheSimilarity),
+		embed:          embed,
+	}
+}
+
+// modelIdentity identifies the model file by path, size and modification time, so a
+// replaced model never serves answers of the old one. Hashing the weights would cost
+// seconds per gigabyte at startup.
+func modelIdentity(path string) string {
+	info, err := os.Stat(path)
+	if err != nil {
+		return path
+	}
+	return fmt.Sprintf("%s:%d:%d", path, info.Size(), info.ModTime().UnixNano())
+}
+
+// eligible reports which tiers a request may use. Single completions are decoded
+// greedily and so are deterministic; several samples are only reused when sampled
+// caching is enabled and the temperature is low enough.
+func (c *CompletionCache) eligible(req InferenceRequest) (exact bool, semantic bool) {
+	if cache, ok := req.Params["cache"].(bool); ok && !cache {
+		return false, false
+	}
+	temperature := 0.7
+	if v, ok := req.Params["temperature"].(float64); ok {
+		temperature = v
+	}
+	n := 1.0
+	if v, ok := req.Params["n"].(float64); ok {
+		n = v
+	}
+
+	sampled := c.sampled && temperature <= c.maxTemperature
+	return n <= 1 || temperature <= 0 || sampled, sampled && c.embed != nil
+}
+
+// Lookup returns a cached response for the request and the tier that matched, or the
+// lookup state to pass to Finish once the response has been generated. A request
+// identical to one being generated waits for that generation.
+func (c *CompletionCache) Lookup(ctx context.Context, req InferenceRequest, formattedInput, grammar string) (*InferenceResponse, string, *cacheLookup) {
+	exact, semantic := c.eligible(req)
+	if !exact {
+		atomic.AddInt64(&c.bypassed, 1)
+		return nil, "", nil
+	}
+
+	params := toJSON(req.Params)
+	lookup := &cacheLookup{key: hashKey(c.model, params, grammar, formattedInput)}
+	if response, ok := c.get(lookup.key); ok {
+		atomic.AddInt64(&c.exactHits, 1)
+		return response, "exact", nil
+	}
+
+	if response, ok := c.join(ctx, lookup); ok {
+		atomic.AddInt64(&c.sharedHits, 1)
+		return response, "shared", nil
+	}
+
+	if semantic {
+		if text, prior := semanticText(req); text != "" {
+			lookup.partition = hashKey(c.model, params, fmt.Sprintf("%t", req.Raw), prior)
+			vector, err := c.embed(ctx, text)
+			if err != nil {
+				slog.Debug("Semantic cache embedding failed", "req_id", req.ReqID, "error", err)
+			} else {
+				lookup.vector = normalizeVector(vector)
+				if response, ok := c.nearest(lookup.partition, lookup.vector); ok {
+					atomic.AddInt64(&c.semanticHits, 1)
+					c.release(lookup, response)
+					return response, "semantic", nil
+				}
+			}
+		}
+	}
+
+	atomic.AddInt64(&c.misses, 1)
+	return nil, "", lookup
+}
+
+// join waits for an identical request in flight and returns its response. Otherwise
+// the lookup becomes the generation others wait on. If the generation fails the
+// waiters return without a response and generate themselves.
+func (c *CompletionCache) join(ctx context.Context, lookup *cacheLookup) (*InferenceResponse, bool) {
+	c.mu.Lock()
+	call, ok := c.inflight[lookup.key]
+	if !ok {
+		lookup.call = &inflightCall{done: make(chan struct{})}
+		c.inflight[lookup.key] = lookup.call
+	}
+	c.mu.Unlock()
+	if !ok {
+		return nil, false
+	}
+
+	select {
+	case <-call.done:
+	case <-ctx.Done():
+		return nil, false
+	}
+	if call.response == nil {
+		return nil, false
+	}
+	response := *call.response
+	return &response, true
+}
+
+// Finish stores a successful response under the lookup of its request and releases
+// identical requests waiting on it. It must be called for every lookup returned by
+// Lookup, with a nil response if generation failed.
+func (c *CompletionCache) Finish(lookup *cacheLookup, response *InferenceResponse) {
+	if lookup == nil {
+		return
+	}
+	if response != nil && response.Error != "" {
+		response = nil
+	}
+
+	c.release(lookup, response)
+	if response != nil {
+		c.store(lookup, response)
+	}
+}
+
+// release hands the response to requests waiting on the lookup's generation
+func (c *CompletionCache) release(lookup *cacheLookup, response *InferenceResponse) {
+	if lookup.call == nil {
+		return
+	}
+
+	c.mu.Lock()
+	delete(c.inflight, lookup.key)
+	c.mu.Unlock()
+	if response != nil {
+		shared := *response
+		lookup.call.response = &shared
+	}
+	close(lookup.call.done)
+	lookup.call = nil
+}
+
+func (c *CompletionCache) store(lookup *cacheLookup, response *InferenceResponse) {
+	entry := &cacheEntry{
+		key:      lookup.key,
+		response: *response,
+		expires:  time.Now().Add(c.ttl),
+	}
+	if lookup.vector != nil {
+		entry.partition = lookup.partition
+		entry.vector = lookup.vector
+	}
+	entry.size = int64(len(toJSON(response)) + len(entry.vector)*4 + cacheEntryOverhead)
+	if entry.size > c.maxBytes {
+		return
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if old, ok := c.entries[entry.key]; ok {
+		c.remove(old)
+	}
+	c.entries[entry.key] = entry
+	entry.element = c.lru.PushFront(entry)
+	c.bytes += entry.size
+	if entry.vector != nil {
+		partition := c.partitions[entry.partition]
+		if partition == nil {
+			partition = make(map[*cacheEntry]struct{})
+			c.partitions[entry.partition] = partition
+		}
+		partition[entry] = struct{}{}
+	}
+
+	for c.bytes > c.maxBytes {
+		c.remove(c.lru.Back().Value.(*cacheEntry))
+		atomic.AddInt64(&c.evictions, 1)
+	}
+}
+
+func (c *CompletionCache) get(key string) (*InferenceResponse, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	entry, ok := c.entries[key]
+	if !ok {
+		return nil, false
+	}
+	if time.Now().After(entry.expires) {
+		c.remove(entry)
+		return nil, false
+	}
+	c.lru.MoveToFront(entry.element)
+	response := entry.response
+	return &response, true
+}
+
+// nearest returns the response of the most similar live entry of the partition
+func (c *CompletionCache) nearest(partition string, vector []float32) (*InferenceResponse, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	now := time.Now()
+	var best *cacheEntry
+	bestScore := c.similarity
+	for entry := range c.partitions[partition] {
+		if now.After(entry.expires) {
+			c.remove(entry)
+			continue
+		}
+		if score := dotProduct(vector, entry.vector); score >= bestScore {
+			best, bestScore = entry, score
+		}
+	}
+	if best == nil {
+		return nil, false
+	}
+
+	c.lru.MoveToFront(best.element)
+	response := best.response
+	return &response, true
+}
+
+// remove drops an entry, the caller holds the lock
+func (c *CompletionCache) remove(entry *cacheEntry) {
+	delete(c.entries, entry.key)
+	c.lru.Remove(entry.element)
+	c.bytes -= entry.size
+	if partition, ok := c.partitions[entry.partition]; ok {
+		delete(partition, entry)
+		if len(partition) == 0 {
+			delete(c.partitions, entry.partition)
+		}
+	}
+}
+
+// Stats returns hit and size counters
+func (c *CompletionCache) Stats() CacheStats {
+	c.mu.Lock()
+	entries, bytes := len(c.entries), c.bytes
+	c.mu.Unlock()
+
+	stats := CacheStats{
+		ExactHits:    atomic.LoadInt64(&c.exactHits),
+		SemanticHits: atomic.LoadInt64(&c.semanticHits),
+		SharedHits:   atomic.LoadInt64(&c.sharedHits),
+		Misses:       atomic.LoadInt64(&c.misses),
+		Bypassed:     atomic.LoadInt64(&c.bypassed),
+		Evictions:    atomic.LoadInt64(&c.evictions),
+		Entries:      entries,
+		Bytes:        bytes,
+	}
+	hits := stats.ExactHits + stats.SemanticHits + stats.SharedHits
+	if lookups := hits + stats.Misses; lookups > 0 {
+		stats.HitRate = float64(hits) / float64(lookups)
+	}
+	return stats
+}
+
+// semanticText splits a request into the user text compared by similarity and the
+// context that must match exactly: the earlier turns of a conversation
+func semanticText(req InferenceRequest) (text string, prior string) {
+	if len(req.Messages) == 0 {
+		return req.Input, ""
+	}
+	last := req.Messages[len(req.Messages)-1]
+	if last.Role != "user" {
+		return "", ""
+	}
+	return last.Content, toJSON(req.Messages[:len(req.Messages)-1])
+}
+
+func hashKey(parts ...string) string {
+	h := sha256.New()
+	for _, part := range parts {
+		h.Write([]byte(part))
+		h.Write([]byte{0})
+	}
+	return hex.EncodeToString(h.Sum(nil))
+}
+
+func dotProduct(a, b []float32) float32 {
+	if len(a) != len(b) {
+		return 0
+	}
+	var sum float32
+	for i := range a {
+		sum += a[i] * b[i]
+	}
+	return sum
+}
+
+func normalizeVector(vector []float32) []float32 {
+	norm := math.Sqrt(float64(dotProduct(vector, vector)))
+	out := make([]float32, len(vector))
+	if norm == 0 {
+		return out
+	}
+	for i, x := range vector {
+		out[i] = float32(float64(x) / norm)
+	}
+	return out
+}
+
+// NewNATSPromptEmbedder embeds prompts with the embedding worker serving subject
+func NewNATSPromptEmbedder(conn *nats.Conn, subject string, timeout time.Duration) PromptEmbedder {
+	return func(ctx context.Context, text string) ([]float32, error) {
+		inbox := nats.NewInbox()
+		sub, err := conn.SubscribeSync(inbox)
+		if err != nil {
+			return nil, fmt.Errorf("failed to subscribe embedding reply: %w", err)
+		}
+		defer sub.Unsubscribe()
+
+		request, _ := json.Marshal(EmbeddingRequest{
+			ReqID:   fmt.Sprintf("cache-%d", time.Now().UnixNano()),
+			Input:   text,
+			ReplyTo: inbox,
+		})
+		if err := conn.Publish(subject, request); err != nil {
+			return nil, fmt.Errorf("failed to publish embedding request: %w", err)
+		}
+
+		ctx, cancel := context.WithTimeout(ctx, timeout)
+		defer cancel()
+		msg, err := sub.NextMsgWithContext(ctx)
+		if err != nil {
+			return nil, fmt.Errorf("embedding reply: %w", err)
+		}
+
+		var response EmbeddingResponse
+		if err := json.Unmarshal(msg.Data, &response); err != nil {
+			return nil, fmt.Errorf("failed to parse embedding response: %w", err)
+		}
+		if response.Error != "" {
+			return nil, fmt.Errorf("embedding error: %s", response.Error)
+		}
+		if len(response.Data) == 0 {
+			return nil, fmt.Errorf("empty embedding response")
+		}
+		return response.Data[0].Embedding, nil
+	}
+}
@@ -0,0 +1,87 @@
+package services
+
+import (
+	"context"
+	"sync"
+	"time"
+)
+
+// CancelRequest asks the worker generating req_id to stop
+type CancelRequest struct {
+	ReqID string `json:"req_id"`
+}
+
+type CancelResponse struct {
+	ReqID     string `json:"req_id"`
+	Cancelled bool   `json:"cancelled"`
+}
+
+type runningRequest struct {
+	cancel context.CancelFunc
+}
+
+// cancelRegistry maps the req_id of requests being generated to their cancel functions.
+// Cancels for requests not started yet are remembered for maxAge, so a request still
+// queued when its requester gave up stops as soon as it starts.
+type cancelRegistry struct {
+	mu      sync.Mutex
+	running map[string]*runningRequest
+	pending map[string]time.Time
+	maxAge  time.Duration
+}
+
+func newCancelRegistry(maxAge time.Duration) *cancelRegistry {
+	return &cancelRegistry{
+		running: make(map[string]*runningRequest),
+		pending: make(map[string]time.Time),
+		maxAge:  maxAge,
+	}
+}
+
+// start returns a context that is cancelled by cancel(reqID) and a function to call
+// once the request is done
+func (r *cancelRegistry) start(ctx context.Context, reqID string) (context.Context, func()) {
+	if reqID == "" {
+		return ctx, func() {}
+	}
+
+	ctx, cancel := context.WithCancel(ctx)
+	run := &runningRequest{cancel: cancel}
+
+	r.mu.Lock()
+	if _, ok := r.pending[reqID]; ok {
+		delete(r.pending, reqID)
+		cancel()
+	}
+	r.running[reqID] = run
+	r.mu.Unlock()
+
+	return ctx, func() {
+		r.mu.Lock()
+		if r.running[reqID] == run {
+			delete(r.running, reqID)
+		}
+		r.mu.Unlock()
+		cancel()
+	}
+}
+
+// cancel stops reqID and reports whether it was running here
+func (r *cancelRegistry) cancel(reqID string) bool {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	if run, ok := r.running[reqID]; ok {
+		run.cancel()
+		return true
+	}
+
+	now := time.Now()
+	for id, at := range r.pending {
+		if now.Sub(at) > r.maxAge {
+			delete(r.pending, id)
+		}
+	}
+	r.pending[reqID] = now
+	return false
+}
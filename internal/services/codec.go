@@ -0,0 +1,364 @@
+package services
+
+import (
+	"encoding/json"
+	"fmt"
+
+	"github.com/aigoflow/inference-service/internal/fastjson"
+	"github.com/aigoflow/inference-service/internal/llama"
+)
+
+// Codecs for the messages of the NATS hot path. They decode and encode like
+// encoding/json with the struct tags of the types, without reflection. Keys match their
+// field exactly or else ignoring case, unknown keys are skipped and null leaves a field
+// unset. Invalid UTF-8 in strings decodes to U+FFFD.
+
+// Decoded keys of each type, in struct order
+var (
+	inferenceRequestFields = []string{"trace_id", "req_id", "input", "params", "reply_to", "raw", "messages", "stream", "deadline_ms"}
+	chatMessageFields      = []string{"role", "content"}
+	embeddingRequestFields = []string{"trace_id", "req_id", "input", "model", "pooling", "spans", "reply_to", "chunk_overlap", "split_chunks"}
+	audioRequestFields     = []string{"trace_id", "req_id", "audio_url", "audio_base64", "audio", "model", "language", "reply_to", "stream_chunks"}
+)
+
+func decodeInferenceRequest(data []byte, req *InferenceRequest) error {
+	r := fastjson.NewReader(data)
+	err := r.Object(func(key []byte) error {
+		if r.Null() {
+			return nil
+		}
+		var err error
+		switch fastjson.Field(key, inferenceRequestFields) {
+		case "trace_id":
+			req.TraceID, err = r.String()
+		case "req_id":
+			req.ReqID, err = r.String()
+		case "input":
+			req.Input, err = r.String()
+		case "params":
+			// Decoded once into the map the llama layer reads parameters from
+			var params interface{}
+			params, err = r.Value()
+			if m, ok := params.(map[string]interface{}); ok {
+				req.Params = m
+			} else if err == nil {
+				err = fmt.Errorf("params must be an object")
+			}
+		case "reply_to":
+			req.ReplyTo, err = r.String()
+		case "raw":
+			req.Raw, err = r.Bool()
+		case "messages":
+			// An empty array decodes to an empty slice, not nil
+			if req.Messages == nil {
+				req.Messages = []llama.ChatMessage{}
+			}
+			req.Messages = req.Messages[:0]
+			err = r.Array(func() error {
+				var msg llama.ChatMessage
+				if r.Null() {
+					req.Messages = append(req.Messages, msg)
+					return nil
+				}
+				err := r.Object(func(key []byte) error {
+					if r.Null() {
+						return nil
+					}
+					var err error
+					switch fastjson.Field(key, chatMessageFields) {
+					case "role":
+						msg.Role, err = r.String()
+					case "content":
+						msg.Content, err = r.String()
+					default:
+						err = r.Skip()
+					}
+					return err
+				})
+				req.Messages = append(req.Messages, msg)
+				return err
+			})
+		case "stream":
+			req.Stream, err = r.Bool()
+		case "deadline_ms":
+			req.DeadlineMs, err = r.Int()
+		default:
+			err = r.Skip()
+		}
+		if err != nil {
+			return fmt.Errorf("%s: %w", key, err)
+		}
+		return nil
+	})
+	if err != nil {
+		return err
+	}
+	return r.End()
+}
+
+func decodeEmbeddingRequest(data []byte, req *EmbeddingRequest) error {
+	r := fastjson.NewReader(data)
+	err := r.Object(func(key []byte) error {
+		if r.Null() {
+			return nil
+		}
+		var err error
+		switch fastjson.Field(key, embeddingRequestFields) {
+		case "trace_id":
+			req.TraceID, err = r.String()
+		case "req_id":
+			req.ReqID, err = r.String()
+		case "input":
+			req.Input, err = r.Value()
+		case "model":
+			req.Model, err = r.String()
+		case "pooling":
+			req.Pooling, err = r.String()
+		case "spans":
+			var raw []byte
+			if raw, err = r.Raw(); err == nil {
+				err = json.Unmarshal(raw, &req.Spans)
+			}
+		case "reply_to":
+			req.ReplyTo, err = r.String()
+		case "chunk_overlap":
+			var overlap int64
+			if overlap, err = r.Int(); err == nil {
+				n := int(overlap)
+				req.ChunkOverlap = &n
+			}
+		case "split_chunks":
+			req.SplitChunks, err = r.Bool()
+		default:
+			err = r.Skip()
+		}
+		if err != nil {
+			return fmt.Errorf("%s: %w", key, err)
+		}
+		return nil
+	})
+	if err != nil {
+		return err
+	}
+	return r.End()
+}
+
+// decodeAudioRequest decodes audio_base64 straight into Audio. Audio that does not
+// decode is kept in AudioBase64 for the service to report.
+func decodeAudioRequest(data []byte, req *AudioRequest) error {
+	r := fastjson.NewReader(data)
+	err := r.Object(func(key []byte) error {
+		if r.Null() {
+			return nil
+		}
+		var err error
+		switch fastjson.Field(key, audioRequestFields) {
+		case "trace_id":
+			req.TraceID, err = r.String()
+		case "req_id":
+			req.ReqID, err = r.String()
+		case "audio_url":
+			req.AudioURL, err = r.String()
+		case "audio_base64":
+			var raw []byte
+			if raw, err = r.Raw(); err != nil {
+				break
+			}
+			if audio, decodeErr := fastjson.NewReader(raw).Base64(); decodeErr == nil {
+				req.Audio = audio
+			} else {
+				err = json.Unmarshal(raw, &req.AudioBase64)
+			}
+		case "audio":
+			req.Audio, err = r.Base64()
+		case "model":
+			req.Model, err = r.String()
+		case "language":
+			req.Language, err = r.String()
+		case "reply_to":
+			req.ReplyTo, err = r.String()
+		case "stream_chunks":
+			req.StreamChunks, err = r.Bool()
+		default:
+			err = r.Skip()
+		}
+		if err != nil {
+			return fmt.Errorf("%s: %w", key, err)
+		}
+		return nil
+	})
+	if err != nil {
+		return err
+	}
+	return r.End()
+}
+
+func appendInferenceResponse(buf []byte, resp *InferenceResponse) ([]byte, error) {
+	w := fastjson.NewWriter(buf)
+	if resp == nil {
+		w.Null()
+		return w.Bytes(), nil
+	}
+
+	w.ObjectStart()
+	w.Key("req_id")
+	w.String(resp.ReqID)
+	w.Key("text")
+	w.String(resp.Text)
+	w.Key("tokens_in")
+	w.Int(int64(resp.TokensIn))
+	w.Key("tokens_out")
+	w.Int(int64(resp.TokensOut))
+	if resp.ReasoningTokens != 0 {
+		w.Key("reasoning_tokens")
+		w.Int(int64(resp.ReasoningTokens))
+	}
+	if resp.AnswerTokens != 0 {
+		w.Key("answer_tokens")
+		w.Int(int64(resp.AnswerTokens))
+	}
+	if len(resp.Choices) > 0 {
+		w.Key("choices")
+		w.ArrayStart()
+		for _, choice := range resp.Choices {
+			w.ObjectStart()
+			w.Key("text")
+			w.String(choice.Text)
+			w.Key("tokens_out")
+			w.Int(int64(choice.TokensOut))
+			w.Key("logprob")
+			w.Float64(choice.Logprob)
+			w.ObjectEnd()
+		}
+		w.ArrayEnd()
+	}
+	if resp.Logprobs != nil {
+		// Rarely requested, not worth a hand-written encoder
+		logprobs, err := json.Marshal(resp.Logprobs)
+		if err != nil {
+			return buf, err
+		}
+		w.Key("logprobs")
+		w.Raw(logprobs)
+	}
+	w.Key("finish_reason")
+	w.String(resp.FinishReason)
+	if resp.Cached != "" {
+		w.Key("cached")
+		w.String(resp.Cached)
+	}
+	w.Key("duration_ms")
+	w.Int(resp.DurationMs)
+	if resp.Error != "" {
+		w.Key("error")
+		w.String(resp.Error)
+	}
+	w.ObjectEnd()
+	return w.Bytes(), w.Err()
+}
+
+func appendEmbeddingResponse(buf []byte, resp *EmbeddingResponse) ([]byte, error) {
+	w := fastjson.NewWriter(buf)
+	if resp == nil {
+		w.Null()
+		return w.Bytes(), nil
+	}
+
+	w.ObjectStart()
+	w.Key("object")
+	w.String(resp.Object)
+	w.Key("data")
+	if resp.Data == nil {
+		w.Null()
+	} else {
+		w.ArrayStart()
+		for i := range resp.Data {
+			data := &resp.Data[i]
+			w.ObjectStart()
+			w.Key("object")
+			w.String(data.Object)
+			w.Key("embedding")
+			w.Float32s(data.Embedding)
+			w.Key("index")
+			w.Int(int64(data.Index))
+			if data.Chunk != 0 {
+				w.Key("chunk")
+				w.Int(int64(data.Chunk))
+			}
+			if len(data.Span) > 0 {
+				w.Key("span")
+				w.Ints(data.Span)
+			}
+			if len(data.TokenSpan) > 0 {
+				w.Key("token_span")
+				w.Ints(data.TokenSpan)
+			}
+			w.ObjectEnd()
+		}
+		w.ArrayEnd()
+	}
+	w.Key("model")
+	w.String(resp.Model)
+	w.Key("usage")
+	w.ObjectStart()
+	w.Key("prompt_tokens")
+	w.Int(int64(resp.Usage.PromptTokens))
+	w.Key("total_tokens")
+	w.Int(int64(resp.Usage.TotalTokens))
+	if resp.Usage.ChunkedInputs != 0 {
+		w.Key("chunked_inputs")
+		w.Int(int64(resp.Usage.ChunkedInputs))
+	}
+	if resp.Usage.Chunks != 0 {
+		w.Key("chunks")
+		w.Int(int64(resp.Usage.Chunks))
+	}
+	w.ObjectEnd()
+	if resp.Error != "" {
+		w.Key("error")
+		w.String(resp.Error)
+	}
+	w.ObjectEnd()
+	return w.Bytes(), w.Err()
+}
+
+func appendAudioResponse(buf []byte, resp *AudioResponse) ([]byte, error) {
+	w := fastjson.NewWriter(buf)
+	if resp == nil {
+		w.Null()
+		return w.Bytes(), nil
+	}
+
+	w.ObjectStart()
+	w.Key("req_id")
+	w.String(resp.ReqID)
+	w.Key("text")
+	w.String(resp.Text)
+	w.Key("language")
+	w.String(resp.Language)
+	if len(resp.Segments) > 0 {
+		w.Key("segments")
+		w.ArrayStart()
+		for _, segment := range resp.Segments {
+			w.ObjectStart()
+			w.Key("id")
+			w.Int(int64(segment.ID))
+			w.Key("start")
+			w.Float64(segment.Start)
+			w.Key("end")
+			w.Float64(segment.End)
+			w.Key("text")
+			w.String(segment.Text)
+			w.ObjectEnd()
+		}
+		w.ArrayEnd()
+	}
+	w.Key("duration_ms")
+	w.Int(resp.DurationMs)
+	if resp.Error != "" {
+		w.Key("error")
+		w.String(resp.Error)
+	}
+	w.ObjectEnd()
+	return w.Bytes(), w.Err()
+}
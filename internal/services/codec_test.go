@@ -0,0 +1,278 @@
+package services
+
+import (
+	"bytes"
+	"encoding/base64"
+	"encoding/json"
+	"math"
+	"reflect"
+	"testing"
+
+	"github.com/aigoflow/inference-service/internal/llama"
+	"github.com/aigoflow/inference-service/internal/types"
+)
+
+var codecStrings = []string{
+	"",
+	"quotes \" and \\ backslashes",
+	"newline\n tab\t control \x01 \x1f",
+	"<html> & entities",
+	"unicode: héllo 日本語 🎉",
+	"separators \u2028 \u2029",
+	"invalid utf-8 \xff\xfe end",
+}
+
+// checkEncoder compares an encoder's output with json.Marshal, including the error for
+// unsupported values
+func checkEncoder(t *testing.T, name string, v interface{}, got []byte, err error) {
+	t.Helper()
+	want, wantErr := json.Marshal(v)
+	if wantErr != nil || err != nil {
+		if wantErr == nil || err == nil || err.Error() != wantErr.Error() {
+			t.Errorf("%s: error %v, want %v", name, err, wantErr)
+		}
+		return
+	}
+	if !bytes.Equal(got, want) {
+		t.Errorf("%s:\ngot  %s\nwant %s", name, got, want)
+	}
+}
+
+func TestInferenceResponseMatchesEncodingJSON(t *testing.T) {
+	responses := map[string]*InferenceResponse{
+		"nil":   nil,
+		"empty": {},
+		"full": {
+			ReqID: "req-1", Text: "answer", TokensIn: 12, TokensOut: 30,
+			ReasoningTokens: 20, AnswerTokens: 10,
+			Choices: []llama.Sample{{Text: "a", TokensOut: 3, Logprob: -1.25}, {Text: "b", TokensOut: 1, Logprob: -3e-7}},
+			Logprobs: &llama.TokenLogprobs{
+				TopN: 2, Tokens: []int32{1, 2}, Text: []string{"a", "<b>"}, Logprobs: []float32{-0.5, -2},
+				TopTokens: []int32{1, 3, 2, 4}, TopLogprobs: []float32{-0.5, -1, -2, -4},
+			},
+			FinishReason: "stop", Cached: "exact", DurationMs: 1500, Error: "",
+		},
+		"empty choices":  {Choices: []llama.Sample{}, FinishReason: "length"},
+		"empty logprobs": {Logprobs: &llama.TokenLogprobs{}},
+		"error":          {ReqID: "req-2", Error: "context \"overflow\" <ctx>", DurationMs: -1},
+		"NaN logprob":    {Choices: []llama.Sample{{Logprob: math.NaN()}}},
+		"Inf logprob":    {Choices: []llama.Sample{{Logprob: math.Inf(-1)}}},
+		"NaN logprobs":   {Logprobs: &llama.TokenLogprobs{Logprobs: []float32{float32(math.NaN())}}},
+	}
+	for i, s := range codecStrings {
+		responses["string "+string(rune('a'+i))] = &InferenceResponse{ReqID: s, Text: s, FinishReason: s, Cached: s, Error: s,
+			Choices: []llama.Sample{{Text: s}}}
+	}
+
+	for name, resp := range responses {
+		got, err := appendInferenceResponse(nil, resp)
+		checkEncoder(t, name, resp, got, err)
+	}
+}
+
+func TestEmbeddingResponseMatchesEncodingJSON(t *testing.T) {
+	responses := map[string]*EmbeddingResponse{
+		"nil":        nil,
+		"empty":      {},
+		"empty data": {Object: "list", Data: []EmbeddingData{}},
+		"full": {
+			Object: "list",
+			Data: []EmbeddingData{
+				{Object: "embedding", Embedding: []float32{0.1, -0.25, 3e-7, 1e21, 0}, Index: 0},
+				{Object: "embedding", Embedding: []float32{}, Index: 1, Chunk: 2, Span: []int{4, 9}, TokenSpan: []int{0, 512}},
+				{Object: "embedding", Embedding: nil, Index: 2, Span: []int{}, TokenSpan: nil},
+			},
+			Model: "model<1>",
+			Usage: EmbeddingUsage{PromptTokens: 20, TotalTokens: 20, ChunkedInputs: 1, Chunks: 3},
+		},
+		"error": {Object: "list", Error: "bad \"input\"\n"},
+		"NaN":   {Data: []EmbeddingData{{Embedding: []float32{1, float32(math.NaN())}}}},
+		"Inf":   {Data: []EmbeddingData{{Embedding: []float32{float32(math.Inf(1))}}}},
+	}
+	for i, s := range codecStrings {
+		responses["string "+string(rune('a'+i))] = &EmbeddingResponse{Object: s, Model: s, Error: s,
+			Data: []EmbeddingData{{Object: s}}}
+	}
+
+	for name, resp := range responses {
+		got, err := appendEmbeddingResponse(nil, resp)
+		checkEncoder(t, name, resp, got, err)
+	}
+}
+
+func TestAudioResponseMatchesEncodingJSON(t *testing.T) {
+	responses := map[string]*AudioResponse{
+		"nil":            nil,
+		"empty":          {},
+		"empty segments": {Segments: []types.AudioSegment{}},
+		"full": {
+			ReqID: "req-1", Text: "hello world", Language: "en", DurationMs: 830,
+			Segments: []types.AudioSegment{{ID: 0, Start: 0, End: 1.5, Text: "hello"}, {ID: 1, Start: 1.5, End: 2.25e-7, Text: " world"}},
+		},
+		"error": {ReqID: "req-2", Error: "decode <wav> failed"},
+		"NaN":   {Segments: []types.AudioSegment{{Start: math.NaN()}}},
+		"Inf":   {Segments: []types.AudioSegment{{End: math.Inf(1)}}},
+	}
+	for i, s := range codecStrings {
+		responses["string "+string(rune('a'+i))] = &AudioResponse{ReqID: s, Text: s, Language: s, Error: s,
+			Segments: []types.AudioSegment{{Text: s}}}
+	}
+
+	for name, resp := range responses {
+		got, err := appendAudioResponse(nil, resp)
+		checkEncoder(t, name, resp, got, err)
+	}
+}
+
+func TestAppendKeepsBuffer(t *testing.T) {
+	resp := &AudioResponse{ReqID: "req-1"}
+	want, _ := json.Marshal(resp)
+	got, err := appendAudioResponse([]byte("prefix"), resp)
+	if err != nil || string(got) != "prefix"+string(want) {
+		t.Errorf("got %s, %v", got, err)
+	}
+}
+
+func TestDecodeInferenceRequest(t *testing.T) {
+	requests := []InferenceRequest{
+		{},
+		{ReqID: "req-1", Input: "hello", Params: map[string]interface{}{}},
+		{
+			TraceID: "trace", ReqID: "req-2", Input: "<prompt> & \"quotes\"\n",
+			Params:  map[string]interface{}{"max_tokens": 64.0, "stop": []interface{}{"\n", "</s>"}, "grammar": nil, "nested": map[string]interface{}{"a": true}},
+			ReplyTo: "reply.1", Raw: true, Stream: true, DeadlineMs: 5000,
+			Messages: []llama.ChatMessage{{Role: "system", Content: ""}, {Role: "user", Content: "日本語 🎉 \u2028"}},
+		},
+	}
+	for _, s := range codecStrings[:len(codecStrings)-1] {
+		requests = append(requests, InferenceRequest{ReqID: s, Input: s, Messages: []llama.ChatMessage{{Role: s, Content: s}}})
+	}
+
+	for _, want := range requests {
+		data, _ := json.Marshal(want)
+		var got InferenceRequest
+		if err := decodeInferenceRequest(data, &got); err != nil {
+			t.Errorf("%s: %v", data, err)
+		} else if !reflect.DeepEqual(got, want) {
+			t.Errorf("%s:\ngot  %#v\nwant %#v", data, got, want)
+		}
+	}
+
+	// Nulls, empty arrays, unknown keys, escapes, keys in other case and invalid UTF-8
+	// decode like json.Unmarshal
+	for _, data := range []string{
+		`{"req_id": null, "input": "a\u0041\/", "params": null, "messages": null, "raw": null}`,
+		`{"messages": [], "params": {}, "unknown": {"x": [1, 2]}}`,
+		`{"messages": [null, {"role": "user", "content": null, "name": "x"}], "deadline_ms": -1}`,
+		`{"Input": "a", "Req_ID": "b", "PARAMS": {"Max_Tokens": 1}, "Messages": [{"Role": "user", "CONTENT": "c"}], "Deadline_Ms": 5}`,
+		`{"input": "first", "Input": "second", "raw": true, "RAW": false}`,
+		"{\"input\": \"bad \xff\xfe utf-8\", \"req_id\": \"\xc3\", \"params\": {\"k\xff\": \"v\xff\"}}",
+	} {
+		var want, got InferenceRequest
+		if err := json.Unmarshal([]byte(data), &want); err != nil {
+			t.Fatal(err)
+		}
+		if err := decodeInferenceRequest([]byte(data), &got); err != nil {
+			t.Errorf("%s: %v", data, err)
+		} else if !reflect.DeepEqual(got, want) {
+			t.Errorf("%s:\ngot  %#v\nwant %#v", data, got, want)
+		}
+	}
+
+	for _, data := range []string{``, `[]`, `{"params": 1}`, `{"input": 1}`, `{"raw": "yes"}`, `{"req_id": "a"} x`} {
+		var req InferenceRequest
+		if err := decodeInferenceRequest([]byte(data), &req); err == nil {
+			t.Errorf("%q should not decode", data)
+		}
+	}
+}
+
+func TestDecodeEmbeddingRequest(t *testing.T) {
+	overlap := 32
+	zero := 0
+	requests := []EmbeddingRequest{
+		{},
+		{ReqID: "req-1", Input: "hello"},
+		{ReqID: "req-2", Input: []interface{}{"a", "<b>", ""}, Model: "m", Pooling: "cls", ReplyTo: "reply.1"},
+		{ReqID: "req-3", Input: "late chunking", Spans: [][2]int{{0, 4}, {5, 13}}, ChunkOverlap: &overlap, SplitChunks: true},
+		{ReqID: "req-4", ChunkOverlap: &zero},
+	}
+
+	for _, want := range requests {
+		data, _ := json.Marshal(want)
+		var got EmbeddingRequest
+		if err := decodeEmbeddingRequest(data, &got); err != nil {
+			t.Errorf("%s: %v", data, err)
+		} else if !reflect.DeepEqual(got, want) {
+			t.Errorf("%s:\ngot  %#v\nwant %#v", data, got, want)
+		}
+	}
+
+	for _, data := range []string{
+		`{"input": null, "spans": null, "chunk_overlap": null}`,
+		`{"input": [], "spans": [], "extra": "x"}`,
+		`{"input": 1.5}`,
+		`{"input": {"text": "a"}}`,
+		`{"Input": ["a", "b"], "SPANS": [[0, 1]], "Chunk_Overlap": 3, "Split_Chunks": true}`,
+		"{\"input\": [\"\xff\"], \"model\": \"m\xfe\"}",
+	} {
+		var want, got EmbeddingRequest
+		if err := json.Unmarshal([]byte(data), &want); err != nil {
+			t.Fatal(err)
+		}
+		if err := decodeEmbeddingRequest([]byte(data), &got); err != nil {
+			t.Errorf("%s: %v", data, err)
+		} else if !reflect.DeepEqual(got, want) {
+			t.Errorf("%s:\ngot  %#v\nwant %#v", data, got, want)
+		}
+	}
+
+	for _, data := range []string{`{"spans": [["a"]]}`, `{"spans": "x"}`, `{"chunk_overlap": "1"}`, `{"split_chunks": 1}`} {
+		var req EmbeddingRequest
+		if err := decodeEmbeddingRequest([]byte(data), &req); err == nil {
+			t.Errorf("%q should not decode", data)
+		}
+	}
+}
+
+func TestDecodeAudioRequest(t *testing.T) {
+	audio := []byte("RIFF\x00\x01\xff wav data")
+	requests := []AudioRequest{
+		{},
+		{ReqID: "req-1", AudioURL: "http://host/a.wav?x=1&y=<2>", Language: "en"},
+		{TraceID: "trace", ReqID: "req-2", Audio: audio, Model: "base", ReplyTo: "reply.1", StreamChunks: true},
+	}
+
+	for _, want := range requests {
+		data, _ := json.Marshal(want)
+		var got AudioRequest
+		if err := decodeAudioRequest(data, &got); err != nil {
+			t.Errorf("%s: %v", data, err)
+		} else if !reflect.DeepEqual(got, want) {
+			t.Errorf("%s:\ngot  %#v\nwant %#v", data, got, want)
+		}
+	}
+
+	// audio_base64 is decoded into Audio, or kept as text when it is not base64
+	encoded := base64.StdEncoding.EncodeToString(audio)
+	for data, want := range map[string]AudioRequest{
+		`{"audio_base64": "` + encoded + `"}`: {Audio: audio},
+		`{"audio_base64": "not base64!"}`:     {AudioBase64: "not base64!"},
+		`{"audio_base64": null, "audio": null}`: {},
+		`{"Audio_URL": "u", "LANGUAGE": "en", "Audio": "` + encoded + `"}`: {AudioURL: "u", Language: "en", Audio: audio},
+	} {
+		var got AudioRequest
+		if err := decodeAudioRequest([]byte(data), &got); err != nil {
+			t.Errorf("%s: %v", data, err)
+		} else if !reflect.DeepEqual(got, want) {
+			t.Errorf("%s:\ngot  %#v\nwant %#v", data, got, want)
+		}
+	}
+
+	for _, data := range []string{`{"audio": "not base64!"}`, `{"audio_base64": 1}`, `{"stream_chunks": "true"}`} {
+		var req AudioRequest
+		if err := decodeAudioRequest([]byte(data), &req); err == nil {
+			t.Errorf("%q should not decode", data)
+		}
+	}
+}
@@ -16,18 +16,29 @@ type EmbeddingRequest struct {
 	ReqID   string                 `json:"req_id"`
 	Input   interface{}            `json:"input"`    // Can be string or []string
 	Model   string                 `json:"model,omitempty"`
+	Pooling string                 `json:"pooling,omitempty"` // mean, cls, last or none, overrides POOLING_TYPE
+	Spans   [][2]int               `json:"spans,omitempty"`   // Late chunking: character spans of a single input
 	ReplyTo string                 `json:"reply_to,omitempty"`
+	
+	// Inputs longer than the context are embedded in overlapping windows
+	ChunkOverlap *int `json:"chunk_overlap,omitempty"` // Tokens shared by consecutive windows, EMBED_CHUNK_OVERLAP if unset
+	SplitChunks  bool `json:"split_chunks,omitempty"`  // Return every window instead of their weighted mean
 }
 
 type EmbeddingData struct {
 	Object    string    `json:"object"`
 	Embedding []float32 `json:"embedding"`
 	Index     int       `json:"index"`
+	Chunk     int       `json:"chunk,omitempty"`      // Position among the chunks of the input
+	Span      []int     `json:"span,omitempty"`       // Character span of a late chunk
+	TokenSpan []int     `json:"token_span,omitempty"` // Token span of a window of a split input
 }
 
 type EmbeddingUsage struct {
-	PromptTokens int `json:"prompt_tokens"`
-	TotalTokens  int `json:"total_tokens"`
+	PromptTokens  int `json:"prompt_tokens"`
+	TotalTokens   int `json:"total_tokens"`
+	ChunkedInputs int `json:"chunked_inputs,omitempty"` // Inputs longer than the context
+	Chunks        int `json:"chunks,omitempty"`         // Context windows encoded for those inputs
 }
 
 type EmbeddingResponse struct {
@@ -89,26 +100,53 @@ func (s *EmbeddingService) ProcessEmbedding(ctx context.Context, req EmbeddingRe
 		}, fmt.Errorf("empty input")
 	}
 	
-	// Process each input
+	// Spans refer to character positions of one document
+	if len(req.Spans) > 0 && len(inputs) > 1 {
+		return &EmbeddingResponse{
+			Error: "Spans require a single input",
+		}, fmt.Errorf("spans with %d inputs", len(inputs))
+	}
+	opts := llama.EmbeddingOptions{
+		Pooling:      req.Pooling,
+		Spans:        req.Spans,
+		ChunkOverlap: -1,
+		SplitChunks:  req.SplitChunks,
+	}
+	if req.ChunkOverlap != nil {
+		opts.ChunkOverlap = *req.ChunkOverlap
+	}
+	
+	// All inputs are tokenized first and packed by length into shared batches
+	results, err := s.llm.GenerateEmbeddingsBatch(inputs, opts)
+	if err != nil {
+		slog.Error("Embedding generation failed", "error", err, "inputs", len(inputs))
+		return &EmbeddingResponse{
+			Error: fmt.Sprintf("Embedding generation failed: %v", err),
+		}, err
+	}
+	
+	// Results come back in input order
 	var embeddingData []EmbeddingData
 	totalTokens := 0
+	chunkedInputs, chunks := 0, 0
 	
-	for i, input := range inputs {
-		embedding, tokensIn, err := s.llm.GenerateEmbedding(input)
-		if err != nil {
-			slog.Error("Embedding generation failed", "error", err, "input_index", i)
-			return &EmbeddingResponse{
-				Error: fmt.Sprintf("Embedding generation failed: %v", err),
-			}, err
+	for i, result := range results {
+		totalTokens += result.TokensIn
+		if result.Windows > 1 {
+			chunkedInputs++
+			chunks += result.Windows
 		}
 		
-		totalTokens += tokensIn
-		
-		embeddingData = append(embeddingData, EmbeddingData{
-			Object:    "embedding",
-			Embedding: embedding,
-			Index:     i,
-		})
+		for j, chunk := range result.Chunks {
+			embeddingData = append(embeddingData, EmbeddingData{
+				Object:    "embedding",
+				Embedding: chunk.Embedding,
+				Index:     i,
+				Chunk:     j,
+				Span:      chunk.Span,
+				TokenSpan: chunk.TokenSpan,
+			})
+		}
 	}
 	
 	duration := time.Since(start)
@@ -118,8 +156,10 @@ func (s *EmbeddingService) ProcessEmbedding(ctx context.Context, req EmbeddingRe
 		Data:   embeddingData,
 		Model:  req.Model,
 		Usage: EmbeddingUsage{
-			PromptTokens: totalTokens,
-			TotalTokens:  totalTokens,
+			PromptTokens:  totalTokens,
+			TotalTokens:   totalTokens,
+			ChunkedInputs: chunkedInputs,
+			Chunks:        chunks,
 		},
 	}
 	
@@ -21,6 +21,7 @@ type HealthService struct {
 	capabilities       []capabilities.Capability
 	monitoring         *MonitoringService  // Add reference to monitoring service
 	startTime          time.Time           // Track when service started
+	cache              *CompletionCache
 }
 
 type HealthStatus struct {
@@ -36,6 +37,7 @@ type HealthStatus struct {
 	BackpressureStatus BackpressureStatus         `json:"backpressure_status"`
 	StartTime          time.Time                  `json:"start_time"`
 	Uptime             time.Duration              `json:"uptime"`
+	CacheMetrics       *CacheStats                `json:"cache_metrics,omitempty"`
 }
 
 type QueueMetrics struct {
@@ -43,6 +45,7 @@ type QueueMetrics struct {
 	ActiveProcessing  int64     `json:"active_processing"`
 	TotalProcessed    int64     `json:"total_processed"`
 	QueueCapacity     int64     `json:"queue_capacity"`
+	FreeSlots         int       `json:"free_slots"` // Messages the worker would fetch right now
 	LastProcessedTime time.Time `json:"last_processed_time"`
 }
 
@@ -163,6 +166,12 @@ func (h *HealthService) getHealthStatus() HealthStatus {
 	// Get queue metrics from monitoring service
 	queueMetrics, backpressureStatus := h.getQueueMetrics()
 	
+	var cacheMetrics *CacheStats
+	if h.cache != nil {
+		stats := h.cache.Stats()
+		cacheMetrics = &stats
+	}
+	
 	now := time.Now()
 	return HealthStatus{
 		ModelName:          h.config.ModelName,
@@ -177,9 +186,15 @@ func (h *HealthService) getHealthStatus() HealthStatus {
 		BackpressureStatus: backpressureStatus,
 		StartTime:          h.startTime,
 		Uptime:             now.Sub(h.startTime),
+		CacheMetrics:       cacheMetrics,
 	}
 }
 
+// SetCompletionCache includes completion cache hit rates in health reports
+func (h *HealthService) SetCompletionCache(cache *CompletionCache) {
+	h.cache = cache
+}
+
 // getQueueMetrics retrieves current queue and backpressure metrics
 func (h *HealthService) getQueueMetrics() (QueueMetrics, BackpressureStatus) {
 	var queueMetrics QueueMetrics
@@ -196,6 +211,7 @@ func (h *HealthService) getQueueMetrics() (QueueMetrics, BackpressureStatus) {
 			ActiveProcessing:  active,
 			TotalProcessed:    total,
 			QueueCapacity:     int64(h.config.MaxMsgs), // From NATS config
+			FreeSlots:         h.monitoring.FreeSlots(),
 			LastProcessedTime: h.monitoring.GetLastProcessedTime(),
 		}
 		
@@ -0,0 +1,295 @@
+package services
+
+import (
+	"context"
+	"fmt"
+	"log/slog"
+	"time"
+
+	"github.com/aigoflow/inference-service/internal/llama"
+	"github.com/aigoflow/inference-service/internal/models"
+	"github.com/aigoflow/inference-service/internal/repository"
+	"github.com/aigoflow/inference-service/internal/vectorindex"
+)
+
+// defaultTopK is the number of hits returned when a search does not ask for more
+const defaultTopK = 10
+
+// indexApplyTimeout bounds how long an upsert waits for its update to come back from
+// the upsert log
+const indexApplyTimeout = 30 * time.Second
+
+type IndexUpsertRequest struct {
+	TraceID    string                 `json:"trace_id,omitempty"`
+	ReqID      string                 `json:"req_id"`
+	Collection string                 `json:"collection"`
+	Documents  []vectorindex.Document `json:"documents"` // Text is embedded, documents with an existing ID are replaced
+	ReplyTo    string                 `json:"reply_to,omitempty"`
+}
+
+type IndexSearchRequest struct {
+	TraceID    string `json:"trace_id,omitempty"`
+	ReqID      string `json:"req_id"`
+	Collection string `json:"collection"`
+	Query      string `json:"query"`
+	TopK       int    `json:"top_k,omitempty"`
+	Ef         int    `json:"ef,omitempty"` // Search candidate list size, larger trades speed for recall
+	ReplyTo    string `json:"reply_to,omitempty"`
+}
+
+// IndexUpdate is an embedded upsert as it is appended to the upsert log. Documents
+// are embedded once, by the worker that received the upsert, and every replica applies
+// the vectors in log order.
+type IndexUpdate struct {
+	Collection string                 `json:"collection"`
+	Documents  []vectorindex.Document `json:"documents"`
+	Vectors    [][]float32            `json:"vectors"`
+}
+
+// IndexPublisher appends updates to the upsert log and returns their log sequence
+type IndexPublisher interface {
+	PublishIndexUpdate(update *IndexUpdate) (uint64, error)
+}
+
+type IndexResponse struct {
+	ReqID      string            `json:"req_id"`
+	Collection string            `json:"collection"`
+	Upserted   int               `json:"upserted,omitempty"`
+	Count      int               `json:"count"` // Documents in the collection
+	Hits       []vectorindex.Hit `json:"hits,omitempty"`
+	Usage      EmbeddingUsage    `json:"usage"`
+	DurationMs int64             `json:"duration_ms"`
+	Error      string            `json:"error,omitempty"`
+}
+
+// IndexService embeds documents and queries and serves them from the local vector index.
+// With a publisher, upserts go through the upsert log and the local replica is only
+// written by Apply; without one the local replica is written directly.
+type IndexService struct {
+	llm       *llama.Model
+	store     *vectorindex.Store
+	repo      repository.Repository
+	publisher IndexPublisher
+}
+
+func NewIndexService(llm *llama.Model, store *vectorindex.Store, repo repository.Repository) *IndexService {
+	return &IndexService{
+		llm:   llm,
+		store: store,
+		repo:  repo,
+	}
+}
+
+// SetPublisher routes upserts through the upsert log
+func (s *IndexService) SetPublisher(publisher IndexPublisher) {
+	s.publisher = publisher
+}
+
+// Applied returns the log sequence the local replica has applied up to
+func (s *IndexService) Applied() uint64 {
+	return s.store.Applied()
+}
+
+// Apply writes an update from the upsert log with sequence seq to the local replica.
+// A nil update only advances the sequence past an entry that could not be read.
+func (s *IndexService) Apply(update *IndexUpdate, seq uint64) error {
+	// A failed update still advances the sequence, it must not stall the log
+	defer s.store.SetApplied(seq)
+	if update == nil {
+		return nil
+	}
+	return s.write(update)
+}
+
+// write adds an update to the local replica, creating the collection if needed
+func (s *IndexService) write(update *IndexUpdate) error {
+	collection, err := s.store.Collection(update.Collection, s.llm.GetEmbeddingSize(), true)
+	if err != nil {
+		return err
+	}
+	return collection.Upsert(update.Documents, update.Vectors)
+}
+
+// Flush writes the collections changed since the last flush
+func (s *IndexService) Flush() error {
+	return s.store.Flush()
+}
+
+// FlushEvery flushes the local replica every interval until ctx is done
+func (s *IndexService) FlushEvery(ctx context.Context, interval time.Duration) {
+	if interval <= 0 {
+		interval = time.Second
+	}
+	ticker := time.NewTicker(interval)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-ctx.Done():
+			return
+		case <-ticker.C:
+			if err := s.store.Flush(); err != nil {
+				slog.Error("Failed to flush vector index", "dir", s.store.Dir(), "error", err)
+			}
+		}
+	}
+}
+
+// embed returns one vector per text, over-long texts are averaged over their windows
+func (s *IndexService) embed(texts []string) ([][]float32, int, error) {
+	results, err := s.llm.GenerateEmbeddingsBatch(texts, llama.EmbeddingOptions{ChunkOverlap: -1})
+	if err != nil {
+		return nil, 0, err
+	}
+
+	vectors := make([][]float32, len(results))
+	tokens := 0
+	for i, result := range results {
+		vectors[i] = result.Chunks[0].Embedding
+		tokens += result.TokensIn
+	}
+	return vectors, tokens, nil
+}
+
+// ProcessUpsert embeds the documents and adds them to the collection, creating it if needed
+func (s *IndexService) ProcessUpsert(ctx context.Context, req IndexUpsertRequest, source string, replyTo string, workerID string) (*IndexResponse, error) {
+	start := time.Now()
+	response := &IndexResponse{ReqID: req.ReqID, Collection: req.Collection}
+
+	tokens, err := s.upsert(ctx, req, response)
+	response.DurationMs = time.Since(start).Milliseconds()
+	response.Usage = EmbeddingUsage{PromptTokens: tokens, TotalTokens: tokens}
+	if err != nil {
+		response.Error = err.Error()
+	}
+
+	s.logRequest(ctx, start, req.TraceID, req.ReqID, source, replyTo, workerID, fmt.Sprintf("%d documents", len(req.Documents)), response, tokens)
+	return response, err
+}
+
+func (s *IndexService) upsert(ctx context.Context, req IndexUpsertRequest, response *IndexResponse) (int, error) {
+	if len(req.Documents) == 0 {
+		return 0, fmt.Errorf("no documents provided")
+	}
+
+	texts := make([]string, len(req.Documents))
+	for i, doc := range req.Documents {
+		if doc.Text == "" {
+			return 0, fmt.Errorf("document %d has no text", i)
+		}
+		if doc.ID == "" {
+			return 0, fmt.Errorf("document %d has no id", i)
+		}
+		texts[i] = doc.Text
+	}
+
+	// Reject bad collection names before embedding
+	if err := vectorindex.ValidateName(req.Collection); err != nil {
+		return 0, err
+	}
+
+	vectors, tokens, err := s.embed(texts)
+	if err != nil {
+		return tokens, fmt.Errorf("embedding failed: %w", err)
+	}
+	update := &IndexUpdate{Collection: req.Collection, Documents: req.Documents, Vectors: vectors}
+
+	if s.publisher == nil {
+		if err := s.write(update); err != nil {
+			return tokens, fmt.Errorf("upsert failed: %w", err)
+		}
+	} else {
+		// Every replica applies the update from the log, wait for the local one so a
+		// search right after the upsert finds the documents
+		seq, err := s.publisher.PublishIndexUpdate(update)
+		if err != nil {
+			return tokens, fmt.Errorf("upsert failed: %w", err)
+		}
+		waitCtx, cancel := context.WithTimeout(ctx, indexApplyTimeout)
+		defer cancel()
+		if err := s.store.WaitApplied(waitCtx, seq); err != nil {
+			return tokens, fmt.Errorf("upsert not applied: %w", err)
+		}
+	}
+
+	collection, err := s.store.Collection(req.Collection, s.llm.GetEmbeddingSize(), false)
+	if err != nil {
+		return tokens, err
+	}
+	response.Upserted = len(req.Documents)
+	response.Count = collection.Len()
+	return tokens, nil
+}
+
+// ProcessSearch embeds the query and returns the most similar documents of the collection
+func (s *IndexService) ProcessSearch(ctx context.Context, req IndexSearchRequest, source string, replyTo string, workerID string) (*IndexResponse, error) {
+	start := time.Now()
+	response := &IndexResponse{ReqID: req.ReqID, Collection: req.Collection}
+
+	tokens, err := s.search(req, response)
+	response.DurationMs = time.Since(start).Milliseconds()
+	response.Usage = EmbeddingUsage{PromptTokens: tokens, TotalTokens: tokens}
+	if err != nil {
+		response.Error = err.Error()
+	}
+
+	s.logRequest(ctx, start, req.TraceID, req.ReqID, source, replyTo, workerID, req.Query, response, tokens)
+	return response, err
+}
+
+func (s *IndexService) search(req IndexSearchRequest, response *IndexResponse) (int, error) {
+	if req.Query == "" {
+		return 0, fmt.Errorf("query required")
+	}
+	topK := req.TopK
+	if topK <= 0 {
+		topK = defaultTopK
+	}
+
+	collection, err := s.store.Collection(req.Collection, s.llm.GetEmbeddingSize(), false)
+	if err != nil {
+		return 0, err
+	}
+
+	vectors, tokens, err := s.embed([]string{req.Query})
+	if err != nil {
+		return tokens, fmt.Errorf("embedding failed: %w", err)
+	}
+	hits, err := collection.Search(vectors[0], topK, req.Ef)
+	if err != nil {
+		return tokens, fmt.Errorf("search failed: %w", err)
+	}
+
+	response.Hits = hits
+	response.Count = collection.Len()
+	return tokens, nil
+}
+
+func (s *IndexService) logRequest(ctx context.Context, start time.Time, traceID, reqID, source, replyTo, workerID, input string, response *IndexResponse, tokens int) {
+	if traceID == "" {
+		traceID = reqID
+	}
+	status := "ok"
+	if response.Error != "" {
+		status = "error"
+	}
+
+	s.repo.Request().LogRequest(ctx, &models.RequestLog{
+		Timestamp:      start,
+		TraceID:        traceID,
+		ReqID:          reqID,
+		WorkerID:       workerID,
+		Source:         source,
+		ReplyTo:        replyTo,
+		RawInput:       input,
+		FormattedInput: input,
+		ResponseText:   toJSON(response.Hits),
+		InputLen:       len(input),
+		ParamsJSON:     toJSON(map[string]interface{}{"collection": response.Collection}),
+		GrammarUsed:    "none",
+		TokensIn:       tokens,
+		DurationMs:     response.DurationMs,
+		Status:         status,
+		Error:          response.Error,
+		EmbeddingSize:  s.llm.GetEmbeddingSize(),
+	})
+}
@@ -13,28 +13,43 @@ import (
 )
 
 type InferenceRequest struct {
-	TraceID string                 `json:"trace_id,omitempty"`
-	ReqID   string                 `json:"req_id"`
-	Input   string                 `json:"input"`
-	Params  map[string]interface{} `json:"params"`
-	ReplyTo string                 `json:"reply_to,omitempty"`
-	Raw     bool                   `json:"raw,omitempty"`     // Bypass all formatting
+	TraceID    string                 `json:"trace_id,omitempty"`
+	ReqID      string                 `json:"req_id"`
+	Input      string                 `json:"input"`
+	Params     map[string]interface{} `json:"params"`
+	ReplyTo    string                 `json:"reply_to,omitempty"`
+	Raw        bool                   `json:"raw,omitempty"`         // Bypass all formatting
+	Messages   []llama.ChatMessage    `json:"messages,omitempty"`    // Multi-turn chat, rendered with the model's chat template
+	Stream     bool                   `json:"stream,omitempty"`      // Deliver response text while it is generated
+	DeadlineMs int64                  `json:"deadline_ms,omitempty"` // Answer within this many ms of publishing, REQUEST_DEADLINE if unset
+}
+
+// InferenceChunk carries response text streamed ahead of the final response
+type InferenceChunk struct {
+	ReqID string `json:"req_id"`
+	Text  string `json:"text"`
 }
 
 type InferenceResponse struct {
-	ReqID        string `json:"req_id"`
-	Text         string `json:"text"`
-	TokensIn     int    `json:"tokens_in"`
-	TokensOut    int    `json:"tokens_out"`
-	FinishReason string `json:"finish_reason"`
-	DurationMs   int64  `json:"duration_ms"`
-	Error        string `json:"error,omitempty"`
+	ReqID           string               `json:"req_id"`
+	Text            string               `json:"text"`
+	TokensIn        int                  `json:"tokens_in"`
+	TokensOut       int                  `json:"tokens_out"`
+	ReasoningTokens int                  `json:"reasoning_tokens,omitempty"` // Part of tokens_out spent on reasoning
+	AnswerTokens    int                  `json:"answer_tokens,omitempty"`    // Part of tokens_out spent on the answer
+	Choices         []llama.Sample       `json:"choices,omitempty"`          // All completions when params.n > 1
+	Logprobs        *llama.TokenLogprobs `json:"logprobs,omitempty"`         // Per-token log-probabilities when requested
+	FinishReason    string               `json:"finish_reason"`
+	Cached          string               `json:"cached,omitempty"` // Cache tier that served the response: exact, shared or semantic
+	DurationMs      int64                `json:"duration_ms"`
+	Error           string               `json:"error,omitempty"`
 }
 
 type InferenceService struct {
 	llm            *llama.Model
 	repo           repository.Repository
 	grammarService *GrammarService
+	cache          *CompletionCache
 }
 
 func NewInferenceService(llm *llama.Model, repo repository.Repository, grammarService *GrammarService) *InferenceService {
@@ -46,6 +61,12 @@ func NewInferenceService(llm *llama.Model, repo repository.Repository, grammarSe
 }
 
 func (s *InferenceService) ProcessInference(ctx context.Context, req InferenceRequest, source string, replyTo string, workerID string) (response *InferenceResponse, err error) {
+	return s.ProcessInferenceStream(ctx, req, source, replyTo, workerID, nil)
+}
+
+// ProcessInferenceStream processes a request and passes response text to onText as it
+// is generated. Raw requests are not streamed.
+func (s *InferenceService) ProcessInferenceStream(ctx context.Context, req InferenceRequest, source string, replyTo string, workerID string, onText llama.TextCallback) (response *InferenceResponse, err error) {
 	start := time.Now()
 	
 	// Add service-level crash recovery
@@ -120,27 +141,62 @@ func (s *InferenceService) ProcessInference(ctx context.Context, req InferenceRe
 		}
 	}
 
+	// Chat requests log their conversation as raw input
+	rawInput := req.Input
+	if len(req.Messages) > 0 {
+		rawInput = toJSON(req.Messages)
+	}
+	
+	// Serve repeated prompts from the completion cache before touching the model.
+	// Identical requests in flight share one generation.
+	if s.cache != nil {
+		if formatted, formatErr := s.llm.FormatPrompt(req.Input, req.Messages, req.Raw); formatErr == nil {
+			cached, tier, lookup := s.cache.Lookup(ctx, req, formatted, resolvedGrammar)
+			if cached != nil {
+				return s.cachedResponse(ctx, req, cached, tier, formatted, rawInput, source, replyTo, workerID, start, onText), nil
+			}
+			// Runs before the panic handler, so waiters are released on every path
+			defer func() {
+				s.cache.Finish(lookup, response)
+			}()
+		}
+	}
+	
 	// Generate inference - use raw mode if requested
 	var text string
 	var tokensIn, tokensOut int
 	var formattedInput string
 	
-	if req.Raw {
+	var gen llama.Generation
+	
+	if len(req.Messages) > 0 {
+		// Chat mode: render the conversation with the model's chat template
+		gen, err = s.llm.GenerateChatStream(ctx, req.Messages, req.Params, onText)
+		text, tokensIn, tokensOut, formattedInput = gen.Text, gen.TokensIn, gen.TokensOut, gen.FormattedInput
+	} else if req.Raw {
 		// Raw mode: pass input directly to model without any formatting
 		slog.Debug("Using raw mode - bypassing all formatting", "req_id", req.ReqID)
-		text, tokensIn, tokensOut, formattedInput, err = s.llm.GenerateRaw(req.Input, req.Params)
+		text, tokensIn, tokensOut, formattedInput, err = s.llm.GenerateRaw(ctx, req.Input, req.Params)
 	} else {
 		// Normal mode: use formatting system
-		text, tokensIn, tokensOut, formattedInput, err = s.llm.GenerateWithFormatting(req.Input, req.Params)
+		gen, err = s.llm.GenerateWithFormattingStream(ctx, req.Input, req.Params, onText)
+		text, tokensIn, tokensOut, formattedInput = gen.Text, gen.TokensIn, gen.TokensOut, gen.FormattedInput
 	}
 	
 	duration := time.Since(start)
 	status := "ok"
+	finishReason := "stop"
 	errStr := ""
 	if err != nil {
 		status = "error"
 		errStr = err.Error()
 		text = "" // Clear text on error
+		
+		// Client went away or the request was cancelled, decoding stopped early
+		if ctx.Err() != nil {
+			status = "cancelled"
+			finishReason = "cancelled"
+		}
 	}
 	
 	// Store request log using proper repository interface
@@ -151,10 +207,10 @@ func (s *InferenceService) ProcessInference(ctx context.Context, req InferenceRe
 		WorkerID:       workerID,
 		Source:         source,
 		ReplyTo:        replyTo,
-		RawInput:       req.Input,
+		RawInput:       rawInput,
 		FormattedInput: formattedInput,
 		ResponseText:   text,
-		InputLen:       len(req.Input),
+		InputLen:       len(rawInput),
 		ParamsJSON:     toJSON(req.Params),
 		GrammarUsed:    grammarRef,
 		TokensIn:       tokensIn,
@@ -175,10 +231,23 @@ func (s *InferenceService) ProcessInference(ctx context.Context, req InferenceRe
 		Text:         text,
 		TokensIn:     tokensIn,
 		TokensOut:    tokensOut,
-		FinishReason: "stop",
+		FinishReason: finishReason,
 		DurationMs:   duration.Milliseconds(),
 	}
 	
+	if len(gen.Samples) > 1 && err == nil {
+		response.Choices = gen.Samples
+	}
+	if gen.Logprobs != nil && err == nil {
+		response.Logprobs = gen.Logprobs
+	}
+	
+	// Report reasoning and answer tokens separately for thinking models
+	if gen.ReasoningTokens > 0 && err == nil {
+		response.ReasoningTokens = gen.ReasoningTokens
+		response.AnswerTokens = tokensOut - gen.ReasoningTokens
+	}
+	
 	if err != nil {
 		response.Error = errStr
 	}
@@ -186,6 +255,76 @@ func (s *InferenceService) ProcessInference(ctx context.Context, req InferenceRe
 	return response, err
 }
 
+// cachedResponse returns a cached completion as the response to req and logs it
+func (s *InferenceService) cachedResponse(ctx context.Context, req InferenceRequest, cached *InferenceResponse, tier, formattedInput, rawInput, source, replyTo, workerID string, start time.Time, onText llama.TextCallback) *InferenceResponse {
+	if onText != nil && !req.Raw {
+		onText(cached.Text)
+	}
+	
+	traceID := req.TraceID
+	if traceID == "" {
+		traceID = req.ReqID
+	}
+	
+	duration := time.Since(start)
+	s.repo.Request().LogRequest(ctx, &models.RequestLog{
+		Timestamp:      start,
+		TraceID:        traceID,
+		ReqID:          req.ReqID,
+		WorkerID:       workerID,
+		Source:         source,
+		ReplyTo:        replyTo,
+		RawInput:       rawInput,
+		FormattedInput: formattedInput,
+		ResponseText:   cached.Text,
+		InputLen:       len(rawInput),
+		ParamsJSON:     toJSON(req.Params),
+		GrammarUsed:    "none",
+		TokensIn:       cached.TokensIn,
+		DurationMs:     duration.Milliseconds(),
+		Status:         "cached",
+	})
+	
+	slog.Debug("Completion served from cache", "req_id", req.ReqID, "tier", tier)
+	
+	cached.ReqID = req.ReqID
+	cached.Cached = tier
+	cached.DurationMs = duration.Milliseconds()
+	return cached
+}
+
+// SetCompletionCache enables serving repeated prompts from cache
+func (s *InferenceService) SetCompletionCache(cache *CompletionCache) {
+	s.cache = cache
+}
+
+// CacheStats returns completion cache counters, nil when the cache is disabled
+func (s *InferenceService) CacheStats() *CacheStats {
+	if s.cache == nil {
+		return nil
+	}
+	stats := s.cache.Stats()
+	return &stats
+}
+
+// EstimateTokens returns the prompt tokens of a request and the most tokens it may generate
+func (s *InferenceService) EstimateTokens(req InferenceRequest) (promptTokens, maxOutput int) {
+	prompt, err := s.llm.FormatPrompt(req.Input, req.Messages, req.Raw)
+	if err == nil {
+		promptTokens, err = s.llm.CountTokens(prompt)
+	}
+	if err != nil {
+		promptTokens = len(prompt) / 4 // Rough bytes per token
+	}
+
+	// Samples share the prompt but each reserves its own output cells
+	maxOutput = s.llm.KVTokens(promptTokens, req.Params) - promptTokens
+	if maxOutput < 0 {
+		maxOutput = 0
+	}
+	return promptTokens, maxOutput
+}
+
 func toJSON(v interface{}) string {
 	if v == nil {
 		return "{}"
@@ -19,16 +19,19 @@ type MonitoringService struct {
 	activeCount       int64     // atomic counter for active processing
 	totalProcessed    int64     // atomic counter for total processed
 	lastProcessedTime time.Time // last message processed time
+	admission         *AdmissionController
 }
 
 type BackpressureReport struct {
-	ModelName        string    `json:"model_name"`
-	PendingMessages  int64     `json:"pending_messages"`
-	ActiveProcessing int64     `json:"active_processing"`
-	Timestamp        time.Time `json:"timestamp"`
-	WorkerCount      int       `json:"worker_count"`
-	QueueCapacity    int       `json:"queue_capacity"`
-	Status           string    `json:"status"` // healthy, warning, critical
+	ModelName        string          `json:"model_name"`
+	PendingMessages  int64           `json:"pending_messages"`
+	ActiveProcessing int64           `json:"active_processing"`
+	Timestamp        time.Time       `json:"timestamp"`
+	WorkerCount      int             `json:"worker_count"`
+	FreeSlots        int             `json:"free_slots"` // Messages the worker would fetch right now
+	QueueCapacity    int             `json:"queue_capacity"`
+	Status           string          `json:"status"` // healthy, warning, critical
+	Admission        *AdmissionStats `json:"admission,omitempty"`
 }
 
 func NewMonitoringService(natsConn *nats.Conn, cfg *config.Config) *MonitoringService {
@@ -38,6 +41,11 @@ func NewMonitoringService(natsConn *nats.Conn, cfg *config.Config) *MonitoringSe
 	}
 }
 
+// SetAdmissionController adds admission state to backpressure reports
+func (m *MonitoringService) SetAdmissionController(admission *AdmissionController) {
+	m.admission = admission
+}
+
 func (m *MonitoringService) Start(ctx context.Context) error {
 	slog.Info("Starting monitoring service", 
 		"topic", m.config.MonitoringTopic,
@@ -90,9 +98,14 @@ func (m *MonitoringService) reportBackpressure(pending, active int64) {
 		ActiveProcessing: active,
 		Timestamp:        time.Now(),
 		WorkerCount:      m.config.Concurrency,
+		FreeSlots:        m.FreeSlots(),
 		QueueCapacity:    int(m.config.MaxMsgs),
 		Status:           status,
 	}
+	if m.admission != nil {
+		stats := m.admission.Stats()
+		report.Admission = &stats
+	}
 	
 	reportData, err := json.Marshal(report)
 	if err != nil {
@@ -119,6 +132,11 @@ func (m *MonitoringService) calculateStatus(pending, active int64) string {
 	total := pending + active
 	threshold := int64(m.config.BackpressureThreshold)
 	
+	// Running requests hold the whole token budget, new ones are being held back
+	if m.admission != nil && m.admission.Overloaded() {
+		return "critical"
+	}
+	
 	if total == 0 {
 		return "healthy"
 	} else if total < threshold {
@@ -128,6 +146,19 @@ func (m *MonitoringService) calculateStatus(pending, active int64) string {
 	}
 }
 
+// FreeSlots returns how many more messages the worker can process at once, 0 while
+// admission control holds new requests back
+func (m *MonitoringService) FreeSlots() int {
+	if m.admission != nil && m.admission.Overloaded() {
+		return 0
+	}
+	free := m.config.Concurrency - int(atomic.LoadInt64(&m.pendingCount))
+	if free < 0 {
+		free = 0
+	}
+	return free
+}
+
 // IncrementPending atomically increments pending message count
 func (m *MonitoringService) IncrementPending() {
 	atomic.AddInt64(&m.pendingCount, 1)
@@ -5,16 +5,32 @@ import (
 	"crypto/rand"
 	"encoding/hex"
 	"encoding/json"
+	"errors"
 	"fmt"
 	"log/slog"
 	"strings"
 	"time"
 
 	"github.com/nats-io/nats.go"
+	"github.com/nats-io/nats.go/jetstream"
 	"github.com/aigoflow/inference-service/internal/config"
+	"github.com/aigoflow/inference-service/internal/fastjson"
+	"github.com/aigoflow/inference-service/internal/llama"
 	"github.com/aigoflow/inference-service/internal/repository"
 )
 
+// maxInProgressInterval bounds the time between ack deadline extensions
+const maxInProgressInterval = 10 * time.Second
+
+// fetchBackoff is how long a worker without KV room waits before it takes messages again
+const fetchBackoff = 250 * time.Millisecond
+
+// fetchWait is how long the server holds a fetch open on an empty queue
+const fetchWait = 30 * time.Second
+
+// fetchErrorBackoff is how long a worker waits before fetching again after a failed fetch
+const fetchErrorBackoff = time.Second
+
 // generateWorkerID creates a unique worker ID using timestamp and random bytes
 func generateWorkerID() string {
 	// Use timestamp + random bytes for uniqueness
@@ -32,12 +48,17 @@ type ServiceInterface interface {
 type NATSService struct {
 	conn             *nats.Conn
 	js               nats.JetStreamContext
+	stream           jetstream.JetStream // Consumer API the dispatcher fetches from
 	service          ServiceInterface
 	inferenceService *InferenceService
 	embeddingService *EmbeddingService
 	audioService     *AudioService
+	indexService     *IndexService
 	cfg              *config.Config
 	monitoring       *MonitoringService
+	results          nats.KeyValue // Recent responses by req_id, replayed to redelivered messages
+	cancels          *cancelRegistry
+	admission        *AdmissionController // nil when admission control is off
 }
 
 func NewNATSService(cfg *config.Config, service ServiceInterface) (*NATSService, error) {
@@ -54,17 +75,33 @@ func NewNATSService(cfg *config.Config, service ServiceInterface) (*NATSService,
 		return nil, fmt.Errorf("failed to create JetStream context: %w", err)
 	}
 
+	stream, err := jetstream.New(conn)
+	if err != nil {
+		conn.Close()
+		return nil, fmt.Errorf("failed to create JetStream consumer API: %w", err)
+	}
+
 	natsService := &NATSService{
 		conn:       conn,
 		js:         js,
+		stream:     stream,
 		service:    service,
 		cfg:        cfg,
 		monitoring: NewMonitoringService(conn, cfg),
+		cancels:    newCancelRegistry(cfg.MaxAge),
 	}
 
 	// Set specific service types for backward compatibility
 	if inferenceService, ok := service.(*InferenceService); ok {
 		natsService.inferenceService = inferenceService
+		if cfg.AdmissionControl {
+			budget := cfg.AdmissionTokens
+			if budget <= 0 {
+				budget = cfg.Concurrency * cfg.CtxSize
+			}
+			natsService.admission = NewAdmissionController(budget, cfg.CtxSize)
+			natsService.monitoring.SetAdmissionController(natsService.admission)
+		}
 	} else if audioService, ok := service.(*AudioService); ok {
 		natsService.audioService = audioService
 	}
@@ -78,8 +115,11 @@ func (s *NATSService) Start(ctx context.Context) error {
 		return fmt.Errorf("failed to ensure stream: %w", err)
 	}
 
+	// Results are an optimization, run without them if the bucket is unavailable
+	s.ensureResultStore()
+
 	// Create pull consumer
-	consumer, err := s.createConsumer()
+	consumer, err := s.createConsumer(ctx)
 	if err != nil {
 		return fmt.Errorf("failed to create consumer: %w", err)
 	}
@@ -90,14 +130,24 @@ func (s *NATSService) Start(ctx context.Context) error {
 		"consumer", s.cfg.Durable,
 		"concurrency", s.cfg.Concurrency)
 
+	// Scoring is a single forward pass, served request/reply from a queue group
+	if err := s.subscribeScore(ctx); err != nil {
+		return fmt.Errorf("failed to subscribe score subject: %w", err)
+	}
+
+	if err := s.subscribeIndex(ctx); err != nil {
+		return fmt.Errorf("failed to subscribe index subjects: %w", err)
+	}
+
+	if err := s.subscribeCancel(); err != nil {
+		return fmt.Errorf("failed to subscribe cancel subject: %w", err)
+	}
+
 	// Start monitoring service
 	go s.monitoring.Start(ctx)
 	
-	// Start workers with unique IDs
-	for i := 0; i < s.cfg.Concurrency; i++ {
-		workerID := generateWorkerID()
-		go s.worker(ctx, consumer, workerID)
-	}
+	// One dispatcher feeds all processing slots
+	go s.dispatch(ctx, consumer)
 
 	// Block until context is cancelled
 	<-ctx.Done()
@@ -155,58 +205,163 @@ func (s *NATSService) ensureStream() error {
 	return nil
 }
 
-func (s *NATSService) createConsumer() (*nats.Subscription, error) {
-	// Create pull consumer
-	sub, err := s.js.PullSubscribe(s.cfg.Subject, s.cfg.Durable, nats.ManualAck())
+// ensureResultStore opens the key-value bucket of recent responses, creating it if needed
+func (s *NATSService) ensureResultStore() {
+	if s.cfg.ResultBucket == "" {
+		return
+	}
+
+	kv, err := s.js.KeyValue(s.cfg.ResultBucket)
+	if err == nats.ErrBucketNotFound {
+		kv, err = s.js.CreateKeyValue(&nats.KeyValueConfig{
+			Bucket:      s.cfg.ResultBucket,
+			Description: "Recent responses by req_id",
+			TTL:         s.cfg.ResultTTL,
+			Storage:     nats.FileStorage,
+		})
+	}
+	if err != nil {
+		slog.Warn("Result store unavailable, redelivered requests will be recomputed", "bucket", s.cfg.ResultBucket, "error", err)
+		return
+	}
+
+	s.results = kv
+	slog.Info("Result store ready", "bucket", s.cfg.ResultBucket, "ttl", s.cfg.ResultTTL)
+}
+
+// createConsumer creates or updates the durable consumer with the configured ack
+// settings
+func (s *NATSService) createConsumer(ctx context.Context) (jetstream.Consumer, error) {
+	consumer, err := s.stream.CreateOrUpdateConsumer(ctx, s.cfg.Stream, jetstream.ConsumerConfig{
+		Durable:       s.cfg.Durable,
+		FilterSubject: s.cfg.Subject,
+		AckPolicy:     jetstream.AckExplicitPolicy,
+		AckWait:       s.cfg.AckWait,
+		MaxDeliver:    s.cfg.MaxDeliver,
+		MaxAckPending: s.cfg.MaxAckPending,
+	})
 	if err != nil {
 		return nil, fmt.Errorf("failed to create pull consumer: %w", err)
 	}
 
 	slog.Info("Created NATS consumer", "durable", s.cfg.Durable)
-	return sub, nil
+	return consumer, nil
 }
 
-func (s *NATSService) worker(ctx context.Context, consumer *nats.Subscription, workerID string) {
-	slog.Info("NATS worker starting", "worker_id", workerID)
-	
+// dispatch hands messages to processing slots. It fetches only while slots are free,
+// as many messages as there are free slots, and each message goes to a slot the moment
+// it arrives. No message waits in a local buffer, where its ack deadline would run out
+// without in-progress acks. The server holds a fetch open until messages arrive, so an
+// idle worker does not poll. One open fetch serves all free slots instead of one per
+// slot, but its size follows the free slots, so the worker never takes more messages
+// than it can start. A worker without KV room fetches nothing and leaves the queue to
+// its peers. Every slot keeps its own worker ID.
+func (s *NATSService) dispatch(ctx context.Context, consumer jetstream.Consumer) {
+	slots := make(chan string, s.cfg.Concurrency)
+	for i := 0; i < s.cfg.Concurrency; i++ {
+		workerID := generateWorkerID()
+		slog.Info("NATS worker starting", "worker_id", workerID)
+		slots <- workerID
+	}
+
 	for {
+		// Wait for a free slot and take all others that are free
+		var free []string
 		select {
 		case <-ctx.Done():
-			slog.Info("NATS worker shutting down", "worker_id", workerID)
+			slog.Info("NATS workers shutting down")
 			return
-		default:
-			// Fetch messages with timeout
-			msgs, err := consumer.Fetch(1, nats.MaxWait(time.Second))
-			if err != nil {
-				if err == nats.ErrTimeout {
-					continue // Normal timeout, continue polling
-				}
-				slog.Error("Failed to fetch messages", "worker_id", workerID, "error", err)
-				time.Sleep(time.Second) // Back off on error
-				continue
+		case workerID := <-slots:
+			free = append(free, workerID)
+		}
+	more:
+		for len(free) < cap(slots) {
+			select {
+			case workerID := <-slots:
+				free = append(free, workerID)
+			default:
+				break more
 			}
+		}
 
-			for _, msg := range msgs {
-				// Track message processing
+		// Running requests hold the whole KV budget, let peers take new ones
+		if s.admission != nil && s.admission.Overloaded() {
+			for _, workerID := range free {
+				slots <- workerID
+			}
+			select {
+			case <-ctx.Done():
+			case <-time.After(fetchBackoff):
+			}
+			continue
+		}
+
+		batch, err := consumer.Fetch(len(free), jetstream.FetchMaxWait(fetchWait))
+		if err != nil {
+			slog.Error("Failed to fetch messages", "error", err)
+			for _, workerID := range free {
+				slots <- workerID
+			}
+			select {
+			case <-ctx.Done():
+				slog.Info("NATS workers shutting down")
+				return
+			case <-time.After(fetchErrorBackoff):
+			}
+			continue
+		}
+
+	receive:
+		for len(free) > 0 {
+			select {
+			case <-ctx.Done():
+				return
+			case msg, ok := <-batch.Messages():
+				if !ok {
+					break receive
+				}
+				workerID := free[0]
+				free = free[1:]
 				s.monitoring.IncrementPending()
-				s.processMessage(ctx, msg, workerID)
-				s.monitoring.DecrementPending()
+				go func() {
+					defer func() { slots <- workerID }()
+					defer s.monitoring.DecrementPending()
+					s.processMessage(ctx, msg, workerID)
+				}()
 			}
 		}
+		if err := batch.Error(); err != nil && !errors.Is(err, nats.ErrTimeout) {
+			slog.Error("Fetch ended with an error", "error", err)
+		}
+		for _, workerID := range free {
+			slots <- workerID
+		}
 	}
 }
 
-func (s *NATSService) processMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+func (s *NATSService) processMessage(ctx context.Context, msg jetstream.Msg, workerID string) {
 	// Track active processing
 	s.monitoring.IncrementActive()
 	defer s.monitoring.DecrementActive()
 	
+	// Keep long generations from being redelivered to another worker while they run
+	stop := s.keepInProgress(msg)
+	defer stop()
+	
+	// A redelivered request that already finished gets its stored response again
+	if s.replayResult(msg, workerID) {
+		return
+	}
+	
 	// Determine the request type based on subject
-	isEmbeddingRequest := strings.Contains(msg.Subject, "embedding.request")
-	isAudioRequest := strings.Contains(msg.Subject, "audio.request") || strings.Contains(msg.Subject, "transcribe.request")
+	isEmbeddingRequest := strings.Contains(msg.Subject(), "embedding.request")
+	isRerankRequest := strings.Contains(msg.Subject(), "rerank.request")
+	isAudioRequest := strings.Contains(msg.Subject(), "audio.request") || strings.Contains(msg.Subject(), "transcribe.request")
 	
 	if isEmbeddingRequest {
 		s.processEmbeddingMessage(ctx, msg, workerID)
+	} else if isRerankRequest {
+		s.processRerankMessage(ctx, msg, workerID)
 	} else if isAudioRequest {
 		s.processAudioMessage(ctx, msg, workerID)
 	} else {
@@ -214,16 +369,105 @@ func (s *NATSService) processMessage(ctx context.Context, msg *nats.Msg, workerI
 	}
 }
 
-func (s *NATSService) processInferenceMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+// keepInProgress tells JetStream the message is still being worked on until the
+// returned function is called. The interval stays well inside ACK_WAIT, and is capped
+// in case the durable consumer was created with a shorter one.
+func (s *NATSService) keepInProgress(msg jetstream.Msg) func() {
+	interval := s.cfg.AckWait / 3
+	if interval <= 0 || interval > maxInProgressInterval {
+		interval = maxInProgressInterval
+	}
+
+	done := make(chan struct{})
+	go func() {
+		ticker := time.NewTicker(interval)
+		defer ticker.Stop()
+		for {
+			select {
+			case <-done:
+				return
+			case <-ticker.C:
+				if err := msg.InProgress(); err != nil {
+					slog.Warn("Failed to extend ack deadline", "subject", msg.Subject(), "error", err)
+				}
+			}
+		}
+	}()
+	return func() { close(done) }
+}
+
+// resultKey scopes a req_id to this model, hashed since req_ids are not valid keys
+func (s *NATSService) resultKey(reqID string) string {
+	return hashKey(s.cfg.ModelName, reqID)
+}
+
+// replayResult answers a redelivered message from the result store and acks it.
+// First deliveries are not looked up, they cannot have a result yet.
+func (s *NATSService) replayResult(msg jetstream.Msg, workerID string) bool {
+	if s.results == nil {
+		return false
+	}
+	meta, err := msg.Metadata()
+	if err != nil || meta == nil || meta.NumDelivered <= 1 {
+		return false
+	}
+
+	var envelope struct {
+		ReqID   string `json:"req_id"`
+		ReplyTo string `json:"reply_to"`
+	}
+	if err := json.Unmarshal(msg.Data(), &envelope); err != nil || envelope.ReqID == "" {
+		return false
+	}
+
+	entry, err := s.results.Get(s.resultKey(envelope.ReqID))
+	if err != nil {
+		return false
+	}
+
+	if envelope.ReplyTo != "" {
+		if publishErr := s.conn.Publish(envelope.ReplyTo, entry.Value()); publishErr != nil {
+			slog.Error("Failed to publish replayed response", 
+				"worker_id", workerID,
+				"req_id", envelope.ReqID,
+				"reply_subject", envelope.ReplyTo, 
+				"error", publishErr)
+		}
+	}
+	if ackErr := msg.Ack(); ackErr != nil {
+		slog.Error("Failed to acknowledge replayed message", 
+			"worker_id", workerID,
+			"req_id", envelope.ReqID, 
+			"error", ackErr)
+	}
+
+	slog.Info("Replayed stored response for redelivered request",
+		"worker_id", workerID,
+		"req_id", envelope.ReqID,
+		"deliveries", meta.NumDelivered)
+	return true
+}
+
+// storeResult keeps a response so a redelivery of its message can be replayed
+func (s *NATSService) storeResult(reqID string, responseData []byte) {
+	if s.results == nil || reqID == "" {
+		return
+	}
+	if _, err := s.results.Put(s.resultKey(reqID), responseData); err != nil {
+		slog.Warn("Failed to store response", "req_id", reqID, "error", err)
+	}
+}
+
+func (s *NATSService) processInferenceMessage(ctx context.Context, msg jetstream.Msg, workerID string) {
 	start := time.Now()
 	
 	// Parse inference request
 	var req InferenceRequest
-	if err := json.Unmarshal(msg.Data, &req); err != nil {
+	if err := decodeInferenceRequest(msg.Data(), &req); err != nil {
 		slog.Error("Failed to parse inference request", 
 			"worker_id", workerID, 
 			"error", err,
-			"data", string(msg.Data))
+			"data", string(msg.Data()))
 		msg.Nak() // Negative acknowledgment
 		return
 	}
@@ -233,23 +477,50 @@ func (s *NATSService) processInferenceMessage(ctx context.Context, msg *nats.Msg
 		req.TraceID = req.ReqID
 	}
 
+	// Hold back or shed requests that cannot finish in time before they use the model
+	ticket, promptTokens, admitted := s.admit(msg, req, workerID)
+	if !admitted {
+		return
+	}
+
+	// A cancel for this req_id stops generation
+	ctx, release := s.cancels.start(ctx, req.ReqID)
+	defer release()
+
 	slog.Debug("Processing NATS inference request",
 		"worker_id", workerID,
 		"req_id", req.ReqID,
 		"trace_id", req.TraceID,
-		"subject", msg.Subject)
+		"subject", msg.Subject())
+
+	// Stream response text to <reply_to>.stream while generating
+	var onText llama.TextCallback
+	if req.Stream && req.ReplyTo != "" {
+		streamSubject := req.ReplyTo + ".stream"
+		onText = func(text string) {
+			chunkData, _ := json.Marshal(InferenceChunk{ReqID: req.ReqID, Text: text})
+			if publishErr := s.conn.Publish(streamSubject, chunkData); publishErr != nil {
+				slog.Warn("Failed to publish stream chunk", "req_id", req.ReqID, "error", publishErr)
+			}
+		}
+	}
 
 	// Process inference using the same service
-	response, err := s.inferenceService.ProcessInference(
+	response, err := s.inferenceService.ProcessInferenceStream(
 		ctx, 
 		req, 
-		fmt.Sprintf("nats.%s", msg.Subject), 
+		fmt.Sprintf("nats.%s", msg.Subject()), 
 		req.ReplyTo, // Use reply_to from message payload, not msg.Reply
 		workerID,
+		onText,
 	)
+	s.admission.Release(ticket, promptTokens, response)
 
-	// Prepare response
-	responseData, marshalErr := json.Marshal(response)
+	// Prepare response, the pooled buffer is copied by the store and publish
+	buf := fastjson.GetBuffer()
+	defer fastjson.PutBuffer(buf)
+	responseData, marshalErr := appendInferenceResponse(*buf, response)
+	*buf = responseData
 	if marshalErr != nil {
 		slog.Error("Failed to marshal response", 
 			"worker_id", workerID,
@@ -259,6 +530,9 @@ func (s *NATSService) processInferenceMessage(ctx context.Context, msg *nats.Msg
 		return
 	}
 
+	// Keep the response for redeliveries of this message
+	s.storeResult(req.ReqID, responseData)
+
 	// Send response if reply subject is provided in message payload
 	if req.ReplyTo != "" {
 		if publishErr := s.conn.Publish(req.ReplyTo, responseData); publishErr != nil {
@@ -297,16 +571,414 @@ func (s *NATSService) processInferenceMessage(ctx context.Context, msg *nats.Msg
 	}
 }
 
-func (s *NATSService) processAudioMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+// admit applies admission control to an inference message. Requests waiting for KV
+// room are NAKed with a delay, so they are redelivered later or to a less loaded worker.
+// Requests that cannot meet their deadline are answered with the reason and terminated.
+func (s *NATSService) admit(msg jetstream.Msg, req InferenceRequest, workerID string) (*admissionTicket, int, bool) {
+	if s.admission == nil {
+		return nil, 0, true
+	}
+
+	deadline := s.cfg.RequestDeadline
+	if req.DeadlineMs > 0 {
+		deadline = time.Duration(req.DeadlineMs) * time.Millisecond
+	}
+	remaining := deadline
+	canDelay := true
+	if meta, err := msg.Metadata(); err == nil && meta != nil {
+		remaining -= time.Since(meta.Timestamp)
+		canDelay = s.cfg.MaxDeliver <= 0 || int(meta.NumDelivered) < s.cfg.MaxDeliver
+	}
+
+	promptTokens, maxOutput := s.inferenceService.EstimateTokens(req)
+	ticket, decision, reason := s.admission.Admit(promptTokens, maxOutput, remaining, s.cfg.AdmissionRetryDelay, canDelay)
+	switch decision {
+	case admissionDelay:
+		slog.Info("Inference delayed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"reason", reason)
+		if err := msg.NakWithDelay(s.cfg.AdmissionRetryDelay); err != nil {
+			slog.Error("Failed to delay message", "req_id", req.ReqID, "error", err)
+		}
+		return nil, 0, false
+	case admissionReject:
+		slog.Warn("Inference rejected",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"prompt_tokens", promptTokens,
+			"max_output", maxOutput,
+			"reason", reason)
+		if req.ReplyTo != "" {
+			responseData, _ := json.Marshal(&InferenceResponse{
+				ReqID:        req.ReqID,
+				FinishReason: "rejected",
+				Error:        "overloaded: " + reason,
+			})
+			if err := s.conn.Publish(req.ReplyTo, responseData); err != nil {
+				slog.Error("Failed to publish rejection", "req_id", req.ReqID, "error", err)
+			}
+		}
+		if err := msg.Term(); err != nil {
+			slog.Error("Failed to terminate message", "req_id", req.ReqID, "error", err)
+		}
+		return nil, 0, false
+	}
+	return ticket, promptTokens, true
+}
+
+// subscribeCancel stops generations on CANCEL_SUBJECT. Any worker may hold the request,
+// so every worker receives the cancel and only the one running it replies.
+func (s *NATSService) subscribeCancel() error {
+	if s.inferenceService == nil {
+		return nil
+	}
+	llm := s.inferenceService.llm
+	if s.cfg.CancelSubject == "" || llm.IsEmbeddingModel() || llm.IsRerankModel() {
+		return nil
+	}
+
+	_, err := s.conn.Subscribe(s.cfg.CancelSubject, func(msg *nats.Msg) {
+		var req CancelRequest
+		if err := json.Unmarshal(msg.Data, &req); err != nil || req.ReqID == "" {
+			slog.Warn("Invalid cancel request", "subject", msg.Subject, "data", string(msg.Data))
+			return
+		}
+
+		if !s.cancels.cancel(req.ReqID) {
+			return
+		}
+		slog.Info("Inference cancelled", "req_id", req.ReqID)
+
+		if msg.Reply != "" {
+			responseData, _ := json.Marshal(CancelResponse{ReqID: req.ReqID, Cancelled: true})
+			if err := msg.Respond(responseData); err != nil {
+				slog.Warn("Failed to respond to cancel", "req_id", req.ReqID, "error", err)
+			}
+		}
+	})
+	if err != nil {
+		return err
+	}
+
+	slog.Info("Subscribed cancel subject", "subject", s.cfg.CancelSubject)
+	return nil
+}
+
+// subscribeScore serves score requests on the score subject for text generation models.
+// Replies go to the message reply subject, or reply_to from the payload if set.
+func (s *NATSService) subscribeScore(ctx context.Context) error {
+	if s.inferenceService == nil {
+		return nil
+	}
+	llm := s.inferenceService.llm
+	if s.cfg.ScoreSubject == "" || llm.IsEmbeddingModel() || llm.IsRerankModel() {
+		return nil
+	}
+
+	workerID := generateWorkerID()
+	_, err := s.conn.QueueSubscribe(s.cfg.ScoreSubject, s.cfg.QueueGroup, func(msg *nats.Msg) {
+		s.monitoring.IncrementActive()
+		defer s.monitoring.DecrementActive()
+		s.processScoreMessage(ctx, msg, workerID)
+	})
+	if err != nil {
+		return err
+	}
+
+	slog.Info("Subscribed score subject", "subject", s.cfg.ScoreSubject, "queue_group", s.cfg.QueueGroup)
+	return nil
+}
+
+func (s *NATSService) processScoreMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+	start := time.Now()
+	
+	var req ScoreRequest
+	if err := json.Unmarshal(msg.Data, &req); err != nil {
+		slog.Error("Failed to parse score request", 
+			"worker_id", workerID, 
+			"error", err,
+			"data", string(msg.Data))
+		return
+	}
+
+	if req.TraceID == "" {
+		req.TraceID = req.ReqID
+	}
+
+	replyTo := req.ReplyTo
+	if replyTo == "" {
+		replyTo = msg.Reply
+	}
+
+	response, err := s.inferenceService.ProcessScore(ctx, req, fmt.Sprintf("nats.%s", msg.Subject), replyTo, workerID)
+
+	responseData, marshalErr := json.Marshal(response)
+	if marshalErr != nil {
+		slog.Error("Failed to marshal score response", 
+			"worker_id", workerID,
+			"req_id", req.ReqID, 
+			"error", marshalErr)
+		return
+	}
+
+	if replyTo != "" {
+		if publishErr := s.conn.Publish(replyTo, responseData); publishErr != nil {
+			slog.Error("Failed to publish score response", 
+				"worker_id", workerID,
+				"req_id", req.ReqID,
+				"reply_subject", replyTo, 
+				"error", publishErr)
+		}
+	}
+
+	duration := time.Since(start)
+	
+	if err == nil {
+		slog.Info("NATS scoring completed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"duration_ms", duration.Milliseconds(),
+			"candidates", len(response.Candidates),
+			"tokens_in", response.TokensIn)
+	} else {
+		slog.Error("NATS scoring failed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"duration_ms", duration.Milliseconds(),
+			"error", err)
+	}
+}
+
+// subscribeIndex serves the vector index on <INDEX_SUBJECT>.upsert and .search. Both are
+// load balanced over the queue group. The worker that takes an upsert embeds it and
+// appends it to the upsert log on <INDEX_SUBJECT>.log, a JetStream stream that every
+// worker replays into its own replica from the last sequence it applied. Replicas stay
+// identical, and a worker that was down catches up when it starts.
+func (s *NATSService) subscribeIndex(ctx context.Context) error {
+	if s.indexService == nil {
+		return nil
+	}
+
+	if err := s.ensureIndexStream(); err != nil {
+		return err
+	}
+
+	workerID := generateWorkerID()
+	upsertSubject := s.cfg.IndexSubject + ".upsert"
+	searchSubject := s.cfg.IndexSubject + ".search"
+	logSubject := s.cfg.IndexSubject + ".log"
+
+	// Ordered consumers deliver the log in sequence, one update at a time
+	start := nats.DeliverAll()
+	if applied := s.indexService.Applied(); applied > 0 {
+		start = nats.StartSequence(applied + 1)
+	}
+	if _, err := s.js.Subscribe(logSubject, func(msg *nats.Msg) {
+		s.applyIndexUpdate(msg, workerID)
+	}, nats.OrderedConsumer(), start); err != nil {
+		return err
+	}
+
+	if _, err := s.conn.QueueSubscribe(upsertSubject, s.cfg.QueueGroup, func(msg *nats.Msg) {
+		s.monitoring.IncrementActive()
+		defer s.monitoring.DecrementActive()
+		s.processIndexUpsertMessage(ctx, msg, workerID)
+	}); err != nil {
+		return err
+	}
+
+	if _, err := s.conn.QueueSubscribe(searchSubject, s.cfg.QueueGroup, func(msg *nats.Msg) {
+		s.monitoring.IncrementActive()
+		defer s.monitoring.DecrementActive()
+		s.processIndexSearchMessage(ctx, msg, workerID)
+	}); err != nil {
+		return err
+	}
+
+	slog.Info("Subscribed index subjects",
+		"upsert", upsertSubject,
+		"search", searchSubject,
+		"log", logSubject,
+		"applied", s.indexService.Applied(),
+		"queue_group", s.cfg.QueueGroup)
+	return nil
+}
+
+// ensureIndexStream creates the stream of the upsert log or adds the log subject to it.
+// The log is kept without limits, it is what a new replica is built from.
+func (s *NATSService) ensureIndexStream() error {
+	logSubject := s.cfg.IndexSubject + ".log"
+
+	streamInfo, err := s.js.StreamInfo(s.cfg.IndexStream)
+	if err == nats.ErrStreamNotFound {
+		_, err = s.js.AddStream(&nats.StreamConfig{
+			Name:      s.cfg.IndexStream,
+			Subjects:  []string{logSubject},
+			Storage:   nats.FileStorage,
+			Retention: nats.LimitsPolicy,
+		})
+		if err != nil {
+			return fmt.Errorf("failed to create index stream: %w", err)
+		}
+		slog.Info("Created index stream", "name", s.cfg.IndexStream, "subject", logSubject)
+		return nil
+	}
+	if err != nil {
+		return fmt.Errorf("failed to get index stream info: %w", err)
+	}
+
+	for _, subject := range streamInfo.Config.Subjects {
+		if subject == logSubject {
+			return nil
+		}
+	}
+	newConfig := streamInfo.Config
+	newConfig.Subjects = append(newConfig.Subjects, logSubject)
+	if _, err := s.js.UpdateStream(&newConfig); err != nil {
+		return fmt.Errorf("failed to update index stream with new subject: %w", err)
+	}
+	slog.Info("Updated index stream with new subject", "name", s.cfg.IndexStream, "subject", logSubject)
+	return nil
+}
+
+// PublishIndexUpdate appends an embedded upsert to the upsert log
+func (s *NATSService) PublishIndexUpdate(update *IndexUpdate) (uint64, error) {
+	data, err := json.Marshal(update)
+	if err != nil {
+		return 0, fmt.Errorf("failed to marshal index update: %w", err)
+	}
+	ack, err := s.js.Publish(s.cfg.IndexSubject+".log", data)
+	if err != nil {
+		return 0, fmt.Errorf("failed to publish index update: %w", err)
+	}
+	return ack.Sequence, nil
+}
+
+// applyIndexUpdate writes one update of the upsert log to the local replica
+func (s *NATSService) applyIndexUpdate(msg *nats.Msg, workerID string) {
+	meta, err := msg.Metadata()
+	if err != nil {
+		slog.Error("Index update without metadata", "worker_id", workerID, "error", err)
+		return
+	}
+	seq := meta.Sequence.Stream
+
+	var update IndexUpdate
+	if err := json.Unmarshal(msg.Data, &update); err != nil {
+		slog.Error("Failed to parse index update", "worker_id", workerID, "seq", seq, "error", err)
+		s.indexService.Apply(nil, seq)
+		return
+	}
+	if err := s.indexService.Apply(&update, seq); err != nil {
+		slog.Error("Failed to apply index update",
+			"worker_id", workerID,
+			"seq", seq,
+			"collection", update.Collection,
+			"error", err)
+	}
+}
+
+func (s *NATSService) processIndexUpsertMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+	var req IndexUpsertRequest
+	if err := json.Unmarshal(msg.Data, &req); err != nil {
+		slog.Error("Failed to parse index upsert request", 
+			"worker_id", workerID, 
+			"error", err,
+			"data", string(msg.Data))
+		return
+	}
+
+	replyTo := req.ReplyTo
+	if replyTo == "" {
+		replyTo = msg.Reply
+	}
+
+	response, err := s.indexService.ProcessUpsert(ctx, req, fmt.Sprintf("nats.%s", msg.Subject), replyTo, workerID)
+	s.publishIndexResponse(replyTo, response, workerID)
+
+	if err == nil {
+		slog.Info("NATS index upsert completed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"collection", req.Collection,
+			"documents", response.Upserted,
+			"duration_ms", response.DurationMs)
+	} else {
+		slog.Error("NATS index upsert failed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"collection", req.Collection,
+			"error", err)
+	}
+}
+
+func (s *NATSService) processIndexSearchMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+	var req IndexSearchRequest
+	if err := json.Unmarshal(msg.Data, &req); err != nil {
+		slog.Error("Failed to parse index search request", 
+			"worker_id", workerID, 
+			"error", err,
+			"data", string(msg.Data))
+		return
+	}
+
+	replyTo := req.ReplyTo
+	if replyTo == "" {
+		replyTo = msg.Reply
+	}
+
+	response, err := s.indexService.ProcessSearch(ctx, req, fmt.Sprintf("nats.%s", msg.Subject), replyTo, workerID)
+	s.publishIndexResponse(replyTo, response, workerID)
+
+	if err == nil {
+		slog.Info("NATS index search completed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"collection", req.Collection,
+			"hits", len(response.Hits),
+			"duration_ms", response.DurationMs)
+	} else {
+		slog.Error("NATS index search failed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"collection", req.Collection,
+			"error", err)
+	}
+}
+
+func (s *NATSService) publishIndexResponse(replyTo string, response *IndexResponse, workerID string) {
+	if replyTo == "" {
+		return
+	}
+
+	responseData, err := json.Marshal(response)
+	if err != nil {
+		slog.Error("Failed to marshal index response", 
+			"worker_id", workerID,
+			"req_id", response.ReqID, 
+			"error", err)
+		return
+	}
+	if err := s.conn.Publish(replyTo, responseData); err != nil {
+		slog.Error("Failed to publish index response", 
+			"worker_id", workerID,
+			"req_id", response.ReqID,
+			"reply_subject", replyTo, 
+			"error", err)
+	}
+}
+
+func (s *NATSService) processAudioMessage(ctx context.Context, msg jetstream.Msg, workerID string) {
 	start := time.Now()
 	
 	// Parse audio request
 	var req AudioRequest
-	if err := json.Unmarshal(msg.Data, &req); err != nil {
+	if err := decodeAudioRequest(msg.Data(), &req); err != nil {
 		slog.Error("Failed to parse audio request", 
 			"worker_id", workerID, 
 			"error", err,
-			"data", string(msg.Data))
+			"data", string(msg.Data()))
 		msg.Nak() // Negative acknowledgment
 		return
 	}
@@ -320,7 +992,7 @@ func (s *NATSService) processAudioMessage(ctx context.Context, msg *nats.Msg, wo
 		"worker_id", workerID,
 		"req_id", req.ReqID,
 		"trace_id", req.TraceID,
-		"subject", msg.Subject)
+		"subject", msg.Subject())
 
 	// Audio service should be set during initialization, but handle the case where it's not
 	if s.audioService == nil {
@@ -333,13 +1005,16 @@ func (s *NATSService) processAudioMessage(ctx context.Context, msg *nats.Msg, wo
 	response, err := s.audioService.ProcessTranscription(
 		ctx, 
 		req, 
-		fmt.Sprintf("nats.%s", msg.Subject), 
+		fmt.Sprintf("nats.%s", msg.Subject()), 
 		req.ReplyTo,
 		workerID,
 	)
 
-	// Prepare response
-	responseData, marshalErr := json.Marshal(response)
+	// Prepare response, the pooled buffer is copied by the store and publish
+	buf := fastjson.GetBuffer()
+	defer fastjson.PutBuffer(buf)
+	responseData, marshalErr := appendAudioResponse(*buf, response)
+	*buf = responseData
 	if marshalErr != nil {
 		slog.Error("Failed to marshal audio response", 
 			"worker_id", workerID,
@@ -349,6 +1024,9 @@ func (s *NATSService) processAudioMessage(ctx context.Context, msg *nats.Msg, wo
 		return
 	}
 
+	// Keep the response for redeliveries of this message
+	s.storeResult(req.ReqID, responseData)
+
 	// Send response if reply subject is provided in message payload
 	if req.ReplyTo != "" {
 		if publishErr := s.conn.Publish(req.ReplyTo, responseData); publishErr != nil {
@@ -386,14 +1064,14 @@ func (s *NATSService) processAudioMessage(ctx context.Context, msg *nats.Msg, wo
 	}
 }
 
-func (s *NATSService) processEmbeddingMessage(ctx context.Context, msg *nats.Msg, workerID string) {
+func (s *NATSService) processEmbeddingMessage(ctx context.Context, msg jetstream.Msg, workerID string) {
 	// Parse embedding request
 	var req EmbeddingRequest
-	if err := json.Unmarshal(msg.Data, &req); err != nil {
+	if err := decodeEmbeddingRequest(msg.Data(), &req); err != nil {
 		slog.Error("Failed to parse embedding request", 
 			"worker_id", workerID, 
 			"error", err,
-			"data", string(msg.Data))
+			"data", string(msg.Data()))
 		msg.Nak() // Negative acknowledgment
 		return
 	}
@@ -407,7 +1085,7 @@ func (s *NATSService) processEmbeddingMessage(ctx context.Context, msg *nats.Msg
 		"worker_id", workerID,
 		"req_id", req.ReqID,
 		"trace_id", req.TraceID,
-		"subject", msg.Subject)
+		"subject", msg.Subject())
 
 	// Create embedding service if not already created
 	if s.embeddingService == nil {
@@ -418,13 +1096,16 @@ func (s *NATSService) processEmbeddingMessage(ctx context.Context, msg *nats.Msg
 	response, err := s.embeddingService.ProcessEmbedding(
 		ctx, 
 		req, 
-		fmt.Sprintf("nats.%s", msg.Subject), 
+		fmt.Sprintf("nats.%s", msg.Subject()), 
 		req.ReplyTo,
 		workerID,
 	)
 
-	// Prepare response
-	responseData, marshalErr := json.Marshal(response)
+	// Prepare response, the pooled buffer is copied by the store and publish
+	buf := fastjson.GetBuffer()
+	defer fastjson.PutBuffer(buf)
+	responseData, marshalErr := appendEmbeddingResponse(*buf, response)
+	*buf = responseData
 	if marshalErr != nil {
 		slog.Error("Failed to marshal embedding response", 
 			"worker_id", workerID,
@@ -434,6 +1115,9 @@ func (s *NATSService) processEmbeddingMessage(ctx context.Context, msg *nats.Msg
 		return
 	}
 
+	// Keep the response for redeliveries of this message
+	s.storeResult(req.ReqID, responseData)
+
 	// Send response if reply subject is provided in message payload
 	if req.ReplyTo != "" {
 		if publishErr := s.conn.Publish(req.ReplyTo, responseData); publishErr != nil {
@@ -467,6 +1151,83 @@ func (s *NATSService) processEmbeddingMessage(ctx context.Context, msg *nats.Msg
 	}
 }
 
+func (s *NATSService) processRerankMessage(ctx context.Context, msg jetstream.Msg, workerID string) {
+	var req RerankRequest
+	if err := json.Unmarshal(msg.Data(), &req); err != nil {
+		slog.Error("Failed to parse rerank request", 
+			"worker_id", workerID, 
+			"error", err,
+			"data", string(msg.Data()))
+		msg.Nak() // Negative acknowledgment
+		return
+	}
+
+	if req.TraceID == "" {
+		req.TraceID = req.ReqID
+	}
+
+	slog.Debug("Processing NATS rerank request",
+		"worker_id", workerID,
+		"req_id", req.ReqID,
+		"trace_id", req.TraceID,
+		"subject", msg.Subject())
+
+	if s.embeddingService == nil {
+		s.embeddingService = NewEmbeddingService(s.inferenceService.llm, s.inferenceService.GetRepository())
+	}
+
+	response, err := s.embeddingService.ProcessRerank(
+		ctx, 
+		req, 
+		fmt.Sprintf("nats.%s", msg.Subject()), 
+		req.ReplyTo,
+		workerID,
+	)
+
+	responseData, marshalErr := json.Marshal(response)
+	if marshalErr != nil {
+		slog.Error("Failed to marshal rerank response", 
+			"worker_id", workerID,
+			"req_id", req.ReqID, 
+			"error", marshalErr)
+		msg.Nak()
+		return
+	}
+
+	// Keep the response for redeliveries of this message
+	s.storeResult(req.ReqID, responseData)
+
+	if req.ReplyTo != "" {
+		if publishErr := s.conn.Publish(req.ReplyTo, responseData); publishErr != nil {
+			slog.Error("Failed to publish rerank response", 
+				"worker_id", workerID,
+				"req_id", req.ReqID,
+				"reply_subject", req.ReplyTo, 
+				"error", publishErr)
+		}
+	}
+
+	if ackErr := msg.Ack(); ackErr != nil {
+		slog.Error("Failed to acknowledge rerank message", 
+			"worker_id", workerID,
+			"req_id", req.ReqID, 
+			"error", ackErr)
+	}
+
+	if err == nil {
+		slog.Info("NATS rerank completed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"documents", len(req.Documents),
+			"duration_ms", response.DurationMs)
+	} else {
+		slog.Error("NATS rerank failed",
+			"worker_id", workerID,
+			"req_id", req.ReqID,
+			"error", err)
+	}
+}
+
 func (s *NATSService) Close() error {
 	if s.conn != nil {
 		s.conn.Close()
@@ -486,6 +1247,11 @@ func (s *NATSService) SetAudioService(audioService *AudioService) {
 	s.audioService = audioService
 }
 
+func (s *NATSService) SetIndexService(indexService *IndexService) {
+	s.indexService = indexService
+	indexService.SetPublisher(s)
+}
+
 func (s *NATSService) GetAudioService() *AudioService {
 	return s.audioService
 }
\ No newline at end of file
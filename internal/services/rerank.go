@@ -0,0 +1,98 @@
+package services
+
+import (
+	"context"
+	"fmt"
+	"time"
+
+	"github.com/aigoflow/inference-service/internal/llama"
+	"github.com/aigoflow/inference-service/internal/models"
+)
+
+type RerankRequest struct {
+	TraceID         string   `json:"trace_id,omitempty"`
+	ReqID           string   `json:"req_id"`
+	Query           string   `json:"query"`
+	Documents       []string `json:"documents"`
+	TopN            int      `json:"top_n,omitempty"`            // Return only the best N results
+	ReturnDocuments bool     `json:"return_documents,omitempty"` // Include document text in results
+	Model           string   `json:"model,omitempty"`
+	ReplyTo         string   `json:"reply_to,omitempty"`
+}
+
+type RerankResponse struct {
+	ReqID      string               `json:"req_id"`
+	Results    []llama.RerankResult `json:"results"` // Sorted by relevance, best first
+	Model      string               `json:"model"`
+	Usage      EmbeddingUsage       `json:"usage"`
+	DurationMs int64                `json:"duration_ms"`
+	Error      string               `json:"error,omitempty"`
+}
+
+// ProcessRerank scores documents against the query with a cross-encoder model
+func (s *EmbeddingService) ProcessRerank(ctx context.Context, req RerankRequest, source string, replyTo string, workerID string) (*RerankResponse, error) {
+	start := time.Now()
+	
+	if !s.llm.IsRerankModel() {
+		return &RerankResponse{
+			ReqID: req.ReqID,
+			Error: "Model does not support reranking",
+		}, fmt.Errorf("model does not support reranking")
+	}
+	
+	results, tokens, err := s.llm.Rerank(req.Query, req.Documents)
+	duration := time.Since(start)
+	
+	response := &RerankResponse{
+		ReqID:      req.ReqID,
+		Model:      req.Model,
+		DurationMs: duration.Milliseconds(),
+	}
+	
+	status := "ok"
+	if err != nil {
+		status = "error"
+		response.Error = fmt.Sprintf("Rerank failed: %v", err)
+	} else {
+		if req.TopN > 0 && req.TopN < len(results) {
+			results = results[:req.TopN]
+		}
+		if req.ReturnDocuments {
+			for i := range results {
+				results[i].Document = req.Documents[results[i].Index]
+			}
+		}
+		response.Results = results
+		response.Usage = EmbeddingUsage{
+			PromptTokens: tokens,
+			TotalTokens:  tokens,
+		}
+	}
+	
+	traceID := req.TraceID
+	if traceID == "" {
+		traceID = req.ReqID
+	}
+	
+	logData := models.RequestLog{
+		Timestamp:      start,
+		ReqID:          req.ReqID,
+		TraceID:        traceID,
+		Source:         source,
+		WorkerID:       workerID,
+		RawInput:       req.Query,
+		FormattedInput: req.Query,
+		ResponseText:   toJSON(response.Results),
+		InputLen:       len(req.Query),
+		ParamsJSON:     toJSON(map[string]interface{}{"documents": len(req.Documents), "top_n": req.TopN}),
+		GrammarUsed:    "none",
+		TokensIn:       tokens,
+		DurationMs:     duration.Milliseconds(),
+		Status:         status,
+		Error:          response.Error,
+		ReplyTo:        replyTo,
+	}
+	s.repo.Request().LogRequest(ctx, &logData)
+	
+	return response, err
+}
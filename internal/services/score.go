@@ -0,0 +1,94 @@
+package services
+
+import (
+	"context"
+	"fmt"
+	"time"
+
+	"github.com/aigoflow/inference-service/internal/llama"
+	"github.com/aigoflow/inference-service/internal/models"
+)
+
+// ScoreRequest asks for the log-likelihood of candidate continuations of a prompt
+type ScoreRequest struct {
+	TraceID    string              `json:"trace_id,omitempty"`
+	ReqID      string              `json:"req_id"`
+	Input      string              `json:"input"`
+	Messages   []llama.ChatMessage `json:"messages,omitempty"` // Score as the next assistant turn instead
+	Candidates []string            `json:"candidates"`
+	Raw        bool                `json:"raw,omitempty"` // Score against the input without formatting
+	ReplyTo    string              `json:"reply_to,omitempty"`
+}
+
+type ScoreResponse struct {
+	ReqID        string                 `json:"req_id"`
+	Candidates   []llama.CandidateScore `json:"candidates"`
+	Best         int                    `json:"best"` // Index of the most likely candidate
+	Text         string                 `json:"text"` // Text of the most likely candidate
+	TokensIn     int                    `json:"tokens_in"`
+	TokensScored int                    `json:"tokens_scored"`
+	DurationMs   int64                  `json:"duration_ms"`
+	Error        string                 `json:"error,omitempty"`
+}
+
+// ProcessScore scores every candidate in a single prefill of the shared prompt
+func (s *InferenceService) ProcessScore(ctx context.Context, req ScoreRequest, source string, replyTo string, workerID string) (*ScoreResponse, error) {
+	start := time.Now()
+
+	traceID := req.TraceID
+	if traceID == "" {
+		traceID = req.ReqID
+	}
+
+	var scoring llama.Scoring
+	var err error
+	rawInput := req.Input
+	if len(req.Messages) > 0 {
+		rawInput = toJSON(req.Messages)
+		scoring, err = s.llm.ScoreChatCandidates(req.Messages, req.Candidates)
+	} else {
+		scoring, err = s.llm.ScoreCandidates(req.Input, req.Candidates, req.Raw)
+	}
+
+	duration := time.Since(start)
+	response := &ScoreResponse{
+		ReqID:      req.ReqID,
+		DurationMs: duration.Milliseconds(),
+	}
+
+	status := "ok"
+	if err != nil {
+		status = "error"
+		response.Error = err.Error()
+	} else {
+		response.Candidates = scoring.Candidates
+		response.Best = scoring.Best
+		response.Text = scoring.Candidates[scoring.Best].Text
+		response.TokensIn = scoring.TokensIn
+		response.TokensScored = scoring.TokensScored
+	}
+
+	s.repo.Request().LogRequest(ctx, &models.RequestLog{
+		Timestamp:      start,
+		TraceID:        traceID,
+		ReqID:          req.ReqID,
+		WorkerID:       workerID,
+		Source:         source,
+		ReplyTo:        replyTo,
+		RawInput:       rawInput,
+		FormattedInput: scoring.FormattedInput,
+		ResponseText:   response.Text,
+		InputLen:       len(rawInput),
+		ParamsJSON:     toJSON(map[string]interface{}{"candidates": req.Candidates}),
+		GrammarUsed:    "none",
+		TokensIn:       scoring.TokensIn,
+		DurationMs:     duration.Milliseconds(),
+		Status:         status,
+		Error:          response.Error,
+	})
+
+	if err != nil {
+		return response, fmt.Errorf("scoring failed: %w", err)
+	}
+	return response, nil
+}
@@ -0,0 +1,237 @@
+package vectorindex
+
+import (
+	"container/heap"
+	"math"
+	"math/rand"
+	"sort"
+)
+
+const (
+	defaultM              = 16
+	defaultEfConstruction = 200
+	defaultEfSearch       = 64
+)
+
+// node is one vector in the graph. Links[l] are its neighbors on layer l.
+type node struct {
+	Level   int
+	Links   [][]int32
+	Deleted bool
+}
+
+// graph is a hierarchical navigable small world graph over unit vectors. Node i is
+// vector i of the vector file, so only the links are kept in the snapshot.
+type graph struct {
+	M              int
+	M0             int // Neighbors kept on layer 0
+	EfConstruction int
+	Entry          int32
+	MaxLevel       int
+	Nodes          []node
+
+	levelMult float64
+	rng       *rand.Rand
+}
+
+func newGraph() *graph {
+	g := &graph{
+		M:              defaultM,
+		M0:             defaultM * 2,
+		EfConstruction: defaultEfConstruction,
+		Entry:          -1,
+	}
+	g.init()
+	return g
+}
+
+// init sets the fields that are not part of the snapshot
+func (g *graph) init() {
+	g.levelMult = 1 / math.Log(float64(g.M))
+	g.rng = rand.New(rand.NewSource(int64(len(g.Nodes)) + 1))
+}
+
+// candidate is a node and its distance to the query, 1 - cosine similarity
+type candidate struct {
+	id   int32
+	dist float32
+}
+
+// minHeap pops the closest candidate first
+type minHeap []candidate
+
+func (h minHeap) Len() int            { return len(h) }
+func (h minHeap) Less(i, j int) bool  { return h[i].dist < h[j].dist }
+func (h minHeap) Swap(i, j int)       { h[i], h[j] = h[j], h[i] }
+func (h *minHeap) Push(x interface{}) { *h = append(*h, x.(candidate)) }
+func (h *minHeap) Pop() interface{} {
+	old := *h
+	c := old[len(old)-1]
+	*h = old[:len(old)-1]
+	return c
+}
+
+// maxHeap pops the farthest candidate first
+type maxHeap struct{ minHeap }
+
+func (h maxHeap) Less(i, j int) bool { return h.minHeap[i].dist > h.minHeap[j].dist }
+
+func (g *graph) randomLevel() int {
+	return int(-math.Log(1-g.rng.Float64()) * g.levelMult)
+}
+
+func (g *graph) maxLinks(level int) int {
+	if level == 0 {
+		return g.M0
+	}
+	return g.M
+}
+
+// insert links vector id, already appended to vectors, into the graph
+func (g *graph) insert(vectors *vectorFile, id int32) {
+	level := g.randomLevel()
+	n := node{Level: level, Links: make([][]int32, level+1)}
+	g.Nodes = append(g.Nodes, n)
+
+	if g.Entry < 0 {
+		g.Entry = id
+		g.MaxLevel = level
+		return
+	}
+
+	query := vectors.at(int(id))
+	entry := candidate{id: g.Entry, dist: 1 - dot(query, vectors.at(int(g.Entry)))}
+	for l := g.MaxLevel; l > level; l-- {
+		entry = g.greedyClosest(vectors, query, entry, l)
+	}
+
+	entries := []candidate{entry}
+	for l := min(level, g.MaxLevel); l >= 0; l-- {
+		found := g.searchLayer(vectors, query, entries, g.EfConstruction, l)
+		neighbors := found
+		if len(neighbors) > g.M {
+			neighbors = neighbors[:g.M]
+		}
+
+		links := make([]int32, len(neighbors))
+		for i, c := range neighbors {
+			links[i] = c.id
+		}
+		g.Nodes[id].Links[l] = links
+
+		for _, c := range neighbors {
+			g.link(vectors, c.id, id, l)
+		}
+		entries = found
+	}
+
+	if level > g.MaxLevel {
+		g.MaxLevel = level
+		g.Entry = id
+	}
+}
+
+// link adds a reverse edge from -> to on level, pruning to the closest neighbors when full
+func (g *graph) link(vectors *vectorFile, from, to int32, level int) {
+	links := append(g.Nodes[from].Links[level], to)
+	limit := g.maxLinks(level)
+	if len(links) > limit {
+		base := vectors.at(int(from))
+		scored := make([]candidate, len(links))
+		for i, id := range links {
+			scored[i] = candidate{id: id, dist: 1 - dot(base, vectors.at(int(id)))}
+		}
+		sort.Slice(scored, func(a, b int) bool { return scored[a].dist < scored[b].dist })
+		links = links[:0]
+		for _, c := range scored[:limit] {
+			links = append(links, c.id)
+		}
+	}
+	g.Nodes[from].Links[level] = links
+}
+
+// greedyClosest walks level towards the query until no neighbor is closer
+func (g *graph) greedyClosest(vectors *vectorFile, query []float32, entry candidate, level int) candidate {
+	for changed := true; changed; {
+		changed = false
+		for _, id := range g.Nodes[entry.id].Links[level] {
+			if d := 1 - dot(query, vectors.at(int(id))); d < entry.dist {
+				entry = candidate{id: id, dist: d}
+				changed = true
+			}
+		}
+	}
+	return entry
+}
+
+// searchLayer returns up to ef nodes closest to the query on level, closest first
+func (g *graph) searchLayer(vectors *vectorFile, query []float32, entries []candidate, ef int, level int) []candidate {
+	visited := make(map[int32]struct{}, ef*4)
+	candidates := &minHeap{}
+	results := &maxHeap{}
+	for _, e := range entries {
+		visited[e.id] = struct{}{}
+		heap.Push(candidates, e)
+		heap.Push(results, e)
+	}
+	for results.Len() > ef {
+		heap.Pop(results)
+	}
+
+	for candidates.Len() > 0 {
+		c := heap.Pop(candidates).(candidate)
+		if results.Len() >= ef && c.dist > results.minHeap[0].dist {
+			break
+		}
+
+		for _, id := range g.Nodes[c.id].Links[level] {
+			if _, seen := visited[id]; seen {
+				continue
+			}
+			visited[id] = struct{}{}
+
+			d := 1 - dot(query, vectors.at(int(id)))
+			if results.Len() < ef || d < results.minHeap[0].dist {
+				heap.Push(candidates, candidate{id: id, dist: d})
+				heap.Push(results, candidate{id: id, dist: d})
+				if results.Len() > ef {
+					heap.Pop(results)
+				}
+			}
+		}
+	}
+
+	found := []candidate(results.minHeap)
+	sort.Slice(found, func(a, b int) bool { return found[a].dist < found[b].dist })
+	return found
+}
+
+// search returns the k nodes closest to the query that are not deleted. Deleted
+// nodes still route the search, so ef is widened by the number of them.
+func (g *graph) search(vectors *vectorFile, query []float32, k, ef int, deleted int) []candidate {
+	if g.Entry < 0 || k <= 0 {
+		return nil
+	}
+	if ef < k {
+		ef = k
+	}
+	ef += min(deleted, ef)
+
+	entry := candidate{id: g.Entry, dist: 1 - dot(query, vectors.at(int(g.Entry)))}
+	for l := g.MaxLevel; l > 0; l-- {
+		entry = g.greedyClosest(vectors, query, entry, l)
+	}
+
+	found := g.searchLayer(vectors, query, []candidate{entry}, ef, 0)
+	results := make([]candidate, 0, k)
+	for _, c := range found {
+		if g.Nodes[c.id].Deleted {
+			continue
+		}
+		results = append(results, c)
+		if len(results) == k {
+			break
+		}
+	}
+	return results
+}
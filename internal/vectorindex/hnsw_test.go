@@ -0,0 +1,182 @@
+package vectorindex
+
+import (
+	"fmt"
+	"math/rand"
+	"sort"
+	"testing"
+)
+
+func randomVectors(rng *rand.Rand, n, dim int) [][]float32 {
+	vectors := make([][]float32, n)
+	for i := range vectors {
+		vectors[i] = make([]float32, dim)
+		for j := range vectors[i] {
+			vectors[i][j] = rng.Float32()*2 - 1
+		}
+	}
+	return vectors
+}
+
+func documents(n int) []Document {
+	docs := make([]Document, n)
+	for i := range docs {
+		docs[i] = Document{ID: fmt.Sprintf("doc-%d", i), Text: fmt.Sprintf("text %d", i)}
+	}
+	return docs
+}
+
+// exactNearest returns the IDs of the k most similar vectors by brute force
+func exactNearest(vectors [][]float32, query []float32, k int) []string {
+	q := normalize(query)
+	order := make([]int, len(vectors))
+	scores := make([]float32, len(vectors))
+	for i, v := range vectors {
+		order[i] = i
+		scores[i] = dot(q, normalize(v))
+	}
+	sort.Slice(order, func(a, b int) bool { return scores[order[a]] > scores[order[b]] })
+
+	ids := make([]string, k)
+	for i := range ids {
+		ids[i] = fmt.Sprintf("doc-%d", order[i])
+	}
+	return ids
+}
+
+func TestDot(t *testing.T) {
+	a := []float32{1, 2, 3, 4, 5, 6, 7}
+	b := []float32{7, 6, 5, 4, 3, 2, 1}
+	if got := dot(a, b); got != 84 {
+		t.Errorf("dot = %v, want 84", got)
+	}
+}
+
+func TestSearchRecall(t *testing.T) {
+	rng := rand.New(rand.NewSource(1))
+	const n, dim, k = 2000, 32, 10
+	vectors := randomVectors(rng, n, dim)
+
+	store, err := Open(t.TempDir())
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer store.Close()
+
+	c, err := store.Collection("recall", dim, true)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := c.Upsert(documents(n), vectors); err != nil {
+		t.Fatal(err)
+	}
+
+	found, total := 0, 0
+	for _, query := range randomVectors(rng, 50, dim) {
+		hits, err := c.Search(query, k, 0)
+		if err != nil {
+			t.Fatal(err)
+		}
+		want := make(map[string]bool)
+		for _, id := range exactNearest(vectors, query, k) {
+			want[id] = true
+		}
+		for _, hit := range hits {
+			if want[hit.ID] {
+				found++
+			}
+		}
+		total += k
+	}
+
+	if recall := float64(found) / float64(total); recall < 0.9 {
+		t.Errorf("recall@%d = %.3f, want at least 0.9", k, recall)
+	}
+}
+
+func TestUpsertReplaces(t *testing.T) {
+	store, err := Open(t.TempDir())
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer store.Close()
+
+	c, err := store.Collection("replace", 2, true)
+	if err != nil {
+		t.Fatal(err)
+	}
+	docs := []Document{{ID: "a"}, {ID: "b"}}
+	if err := c.Upsert(docs, [][]float32{{1, 0}, {0, 1}}); err != nil {
+		t.Fatal(err)
+	}
+	if err := c.Upsert([]Document{{ID: "a", Text: "moved"}}, [][]float32{{0, 1}}); err != nil {
+		t.Fatal(err)
+	}
+
+	if c.Len() != 2 {
+		t.Errorf("Len = %d, want 2", c.Len())
+	}
+	hits, err := c.Search([]float32{1, 0}, 5, 0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(hits) != 2 {
+		t.Fatalf("got %d hits, want 2", len(hits))
+	}
+	for _, hit := range hits {
+		if hit.ID == "a" && hit.Text != "moved" {
+			t.Errorf("replaced document returned old text %q", hit.Text)
+		}
+	}
+}
+
+func TestReopen(t *testing.T) {
+	dir := t.TempDir()
+	rng := rand.New(rand.NewSource(2))
+	vectors := randomVectors(rng, 300, 8)
+
+	store, err := Open(dir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	c, err := store.Collection("persist", 8, true)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := c.Upsert(documents(300), vectors); err != nil {
+		t.Fatal(err)
+	}
+	before, _ := c.Search(vectors[42], 5, 0)
+	store.Close()
+
+	store, err = Open(dir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer store.Close()
+
+	if _, err := store.Collection("persist", 16, false); err == nil {
+		t.Error("expected a dimension mismatch error")
+	}
+	if _, err := store.Collection("missing", 8, false); err == nil {
+		t.Error("expected a missing collection error")
+	}
+
+	c, err = store.Collection("persist", 8, false)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if c.Len() != 300 {
+		t.Errorf("Len = %d, want 300", c.Len())
+	}
+	after, err := c.Search(vectors[42], 5, 0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(after) == 0 || after[0].ID != "doc-42" {
+		t.Errorf("expected doc-42 as the best hit after reopening, got %v", after)
+	}
+	if len(before) != len(after) {
+		t.Errorf("got %d hits after reopening, want %d", len(after), len(before))
+	}
+}
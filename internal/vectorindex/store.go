@@ -0,0 +1,406 @@
+package vectorindex
+
+import (
+	"context"
+	"encoding/gob"
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"regexp"
+	"strconv"
+	"strings"
+	"sync"
+	"syscall"
+)
+
+var collectionName = regexp.MustCompile(`^[A-Za-z0-9_-]{1,64}$`)
+
+// ErrLocked is returned by Open when another process owns the directory
+var ErrLocked = errors.New("index directory is in use by another process")
+
+// maxReplicas bounds the replica directories OpenReplica tries
+const maxReplicas = 256
+
+// Document is the payload stored with a vector
+type Document struct {
+	ID       string            `json:"id"`
+	Text     string            `json:"text,omitempty"`
+	Metadata map[string]string `json:"metadata,omitempty"`
+}
+
+// Hit is a search result with its cosine similarity to the query
+type Hit struct {
+	Document
+	Score float32 `json:"score"`
+}
+
+// Store holds the collections of one worker under a directory. Each collection is a
+// memory-mapped vector file and a snapshot of the graph and documents. The directory is
+// locked for the lifetime of the store, so two processes never write the same files.
+type Store struct {
+	dir         string
+	lock        *os.File
+	mu          sync.Mutex
+	collections map[string]*Collection
+
+	// Sequence of the last update applied from the upsert log, persisted by Flush
+	applied   uint64
+	appliedCh chan struct{} // Closed and replaced whenever applied advances
+}
+
+// Open returns the store rooted at dir, creating the directory if needed. It fails
+// with ErrLocked when another process has the directory open.
+func Open(dir string) (*Store, error) {
+	if err := os.MkdirAll(dir, 0755); err != nil {
+		return nil, fmt.Errorf("failed to create index directory: %w", err)
+	}
+
+	lock, err := os.OpenFile(filepath.Join(dir, "LOCK"), os.O_RDWR|os.O_CREATE, 0644)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open index lock: %w", err)
+	}
+	if err := syscall.Flock(int(lock.Fd()), syscall.LOCK_EX|syscall.LOCK_NB); err != nil {
+		lock.Close()
+		if err == syscall.EWOULDBLOCK {
+			return nil, ErrLocked
+		}
+		return nil, fmt.Errorf("failed to lock index directory: %w", err)
+	}
+
+	s := &Store{dir: dir, lock: lock, collections: make(map[string]*Collection), appliedCh: make(chan struct{})}
+	if data, err := os.ReadFile(filepath.Join(dir, "APPLIED")); err == nil {
+		if s.applied, err = strconv.ParseUint(strings.TrimSpace(string(data)), 10, 64); err != nil {
+			s.Close()
+			return nil, fmt.Errorf("failed to read applied sequence: %w", err)
+		}
+	} else if !os.IsNotExist(err) {
+		s.Close()
+		return nil, fmt.Errorf("failed to read applied sequence: %w", err)
+	}
+	return s, nil
+}
+
+// OpenReplica opens the first replica directory under parent that no other process
+// owns. Workers sharing a data directory each get a replica of their own, and a
+// restarted worker usually gets its previous one back.
+func OpenReplica(parent string) (*Store, error) {
+	for i := 0; i < maxReplicas; i++ {
+		s, err := Open(filepath.Join(parent, fmt.Sprintf("replica-%d", i)))
+		if err != ErrLocked {
+			return s, err
+		}
+	}
+	return nil, fmt.Errorf("all %d replica directories under %s are in use", maxReplicas, parent)
+}
+
+// Dir returns the directory of the store
+func (s *Store) Dir() string {
+	return s.dir
+}
+
+// Applied returns the sequence of the last update applied from the upsert log
+func (s *Store) Applied() uint64 {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return s.applied
+}
+
+// SetApplied records that the updates up to seq have been applied. It is persisted
+// with the next Flush, updates after it are applied again after a crash.
+func (s *Store) SetApplied(seq uint64) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if seq <= s.applied {
+		return
+	}
+	s.applied = seq
+	close(s.appliedCh)
+	s.appliedCh = make(chan struct{})
+}
+
+// WaitApplied blocks until the update with sequence seq has been applied
+func (s *Store) WaitApplied(ctx context.Context, seq uint64) error {
+	for {
+		s.mu.Lock()
+		applied, changed := s.applied, s.appliedCh
+		s.mu.Unlock()
+		if applied >= seq {
+			return nil
+		}
+		select {
+		case <-changed:
+		case <-ctx.Done():
+			return fmt.Errorf("update %d not applied, at %d: %w", seq, applied, ctx.Err())
+		}
+	}
+}
+
+// ValidateName checks that name can be used as a collection name
+func ValidateName(name string) error {
+	if !collectionName.MatchString(name) {
+		return fmt.Errorf("invalid collection name %q", name)
+	}
+	return nil
+}
+
+// Collection returns the named collection, loading it from disk on first use. A missing
+// collection is created with dimension dim when create is set.
+func (s *Store) Collection(name string, dim int, create bool) (*Collection, error) {
+	if err := ValidateName(name); err != nil {
+		return nil, err
+	}
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if c, ok := s.collections[name]; ok {
+		if c.dim != dim {
+			return nil, fmt.Errorf("collection %s has dimension %d, got %d", name, c.dim, dim)
+		}
+		return c, nil
+	}
+
+	base := filepath.Join(s.dir, name)
+	if _, err := os.Stat(base + ".vec"); os.IsNotExist(err) && !create {
+		return nil, fmt.Errorf("collection %s not found", name)
+	}
+
+	c, err := openCollection(base, dim)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open collection %s: %w", name, err)
+	}
+	s.collections[name] = c
+	return c, nil
+}
+
+// Flush writes the snapshots of collections changed since the last flush, then the
+// applied sequence. Snapshots rewrite the whole graph, so upserts only mark their
+// collection and are written here in batches.
+func (s *Store) Flush() error {
+	s.mu.Lock()
+	applied := s.applied
+	collections := make([]*Collection, 0, len(s.collections))
+	for _, c := range s.collections {
+		collections = append(collections, c)
+	}
+	s.mu.Unlock()
+
+	for _, c := range collections {
+		if err := c.flush(); err != nil {
+			return err
+		}
+	}
+	if applied == 0 {
+		return nil
+	}
+
+	// Snapshots hold at least the updates up to applied, a crash replays the rest
+	path := filepath.Join(s.dir, "APPLIED")
+	if err := os.WriteFile(path+".tmp", []byte(strconv.FormatUint(applied, 10)), 0644); err != nil {
+		return fmt.Errorf("failed to write applied sequence: %w", err)
+	}
+	return os.Rename(path+".tmp", path)
+}
+
+// Close flushes and unmaps every open collection and releases the directory
+func (s *Store) Close() error {
+	firstErr := s.Flush()
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	for name, c := range s.collections {
+		if err := c.close(); err != nil && firstErr == nil {
+			firstErr = err
+		}
+		delete(s.collections, name)
+	}
+	if s.lock != nil {
+		s.lock.Close()
+		s.lock = nil
+	}
+	return firstErr
+}
+
+// snapshot is the on-disk form of everything but the vectors
+type snapshot struct {
+	Graph *graph
+	Docs  []Document
+}
+
+// Collection is a set of documents searchable by vector similarity
+type Collection struct {
+	mu      sync.RWMutex
+	path    string
+	dim     int
+	vectors *vectorFile
+	graph   *graph
+	docs    []Document
+	ids     map[string]int32
+	deleted int
+	dirty   bool // Changed since the last snapshot
+}
+
+func openCollection(base string, dim int) (*Collection, error) {
+	vectors, err := openVectorFile(base+".vec", dim)
+	if err != nil {
+		return nil, err
+	}
+
+	c := &Collection{
+		path:    base + ".hnsw",
+		dim:     dim,
+		vectors: vectors,
+		graph:   newGraph(),
+		ids:     make(map[string]int32),
+	}
+
+	file, err := os.Open(c.path)
+	if err == nil {
+		var snap snapshot
+		err = gob.NewDecoder(file).Decode(&snap)
+		file.Close()
+		if err != nil {
+			vectors.close()
+			return nil, fmt.Errorf("failed to read graph: %w", err)
+		}
+		c.graph = snap.Graph
+		c.graph.init()
+		c.docs = snap.Docs
+	} else if !os.IsNotExist(err) {
+		vectors.close()
+		return nil, fmt.Errorf("failed to open graph: %w", err)
+	}
+
+	// Vectors appended after the last snapshot are not linked, drop them
+	if vectors.count > len(c.graph.Nodes) {
+		vectors.setCount(len(c.graph.Nodes))
+	}
+	if vectors.count < len(c.graph.Nodes) {
+		vectors.close()
+		return nil, fmt.Errorf("graph has %d nodes but only %d vectors", len(c.graph.Nodes), vectors.count)
+	}
+
+	for i, n := range c.graph.Nodes {
+		if n.Deleted {
+			c.deleted++
+			continue
+		}
+		c.ids[c.docs[i].ID] = int32(i)
+	}
+	return c, nil
+}
+
+// Dim returns the vector dimension of the collection
+func (c *Collection) Dim() int {
+	return c.dim
+}
+
+// Len returns the number of live documents
+func (c *Collection) Len() int {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	return len(c.ids)
+}
+
+// Upsert adds documents with their vectors. A document whose ID already exists
+// replaces the old one, which stays in the graph as a routing node only. Changes are
+// persisted by the next Store.Flush.
+func (c *Collection) Upsert(docs []Document, vectors [][]float32) error {
+	if len(docs) != len(vectors) {
+		return fmt.Errorf("got %d documents but %d vectors", len(docs), len(vectors))
+	}
+	for i, v := range vectors {
+		if len(v) != c.dim {
+			return fmt.Errorf("vector %d has dimension %d, expected %d", i, len(v), c.dim)
+		}
+		if docs[i].ID == "" {
+			return fmt.Errorf("document %d has no id", i)
+		}
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	for i, doc := range docs {
+		if old, ok := c.ids[doc.ID]; ok {
+			c.graph.Nodes[old].Deleted = true
+			c.docs[old] = Document{ID: doc.ID}
+			c.deleted++
+		}
+
+		id, err := c.vectors.append(normalize(vectors[i]))
+		if err != nil {
+			return err
+		}
+		c.docs = append(c.docs, doc)
+		c.graph.insert(c.vectors, int32(id))
+		c.ids[doc.ID] = int32(id)
+		c.dirty = true
+	}
+	return nil
+}
+
+// Search returns up to k documents most similar to the query. ef is the size of the
+// candidate list, larger is slower with better recall; 0 uses the default.
+func (c *Collection) Search(query []float32, k, ef int) ([]Hit, error) {
+	if len(query) != c.dim {
+		return nil, fmt.Errorf("query has dimension %d, expected %d", len(query), c.dim)
+	}
+	if ef <= 0 {
+		ef = defaultEfSearch
+	}
+
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+
+	found := c.graph.search(c.vectors, normalize(query), k, ef, c.deleted)
+	hits := make([]Hit, len(found))
+	for i, f := range found {
+		hits[i] = Hit{Document: c.docs[f.id], Score: 1 - f.dist}
+	}
+	return hits, nil
+}
+
+// flush saves the collection if it changed since the last snapshot
+func (c *Collection) flush() error {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if !c.dirty {
+		return nil
+	}
+	if err := c.save(); err != nil {
+		return err
+	}
+	c.dirty = false
+	return nil
+}
+
+// save syncs the vectors and atomically replaces the graph snapshot
+func (c *Collection) save() error {
+	if err := c.vectors.sync(); err != nil {
+		return fmt.Errorf("failed to sync vectors: %w", err)
+	}
+
+	tmp := c.path + ".tmp"
+	file, err := os.Create(tmp)
+	if err != nil {
+		return fmt.Errorf("failed to write graph: %w", err)
+	}
+	if err := gob.NewEncoder(file).Encode(snapshot{Graph: c.graph, Docs: c.docs}); err != nil {
+		file.Close()
+		os.Remove(tmp)
+		return fmt.Errorf("failed to write graph: %w", err)
+	}
+	if err := file.Close(); err != nil {
+		os.Remove(tmp)
+		return fmt.Errorf("failed to write graph: %w", err)
+	}
+	return os.Rename(tmp, c.path)
+}
+
+func (c *Collection) close() error {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.vectors.close()
+}
@@ -0,0 +1,137 @@
+package vectorindex
+
+import (
+	"context"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+)
+
+func TestOpenLocksDirectory(t *testing.T) {
+	parent := t.TempDir()
+
+	first, err := OpenReplica(parent)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if _, err := Open(first.Dir()); err != ErrLocked {
+		t.Errorf("opening a locked directory returned %v, want ErrLocked", err)
+	}
+
+	// A second worker on the same data directory gets a replica of its own
+	second, err := OpenReplica(parent)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if second.Dir() == first.Dir() {
+		t.Errorf("both workers opened %s", first.Dir())
+	}
+
+	// A restarted worker gets its released replica back
+	firstDir := first.Dir()
+	first.Close()
+	again, err := OpenReplica(parent)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if again.Dir() != firstDir {
+		t.Errorf("reopened %s, want %s", again.Dir(), firstDir)
+	}
+	again.Close()
+	second.Close()
+}
+
+func TestFlushBatchesSnapshots(t *testing.T) {
+	dir := t.TempDir()
+	store, err := Open(dir)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	c, err := store.Collection("batched", 2, true)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i, v := range [][]float32{{1, 0}, {0, 1}, {1, 1}} {
+		if err := c.Upsert(documents(3)[i:i+1], [][]float32{v}); err != nil {
+			t.Fatal(err)
+		}
+		store.SetApplied(uint64(i + 1))
+	}
+
+	// Upserts only mark the collection, the snapshot is written by Flush
+	snapshot := filepath.Join(dir, "batched.hnsw")
+	if _, err := os.Stat(snapshot); !os.IsNotExist(err) {
+		t.Errorf("snapshot written before Flush: %v", err)
+	}
+	if err := store.Flush(); err != nil {
+		t.Fatal(err)
+	}
+	info, err := os.Stat(snapshot)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	// An unchanged collection is not written again
+	if err := store.Flush(); err != nil {
+		t.Fatal(err)
+	}
+	if again, _ := os.Stat(snapshot); !again.ModTime().Equal(info.ModTime()) {
+		t.Error("unchanged collection was written again")
+	}
+	store.Close()
+
+	store, err = Open(dir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer store.Close()
+	if store.Applied() != 3 {
+		t.Errorf("Applied = %d after reopening, want 3", store.Applied())
+	}
+	c, err = store.Collection("batched", 2, false)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if c.Len() != 3 {
+		t.Errorf("Len = %d after reopening, want 3", c.Len())
+	}
+}
+
+func TestWaitApplied(t *testing.T) {
+	store, err := Open(t.TempDir())
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer store.Close()
+
+	done := make(chan error, 1)
+	go func() {
+		done <- store.WaitApplied(context.Background(), 2)
+	}()
+
+	store.SetApplied(1)
+	select {
+	case err := <-done:
+		t.Fatalf("returned before sequence 2 was applied: %v", err)
+	case <-time.After(20 * time.Millisecond):
+	}
+
+	store.SetApplied(2)
+	if err := <-done; err != nil {
+		t.Fatal(err)
+	}
+
+	// Sequences never move back
+	store.SetApplied(1)
+	if store.Applied() != 2 {
+		t.Errorf("Applied = %d, want 2", store.Applied())
+	}
+
+	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Millisecond)
+	defer cancel()
+	if err := store.WaitApplied(ctx, 3); err == nil {
+		t.Error("expected a timeout waiting for an update that never arrives")
+	}
+}
@@ -0,0 +1,164 @@
+package vectorindex
+
+import (
+	"encoding/binary"
+	"fmt"
+	"math"
+	"os"
+	"syscall"
+	"unsafe"
+)
+
+const (
+	vectorMagic      = "VIDXVEC1"
+	vectorHeaderSize = 16 // magic, dimension, count
+	initialCapacity  = 1024
+)
+
+// vectorFile is a memory-mapped file of fixed-size float32 vectors. Vectors are read
+// in place from the mapping, so a collection opens without loading them into the heap.
+type vectorFile struct {
+	file     *os.File
+	data     []byte
+	dim      int
+	count    int
+	capacity int
+}
+
+// openVectorFile maps the vector file at path, creating it for dim-sized vectors if missing
+func openVectorFile(path string, dim int) (*vectorFile, error) {
+	file, err := os.OpenFile(path, os.O_RDWR|os.O_CREATE, 0644)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open vector file: %w", err)
+	}
+
+	info, err := file.Stat()
+	if err != nil {
+		file.Close()
+		return nil, fmt.Errorf("failed to stat vector file: %w", err)
+	}
+
+	v := &vectorFile{file: file, dim: dim}
+	if info.Size() == 0 {
+		if err := v.resize(initialCapacity); err != nil {
+			file.Close()
+			return nil, err
+		}
+		copy(v.data, vectorMagic)
+		binary.LittleEndian.PutUint32(v.data[8:], uint32(dim))
+		return v, nil
+	}
+
+	v.capacity = int((info.Size() - vectorHeaderSize) / int64(dim*4))
+	if err := v.mmap(info.Size()); err != nil {
+		file.Close()
+		return nil, err
+	}
+	if string(v.data[:8]) != vectorMagic {
+		v.close()
+		return nil, fmt.Errorf("%s is not a vector file", path)
+	}
+	if stored := int(binary.LittleEndian.Uint32(v.data[8:])); stored != dim {
+		v.close()
+		return nil, fmt.Errorf("vector file has dimension %d, expected %d", stored, dim)
+	}
+	v.count = int(binary.LittleEndian.Uint32(v.data[12:]))
+	return v, nil
+}
+
+func (v *vectorFile) mmap(size int64) error {
+	data, err := syscall.Mmap(int(v.file.Fd()), 0, int(size), syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_SHARED)
+	if err != nil {
+		return fmt.Errorf("failed to map vector file: %w", err)
+	}
+	v.data = data
+	return nil
+}
+
+// resize grows the file to hold capacity vectors and maps it again
+func (v *vectorFile) resize(capacity int) error {
+	if v.data != nil {
+		if err := syscall.Munmap(v.data); err != nil {
+			return fmt.Errorf("failed to unmap vector file: %w", err)
+		}
+		v.data = nil
+	}
+
+	size := int64(vectorHeaderSize + capacity*v.dim*4)
+	if err := v.file.Truncate(size); err != nil {
+		return fmt.Errorf("failed to grow vector file: %w", err)
+	}
+	v.capacity = capacity
+	return v.mmap(size)
+}
+
+// at returns vector i as a view into the mapping, valid until the next append
+func (v *vectorFile) at(i int) []float32 {
+	offset := vectorHeaderSize + i*v.dim*4
+	return unsafe.Slice((*float32)(unsafe.Pointer(&v.data[offset])), v.dim)
+}
+
+// append stores a vector and returns its position
+func (v *vectorFile) append(vector []float32) (int, error) {
+	if v.count == v.capacity {
+		if err := v.resize(v.capacity * 2); err != nil {
+			return 0, err
+		}
+	}
+
+	i := v.count
+	copy(v.at(i), vector)
+	v.setCount(i + 1)
+	return i, nil
+}
+
+// setCount records the number of stored vectors in the header
+func (v *vectorFile) setCount(count int) {
+	v.count = count
+	binary.LittleEndian.PutUint32(v.data[12:], uint32(count))
+}
+
+func (v *vectorFile) sync() error {
+	return v.file.Sync()
+}
+
+func (v *vectorFile) close() error {
+	if v.data != nil {
+		syscall.Munmap(v.data)
+		v.data = nil
+	}
+	return v.file.Close()
+}
+
+// dot is the inner product of two equal-length vectors. Four independent accumulators
+// keep the loop from being bound by the latency of a single dependency chain.
+func dot(a, b []float32) float32 {
+	n := len(a)
+	b = b[:n]
+	var s0, s1, s2, s3 float32
+	i := 0
+	for ; i+4 <= n; i += 4 {
+		s0 += a[i] * b[i]
+		s1 += a[i+1] * b[i+1]
+		s2 += a[i+2] * b[i+2]
+		s3 += a[i+3] * b[i+3]
+	}
+	for ; i < n; i++ {
+		s0 += a[i] * b[i]
+	}
+	return s0 + s1 + s2 + s3
+}
+
+// normalize scales vector to unit length so the inner product is the cosine similarity
+func normalize(vector []float32) []float32 {
+	norm := dot(vector, vector)
+	out := make([]float32, len(vector))
+	if norm == 0 {
+		return out
+	}
+	scale := float32(1 / math.Sqrt(float64(norm)))
+	for i, x := range vector {
+		out[i] = x * scale
+	}
+	return out
+}
@@ -16,9 +16,15 @@ type InferenceClient interface {
 	// Text inference
 	Infer(ctx context.Context, model, input string, params map[string]interface{}) (*InferenceResponse, error)
 	InferRaw(ctx context.Context, model, input string, params map[string]interface{}) (*InferenceResponse, error)
+	Chat(ctx context.Context, model string, messages []ChatMessage, params map[string]interface{}) (*InferenceResponse, error)
+	Score(ctx context.Context, model, input string, candidates []string) (*ScoreResponse, error)
+	Cancel(model, reqID string) error
 	
 	// Embeddings
 	Embed(ctx context.Context, model, input string) (*EmbeddingResponse, error)
+	Rerank(ctx context.Context, model, query string, documents []string, topN int) (*RerankResponse, error)
+	IndexUpsert(ctx context.Context, model, collection string, documents []IndexDocument) (*IndexResponse, error)
+	IndexSearch(ctx context.Context, model, collection, query string, topK int) (*IndexResponse, error)
 	
 	// Health and discovery
 	CheckHealth(ctx context.Context, model string) (*HealthStatus, error)
@@ -71,7 +77,7 @@ func (c *NATSInferenceClient) Infer(ctx context.Context, model, input string, pa
 		ReplyTo: replySubject,
 	}
 	
-	return c.sendRequest(ctx, topic, replySubject, request)
+	return c.sendRequest(ctx, model, topic, replySubject, request)
 }
 
 // InferRaw performs raw inference (bypasses formatting)
@@ -89,17 +95,40 @@ func (c *NATSInferenceClient) InferRaw(ctx context.Context, model, input string,
 		ReplyTo: replySubject,
 	}
 	
-	return c.sendRequest(ctx, topic, replySubject, request)
+	return c.sendRequest(ctx, model, topic, replySubject, request)
 }
 
-// sendRequest implements the exact nats-chat.go pattern
-func (c *NATSInferenceClient) sendRequest(ctx context.Context, topic, replySubject string, request InferenceRequest) (*InferenceResponse, error) {
+// Chat performs multi-turn inference rendered with the model's chat template
+func (c *NATSInferenceClient) Chat(ctx context.Context, model string, messages []ChatMessage, params map[string]interface{}) (*InferenceResponse, error) {
+	topic := fmt.Sprintf("inference.request.%s", model)
+	
+	reqID := ulid.Make().String()
+	replySubject := fmt.Sprintf("inference.response.%s.%s", c.clientID, reqID)
+	
+	request := InferenceRequest{
+		ReqID:    reqID,
+		Messages: messages,
+		Params:   params,
+		ReplyTo:  replySubject,
+	}
+	
+	return c.sendRequest(ctx, model, topic, replySubject, request)
+}
+
+// sendRequest implements the exact nats-chat.go pattern. Generation is cancelled on
+// the worker when the request times out or ctx is done.
+func (c *NATSInferenceClient) sendRequest(ctx context.Context, model, topic, replySubject string, request InferenceRequest) (*InferenceResponse, error) {
 	slog.Debug("Sending inference request",
 		"topic", topic,
 		"req_id", request.ReqID,
 		"reply_subject", replySubject,
 		"raw", request.Raw)
 	
+	// Workers shed the request rather than answer after we stopped waiting
+	if request.DeadlineMs == 0 {
+		request.DeadlineMs = c.timeout.Milliseconds()
+	}
+	
 	// Marshal request
 	requestBytes, err := json.Marshal(request)
 	if err != nil {
@@ -139,12 +168,29 @@ func (c *NATSInferenceClient) sendRequest(ctx context.Context, topic, replySubje
 		return &response, nil
 		
 	case <-time.After(c.timeout):
+		c.Cancel(model, request.ReqID)
 		return nil, fmt.Errorf("request timeout after %v", c.timeout)
 	case <-ctx.Done():
+		c.Cancel(model, request.ReqID)
 		return nil, ctx.Err()
 	}
 }
 
+// Cancel stops the generation of reqID on whichever worker runs it. A request still
+// queued is dropped when it starts.
+func (c *NATSInferenceClient) Cancel(model, reqID string) error {
+	topic := fmt.Sprintf("inference.cancel.%s", model)
+	
+	requestBytes, err := json.Marshal(CancelRequest{ReqID: reqID})
+	if err != nil {
+		return fmt.Errorf("failed to marshal cancel request: %w", err)
+	}
+	if err := c.conn.Publish(topic, requestBytes); err != nil {
+		return fmt.Errorf("failed to publish cancel: %w", err)
+	}
+	return nil
+}
+
 // CheckHealth checks if a model is available and healthy
 func (c *NATSInferenceClient) CheckHealth(ctx context.Context, model string) (*HealthStatus, error) {
 	healthTopic := fmt.Sprintf("models.%s.health", model)
@@ -244,6 +290,132 @@ func (c *NATSInferenceClient) Embed(ctx context.Context, model, input string) (*
 	}
 }
 
+// Score returns the log-likelihood of each candidate continuation of the prompt
+func (c *NATSInferenceClient) Score(ctx context.Context, model, input string, candidates []string) (*ScoreResponse, error) {
+	topic := fmt.Sprintf("score.request.%s", model)
+	
+	request := ScoreRequest{
+		ReqID:      ulid.Make().String(),
+		Input:      input,
+		Candidates: candidates,
+	}
+	
+	requestBytes, err := json.Marshal(request)
+	if err != nil {
+		return nil, fmt.Errorf("failed to marshal score request: %w", err)
+	}
+	
+	requestCtx, cancel := context.WithTimeout(ctx, c.timeout)
+	defer cancel()
+	
+	msg, err := c.conn.RequestWithContext(requestCtx, topic, requestBytes)
+	if err != nil {
+		return nil, fmt.Errorf("score request failed: %w", err)
+	}
+	
+	var response ScoreResponse
+	if err := json.Unmarshal(msg.Data, &response); err != nil {
+		return nil, fmt.Errorf("failed to parse score response: %w", err)
+	}
+	if response.Error != "" {
+		return &response, fmt.Errorf("scoring error: %s", response.Error)
+	}
+	return &response, nil
+}
+
+// Rerank orders documents by relevance to the query using a reranker worker
+func (c *NATSInferenceClient) Rerank(ctx context.Context, model, query string, documents []string, topN int) (*RerankResponse, error) {
+	topic := fmt.Sprintf("rerank.request.%s", model)
+	
+	reqID := ulid.Make().String()
+	replySubject := fmt.Sprintf("rerank.response.%s.%s", c.clientID, reqID)
+	
+	request := RerankRequest{
+		ReqID:     reqID,
+		Query:     query,
+		Documents: documents,
+		TopN:      topN,
+		Model:     model,
+		ReplyTo:   replySubject,
+	}
+	
+	requestBytes, err := json.Marshal(request)
+	if err != nil {
+		return nil, fmt.Errorf("failed to marshal rerank request: %w", err)
+	}
+	
+	// Subscribe to reply subject
+	replyChan := make(chan *nats.Msg, 1)
+	sub, err := c.conn.Subscribe(replySubject, func(msg *nats.Msg) {
+		replyChan <- msg
+	})
+	if err != nil {
+		return nil, fmt.Errorf("failed to subscribe to rerank reply: %w", err)
+	}
+	defer sub.Unsubscribe()
+	
+	if err := c.conn.Publish(topic, requestBytes); err != nil {
+		return nil, fmt.Errorf("failed to publish rerank request: %w", err)
+	}
+	
+	select {
+	case msg := <-replyChan:
+		var response RerankResponse
+		if err := json.Unmarshal(msg.Data, &response); err != nil {
+			return nil, fmt.Errorf("failed to parse rerank response: %w", err)
+		}
+		return &response, nil
+		
+	case <-time.After(c.timeout):
+		return nil, fmt.Errorf("rerank request timeout after %v", c.timeout)
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+// IndexUpsert embeds documents and stores them in a collection of the model's vector index
+func (c *NATSInferenceClient) IndexUpsert(ctx context.Context, model, collection string, documents []IndexDocument) (*IndexResponse, error) {
+	return c.indexRequest(ctx, fmt.Sprintf("index.%s.upsert", model), IndexUpsertRequest{
+		ReqID:      ulid.Make().String(),
+		Collection: collection,
+		Documents:  documents,
+	})
+}
+
+// IndexSearch returns the documents of a collection most similar to the query
+func (c *NATSInferenceClient) IndexSearch(ctx context.Context, model, collection, query string, topK int) (*IndexResponse, error) {
+	return c.indexRequest(ctx, fmt.Sprintf("index.%s.search", model), IndexSearchRequest{
+		ReqID:      ulid.Make().String(),
+		Collection: collection,
+		Query:      query,
+		TopK:       topK,
+	})
+}
+
+func (c *NATSInferenceClient) indexRequest(ctx context.Context, topic string, request interface{}) (*IndexResponse, error) {
+	requestBytes, err := json.Marshal(request)
+	if err != nil {
+		return nil, fmt.Errorf("failed to marshal index request: %w", err)
+	}
+	
+	requestCtx, cancel := context.WithTimeout(ctx, c.timeout)
+	defer cancel()
+	
+	msg, err := c.conn.RequestWithContext(requestCtx, topic, requestBytes)
+	if err != nil {
+		return nil, fmt.Errorf("index request failed: %w", err)
+	}
+	
+	var response IndexResponse
+	if err := json.Unmarshal(msg.Data, &response); err != nil {
+		return nil, fmt.Errorf("failed to parse index response: %w", err)
+	}
+	if response.Error != "" {
+		return &response, fmt.Errorf("index error: %s", response.Error)
+	}
+	return &response, nil
+}
+
 // ListModels discovers available models via NATS
 func (c *NATSInferenceClient) ListModels(ctx context.Context) ([]string, error) {
 	discoveryTopic := "models.discovery"
@@ -4,22 +4,85 @@ import "time"
 
 // InferenceRequest represents a request to the inference service
 type InferenceRequest struct {
-	ReqID   string                 `json:"req_id"`
-	Input   string                 `json:"input"`
-	Params  map[string]interface{} `json:"params"`
-	Raw     bool                   `json:"raw,omitempty"`
-	ReplyTo string                 `json:"reply_to,omitempty"`
+	ReqID      string                 `json:"req_id"`
+	Input      string                 `json:"input"`
+	Params     map[string]interface{} `json:"params"`
+	Raw        bool                   `json:"raw,omitempty"`
+	ReplyTo    string                 `json:"reply_to,omitempty"`
+	Messages   []ChatMessage          `json:"messages,omitempty"`
+	DeadlineMs int64                  `json:"deadline_ms,omitempty"` // Workers reject requests they cannot answer in time
+}
+
+// ChatMessage represents a single turn of a chat conversation
+type ChatMessage struct {
+	Role    string `json:"role"`
+	Content string `json:"content"`
 }
 
 // InferenceResponse represents a response from the inference service
 type InferenceResponse struct {
-	ReqID        string `json:"req_id"`
-	Text         string `json:"text"`
-	TokensIn     int    `json:"tokens_in"`
-	TokensOut    int    `json:"tokens_out"`
-	FinishReason string `json:"finish_reason"`
-	DurationMs   int64  `json:"duration_ms"`
-	Error        string `json:"error,omitempty"`
+	ReqID           string    `json:"req_id"`
+	Text            string    `json:"text"`
+	TokensIn        int       `json:"tokens_in"`
+	TokensOut       int       `json:"tokens_out"`
+	ReasoningTokens int       `json:"reasoning_tokens,omitempty"`
+	AnswerTokens    int       `json:"answer_tokens,omitempty"`
+	Choices         []Choice  `json:"choices,omitempty"`
+	Logprobs        *Logprobs `json:"logprobs,omitempty"`
+	FinishReason    string    `json:"finish_reason"`
+	DurationMs      int64     `json:"duration_ms"`
+	Error           string    `json:"error,omitempty"`
+}
+
+// Choice is one of several completions requested with the n parameter
+type Choice struct {
+	Text      string  `json:"text"`
+	TokensOut int     `json:"tokens_out"`
+	Logprob   float64 `json:"logprob"`
+}
+
+// Logprobs holds per-token log-probabilities as flat parallel arrays. Alternatives of
+// token i are TopTokens[i*TopN : (i+1)*TopN], best first.
+type Logprobs struct {
+	TopN        int       `json:"top_n"`
+	Tokens      []int32   `json:"tokens"`
+	Text        []string  `json:"text"`
+	Logprobs    []float32 `json:"logprobs"`
+	TopTokens   []int32   `json:"top_tokens,omitempty"`
+	TopLogprobs []float32 `json:"top_logprobs,omitempty"`
+}
+
+// CancelRequest asks the worker generating req_id to stop
+type CancelRequest struct {
+	ReqID string `json:"req_id"`
+}
+
+// ScoreRequest asks for the log-likelihood of candidate continuations of a prompt
+type ScoreRequest struct {
+	ReqID      string   `json:"req_id"`
+	Input      string   `json:"input"`
+	Candidates []string `json:"candidates"`
+	ReplyTo    string   `json:"reply_to,omitempty"`
+}
+
+// CandidateScore is the log-likelihood of one candidate
+type CandidateScore struct {
+	Text        string  `json:"text"`
+	Tokens      int     `json:"tokens"`
+	Logprob     float64 `json:"logprob"`
+	MeanLogprob float64 `json:"mean_logprob"`
+}
+
+// ScoreResponse represents scored candidates, Best indexes the most likely one
+type ScoreResponse struct {
+	ReqID        string           `json:"req_id"`
+	Candidates   []CandidateScore `json:"candidates"`
+	Best         int              `json:"best"`
+	Text         string           `json:"text"`
+	TokensIn     int              `json:"tokens_in"`
+	TokensScored int              `json:"tokens_scored"`
+	DurationMs   int64            `json:"duration_ms"`
+	Error        string           `json:"error,omitempty"`
 }
 
 // EmbeddingRequest represents a request for embeddings
@@ -35,6 +98,9 @@ type EmbeddingData struct {
 	Object    string    `json:"object"`
 	Embedding []float32 `json:"embedding"`
 	Index     int       `json:"index"`
+	Chunk     int       `json:"chunk,omitempty"`
+	Span      []int     `json:"span,omitempty"`
+	TokenSpan []int     `json:"token_span,omitempty"`
 }
 
 // EmbeddingResponse represents embeddings response
@@ -48,8 +114,79 @@ type EmbeddingResponse struct {
 
 // EmbeddingUsage represents token usage
 type EmbeddingUsage struct {
-	PromptTokens int `json:"prompt_tokens"`
-	TotalTokens  int `json:"total_tokens"`
+	PromptTokens  int `json:"prompt_tokens"`
+	TotalTokens   int `json:"total_tokens"`
+	ChunkedInputs int `json:"chunked_inputs,omitempty"`
+	Chunks        int `json:"chunks,omitempty"`
+}
+
+// RerankRequest represents a request to order documents by relevance to a query
+type RerankRequest struct {
+	ReqID           string   `json:"req_id"`
+	Query           string   `json:"query"`
+	Documents       []string `json:"documents"`
+	TopN            int      `json:"top_n,omitempty"`
+	ReturnDocuments bool     `json:"return_documents,omitempty"`
+	Model           string   `json:"model"`
+	ReplyTo         string   `json:"reply_to,omitempty"`
+}
+
+// RerankResult represents the relevance of one document, Index is its request position
+type RerankResult struct {
+	Index    int     `json:"index"`
+	Score    float64 `json:"relevance_score"`
+	Document string  `json:"document,omitempty"`
+}
+
+// RerankResponse represents reranked documents, best first
+type RerankResponse struct {
+	ReqID      string         `json:"req_id"`
+	Results    []RerankResult `json:"results"`
+	Model      string         `json:"model"`
+	Usage      EmbeddingUsage `json:"usage"`
+	DurationMs int64          `json:"duration_ms"`
+	Error      string         `json:"error,omitempty"`
+}
+
+// IndexDocument is a document stored in a vector index collection
+type IndexDocument struct {
+	ID       string            `json:"id"`
+	Text     string            `json:"text,omitempty"`
+	Metadata map[string]string `json:"metadata,omitempty"`
+}
+
+// IndexUpsertRequest adds documents to a collection, embedding their text
+type IndexUpsertRequest struct {
+	ReqID      string          `json:"req_id"`
+	Collection string          `json:"collection"`
+	Documents  []IndexDocument `json:"documents"`
+}
+
+// IndexSearchRequest finds the documents most similar to a query
+type IndexSearchRequest struct {
+	ReqID      string `json:"req_id"`
+	Collection string `json:"collection"`
+	Query      string `json:"query"`
+	TopK       int    `json:"top_k,omitempty"`
+	Ef         int    `json:"ef,omitempty"`
+}
+
+// IndexHit is a search result with its cosine similarity to the query
+type IndexHit struct {
+	IndexDocument
+	Score float32 `json:"score"`
+}
+
+// IndexResponse represents the result of an index upsert or search
+type IndexResponse struct {
+	ReqID      string         `json:"req_id"`
+	Collection string         `json:"collection"`
+	Upserted   int            `json:"upserted,omitempty"`
+	Count      int            `json:"count"`
+	Hits       []IndexHit     `json:"hits,omitempty"`
+	Usage      EmbeddingUsage `json:"usage"`
+	DurationMs int64          `json:"duration_ms"`
+	Error      string         `json:"error,omitempty"`
 }
 
 // HealthStatus represents model health information
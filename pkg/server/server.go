@@ -17,6 +17,7 @@ type Server struct {
 	inferenceService *services.InferenceService
 	embeddingService *services.EmbeddingService
 	audioService     *services.AudioService
+	indexService     *services.IndexService
 	grammarService   *services.GrammarService
 	repo             repository.Repository
 	llm              interface{}
@@ -88,7 +89,7 @@ func (s *Server) Start(ctx context.Context) error {
 		case capabilities.CapabilityTextGeneration:
 			inferenceHandler := handlers.NewInferenceHandler(s.inferenceService)
 			inferenceHandler.RegisterRoutes(mux)
-			slog.Info("Registered text generation endpoints", "endpoints", []string{"/v1/completions", "/healthz", "/logs"})
+			slog.Info("Registered text generation endpoints", "endpoints", []string{"/v1/completions", "/v1/chat/completions", "/v1/score", "/v1/cache/stats", "/healthz", "/logs"})
 			endpointsRegistered++
 			
 		case capabilities.CapabilityEmbeddings:
@@ -102,10 +103,27 @@ func (s *Server) Start(ctx context.Context) error {
 					slog.Info("Registered embedding endpoints", "endpoints", []string{"/v1/embeddings"})
 				}
 				endpointsRegistered++
+				
+				if s.indexService != nil {
+					indexHandler := handlers.NewIndexHandler(s.indexService)
+					indexHandler.RegisterRoutes(mux)
+					slog.Info("Registered vector index endpoints", "endpoints", []string{"/v1/index/upsert", "/v1/index/search"})
+				}
 			} else {
 				slog.Info("Embedding capability detected but no compatible model available")
 			}
 			
+		case capabilities.CapabilityRerank:
+			if llamaModel, ok := s.llm.(*llama.Model); ok {
+				if s.embeddingService == nil {
+					s.embeddingService = services.NewEmbeddingService(llamaModel, s.inferenceService.GetRepository())
+				}
+				rerankHandler := handlers.NewRerankHandler(s.embeddingService)
+				rerankHandler.RegisterRoutes(mux)
+				slog.Info("Registered rerank endpoints", "endpoints", []string{"/v1/rerank"})
+				endpointsRegistered++
+			}
+			
 		case capabilities.CapabilityGrammarConstrained:
 			grammarHandler := handlers.NewGrammarHandler(s.grammarService)
 			grammarHandler.RegisterRoutes(mux)
@@ -159,4 +177,8 @@ func (s *Server) Start(ctx context.Context) error {
 
 func (s *Server) SetAudioService(audioService *services.AudioService) {
 	s.audioService = audioService
+}
+
+func (s *Server) SetIndexService(indexService *services.IndexService) {
+	s.indexService = indexService
 }
\ No newline at end of file
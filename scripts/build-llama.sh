@@ -2,12 +2,21 @@
 set -e
 
 # Build script for llama.cpp with various acceleration backends
-# Usage: ./build-llama.sh [cpu|metal|cuda|rocm|vulkan]
+# Usage: ./build-llama.sh [cpu|cpu-variants|metal|cuda|rocm|vulkan]
+#
+# cpu-variants builds shared libraries with one CPU backend per x86-64 level
+# (x86-64-v2/v3/v4 and newer), loaded at runtime by the ggml_dl build tag. They go to
+# internal/llama/ggml_dl so the static libraries of the other builds stay in place.
 
 BUILD_TYPE=${1:-cpu}
 LLAMA_DIR="llama.cpp"
 BUILD_DIR="build"
 TARGET_DIR="internal/llama"
+LIB_SUBDIR="."
+if [ "$BUILD_TYPE" = "cpu-variants" ]; then
+    LIB_SUBDIR="ggml_dl"
+fi
+LIB_DIR="$TARGET_DIR/$LIB_SUBDIR"
 CACHE_DIR=".build_cache"
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 
@@ -30,7 +39,12 @@ cd ..
 
 # Check if we have a cached build
 CACHE_FILE="$CACHE_DIR/${BUILD_TYPE}_${CURRENT_COMMIT}"
-if [ -f "$CACHE_FILE" ] && [ -f "$TARGET_DIR/libllama.a" ]; then
+if [ "$BUILD_TYPE" = "cpu-variants" ]; then
+    LLAMA_LIB="libllama.so"
+else
+    LLAMA_LIB="libllama.a"
+fi
+if [ -f "$CACHE_FILE" ] && [ -f "$LIB_DIR/$LLAMA_LIB" ]; then
     echo "Found cached build for commit $CURRENT_COMMIT ($BUILD_TYPE)"
     if [ "$CURRENT_TAG" != "" ]; then
         echo "Tagged release: $CURRENT_TAG"
@@ -86,6 +100,16 @@ case "$BUILD_TYPE" in
             -DGGML_NATIVE=ON \
             -DBUILD_SHARED_LIBS=OFF
         ;;
+    "cpu-variants")
+        echo "Configuring for CPU with runtime variant selection..."
+        cmake -B "$BUILD_DIR" \
+            -DCMAKE_BUILD_TYPE=Release \
+            -DGGML_NATIVE=OFF \
+            -DGGML_BACKEND_DL=ON \
+            -DGGML_CPU_ALL_VARIANTS=ON \
+            -DGGML_LTO=ON \
+            -DBUILD_SHARED_LIBS=ON
+        ;;
     "cpu"|*)
         echo "Configuring for CPU only..."
         cmake -B "$BUILD_DIR" \
@@ -102,19 +126,25 @@ cmake --build "$BUILD_DIR" --config Release -j"$NCPU"
 
 # Create target directory
 cd ..
-mkdir -p "$TARGET_DIR"
+mkdir -p "$TARGET_DIR" "$LIB_DIR"
 
 # Copy libraries
 echo "Copying libraries..."
-cp "$LLAMA_DIR/$BUILD_DIR/src/libllama.a" "$TARGET_DIR/"
-cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/libggml.a" "$TARGET_DIR/"
-cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/libggml-base.a" "$TARGET_DIR/"
-cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/libggml-cpu.a" "$TARGET_DIR/"
-if [ -f "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-blas/libggml-blas.a" ]; then
-    cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-blas/libggml-blas.a" "$TARGET_DIR/"
-fi
-if [ -f "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-metal/libggml-metal.a" ]; then
-    cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-metal/libggml-metal.a" "$TARGET_DIR/"
+if [ "$BUILD_TYPE" = "cpu-variants" ]; then
+    # libllama, libggml, libggml-base and every libggml-cpu-<variant>
+    rm -f "$LIB_DIR"/*.so
+    cp "$LLAMA_DIR/$BUILD_DIR/bin/"*.so "$LIB_DIR/"
+else
+    cp "$LLAMA_DIR/$BUILD_DIR/src/libllama.a" "$TARGET_DIR/"
+    cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/libggml.a" "$TARGET_DIR/"
+    cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/libggml-base.a" "$TARGET_DIR/"
+    cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/libggml-cpu.a" "$TARGET_DIR/"
+    if [ -f "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-blas/libggml-blas.a" ]; then
+        cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-blas/libggml-blas.a" "$TARGET_DIR/"
+    fi
+    if [ -f "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-metal/libggml-metal.a" ]; then
+        cp "$LLAMA_DIR/$BUILD_DIR/ggml/src/ggml-metal/libggml-metal.a" "$TARGET_DIR/"
+    fi
 fi
 
 # Copy headers
@@ -134,16 +164,20 @@ echo "Building custom binding..."
 cd "$TARGET_DIR"
 
 # Compile binding
-c++ -O3 -DNDEBUG -std=c++11 -fPIC -c binding.cpp \
+BINDING_FLAGS=""
+if [ "$BUILD_TYPE" = "cpu-variants" ]; then
+    BINDING_FLAGS="-DGGML_BACKEND_DL"
+fi
+c++ -O3 -DNDEBUG -std=c++17 -fPIC $BINDING_FLAGS -c binding.cpp \
     -I./include \
     -I./src \
     -I./ggml_include
 
 # Create binding library
-ar rcs libbinding.a binding.o
+ar rcs "$LIB_SUBDIR/libbinding.a" binding.o
 
 # Create build info
-echo "{\"build_type\":\"$BUILD_TYPE\",\"build_time\":\"$(date -u +%Y-%m-%dT%H:%M:%SZ)\",\"commit\":\"$CURRENT_COMMIT\",\"tag\":\"$CURRENT_TAG\",\"gpu_support\":true}" > build_info.json
+echo "{\"build_type\":\"$BUILD_TYPE\",\"build_time\":\"$(date -u +%Y-%m-%dT%H:%M:%SZ)\",\"commit\":\"$CURRENT_COMMIT\",\"tag\":\"$CURRENT_TAG\",\"gpu_support\":true}" > "$LIB_SUBDIR/build_info.json"
 
 # Create cache marker
 mkdir -p "../$CACHE_DIR"
@@ -155,6 +189,10 @@ echo "Commit: $CURRENT_COMMIT"
 if [ "$CURRENT_TAG" != "" ]; then
     echo "Tag: $CURRENT_TAG"
 fi
-echo "Libraries: libllama.a, libggml.a, libbinding.a"
-echo "Target: $TARGET_DIR"
+if [ "$BUILD_TYPE" = "cpu-variants" ]; then
+    echo "Libraries: libllama.so, libggml.so, libggml-cpu-*.so, libbinding.a"
+else
+    echo "Libraries: libllama.a, libggml.a, libbinding.a"
+fi
+echo "Target: $LIB_DIR"
 echo "Cached: $CACHE_FILE"
\ No newline at end of file